@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2018 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BATCH_PLANNER_H
+#define BATCH_PLANNER_H
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <ros/ros.h>
+#include <xmlrpcpp/XmlRpcValue.h>
+
+#include <moveit/planning_pipeline/planning_pipeline.h>
+#include <moveit/planning_scene/planning_scene.h>
+#include <moveit/robot_model/robot_model.h>
+
+#include "pilz_msgs/MotionSequenceRequest.h"
+#include "pilz_msgs/MotionSequenceResponse.h"
+#include "pilz_trajectory_generation/command_list_manager.h"
+#include "pilz_trajectory_generation/trajectory_generation_exceptions.h"
+
+namespace pilz_trajectory_generation
+{
+
+CREATE_MOVEIT_ERROR_CODE_EXCEPTION(InvalidSequenceDescription, moveit_msgs::MoveItErrorCodes::INVALID_MOTION_PLAN);
+
+/**
+ * @brief Plans batches of motion sequences offline (without a move_group) in parallel.
+ *
+ * Each thread plans with its own CommandListManager against the same planning scene,
+ * which contains the default state of the robot model. The limits are read once from the
+ * parameter server and shared by all threads (see pilz::LimitsAggregator).
+ */
+class BatchPlanner
+{
+public:
+  /**
+   * @param nh node handle to read the parameters of the planning pipeline ("planning_plugin")
+   * and of the CommandListManager from
+   * @param model robot model to plan for
+   * @param num_threads number of sequences planned in parallel (at least one), more than one requires
+   * that the planners and the IK solvers of the planning groups support concurrent calls
+   */
+  BatchPlanner(const ros::NodeHandle& nh,
+               const robot_model::RobotModelConstPtr& model,
+               const std::size_t num_threads);
+
+  /**
+   * @brief Plans the specified sequences.
+   *
+   * The responses are in the order of the sequences. Failures are reported by the error
+   * code of the response, the planning time of a response is the planning latency (wall time) of the sequence.
+   * With several threads the latency includes the time the sequence waited for the CPU.
+   */
+  std::vector<pilz_msgs::MotionSequenceResponse> plan(const std::vector<pilz_msgs::MotionSequenceRequest>& sequences);
+
+  /**
+   * @brief Converts the list of sequences (usually loaded from a YAML file) into sequence requests.
+   *
+   * Each sequence is a list of items with the following members:
+   *   - planner_id, group_name: like in the MotionPlanRequest
+   *   - blend_radius (optional, default 0)
+   *   - velocity_scaling, acceleration_scaling (optional, default 1)
+   *   - start_joints (optional): start positions of the joints of the group
+   *   - either joints: goal positions of the joints of the group,
+   *     or pose: goal pose [x, y, z, qx, qy, qz, qw] of link_name in the model frame
+   *   - center or interim (CIRC only): auxiliary point [x, y, z]
+   *   - waypoints (SPLINE only): list of waypoint poses [x, y, z, qx, qy, qz, qw]
+   *
+   * @throw InvalidSequenceDescription if a sequence does not follow the format above.
+   */
+  static std::vector<pilz_msgs::MotionSequenceRequest> readSequences(XmlRpc::XmlRpcValue& sequences,
+                                                                     const robot_model::RobotModelConstPtr& model);
+
+  /**
+   * @brief Reads all pilz_msgs/MotionSequenceRequest messages of the specified bag file in their order.
+   */
+  static std::vector<pilz_msgs::MotionSequenceRequest> readSequencesFromBag(const std::string& file_name);
+
+  /**
+   * @brief Writes the responses to the specified bag file (topic "responses").
+   */
+  static void writeResponsesToBag(const std::string& file_name,
+                                  const std::vector<pilz_msgs::MotionSequenceResponse>& responses);
+
+  /**
+   * @brief Writes the error code, the number of trajectories, the cycle time and the planning latency
+   * of each response as CSV.
+   */
+  static void writeStatistics(std::ostream& os, const std::vector<pilz_msgs::MotionSequenceResponse>& responses);
+
+  /**
+   * @brief Returns the duration of the execution of all trajectories of the response.
+   */
+  static double getCycleTime(const pilz_msgs::MotionSequenceResponse& response);
+
+private:
+  planning_scene::PlanningScenePtr scene_;
+  planning_pipeline::PlanningPipelinePtr pipeline_;
+  std::vector<std::unique_ptr<CommandListManager>> managers_;
+};
+
+}
+
+#endif // BATCH_PLANNER_H
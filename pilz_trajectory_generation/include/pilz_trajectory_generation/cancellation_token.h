@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2018 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CANCELLATION_TOKEN_H
+#define CANCELLATION_TOKEN_H
+
+#include <atomic>
+
+namespace pilz
+{
+
+/**
+ * @brief Thread-safe flag used to cancel a running planning.
+ *
+ * The planning functions check the token between their steps (e.g. each
+ * sample of a trajectory) and stop with moveit_msgs::MoveItErrorCodes::PREEMPTED
+ * as soon as the token is cancelled.
+ */
+class CancellationToken
+{
+public:
+  void cancel();
+  void reset();
+  bool isCancelled() const;
+
+private:
+  std::atomic_bool cancelled_ {false};
+};
+
+/**
+ * @return TRUE if a token is given and the token is cancelled, otherwise FALSE.
+ */
+inline bool isCancelled(const CancellationToken* token)
+{
+  return token && token->isCancelled();
+}
+
+inline void CancellationToken::cancel()
+{
+  cancelled_ = true;
+}
+
+inline void CancellationToken::reset()
+{
+  cancelled_ = false;
+}
+
+inline bool CancellationToken::isCancelled() const
+{
+  return cancelled_;
+}
+
+}
+
+#endif // CANCELLATION_TOKEN_H
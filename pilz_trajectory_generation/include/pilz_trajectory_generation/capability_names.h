@@ -24,6 +24,7 @@ namespace pilz_trajectory_generation
 {
 
 static const std::string SEQUENCE_SERVICE_NAME = "plan_sequence_path";
+static const std::string SEQUENCE_BATCH_SERVICE_NAME = "plan_sequence_path_batch";
 
 }
 
@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2018 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CARTESIAN_PATH_H
+#define CARTESIAN_PATH_H
+
+#include <array>
+#include <vector>
+
+#include <Eigen/Geometry>
+#include <Eigen/StdVector>
+
+namespace pilz {
+
+//! Contiguous buffer of sampled Cartesian poses.
+using PoseBuffer = std::vector<Eigen::Isometry3d, Eigen::aligned_allocator<Eigen::Isometry3d> >;
+
+/**
+ * @brief Rotation around a fixed axis from a start to a goal orientation (along the shorter way).
+ */
+class SingleAxisRotation
+{
+public:
+  SingleAxisRotation(const Eigen::Quaterniond& start_orientation,
+                     const Eigen::Quaterniond& goal_orientation);
+
+  //! Returns the rotation angle from the start to the goal orientation (0 <= angle <= pi).
+  double getAngle() const;
+
+  //! Returns the orientation after rotating the start orientation by the specified angle (limited to getAngle()).
+  Eigen::Quaterniond getOrientation(const double angle) const;
+
+private:
+  Eigen::Quaternion<double, Eigen::DontAlign> start_orientation_;
+  //! Rotation axis relative to the start orientation.
+  Eigen::Vector3d axis_ {Eigen::Vector3d::UnitX()};
+  double angle_ {0.};
+};
+
+/**
+ * @brief Cartesian path, parametrized like KDL::Path: The slower of translational and rotational motion
+ * determines the path length, the rotation is converted into a translation via the equivalent radius.
+ */
+class CartesianPath
+{
+public:
+  virtual ~CartesianPath() = default;
+
+  double getLength() const;
+
+  //! Returns the pose at the specified path parameter (0 <= s <= getLength()).
+  Eigen::Isometry3d getPose(const double s) const;
+
+  /**
+   * @brief Evaluates the poses at all specified path parameters.
+   *
+   * @param poses Resized to the number of path parameters.
+   */
+  virtual void getPoses(const std::vector<double>& path_params, PoseBuffer& poses) const = 0;
+
+protected:
+  double path_length_ {0.};
+};
+
+/**
+ * @brief Path between two poses, the orientation is interpolated by a single axis rotation.
+ */
+class CartesianPathSegment : public CartesianPath
+{
+public:
+  virtual void getPoses(const std::vector<double>& path_params, PoseBuffer& poses) const override final;
+
+protected:
+  CartesianPathSegment(const Eigen::Quaterniond& start_orientation,
+                       const Eigen::Quaterniond& goal_orientation);
+
+  /**
+   * @brief Sets the path length and the scaling of the path parameter.
+   *
+   * @param distance Length of the translational motion.
+   * @param eqradius Equivalent radius to compare rotational and translational motion.
+   */
+  void setScaling(const double distance, const double eqradius);
+
+  //! Returns the distance along the translational motion at the specified path parameter.
+  double toDistance(const double s) const;
+
+  //! Sets the translation of each pose to the position at the respective path parameter.
+  virtual void setPositions(const std::vector<double>& path_params, PoseBuffer& poses) const = 0;
+
+private:
+  SingleAxisRotation rotation_;
+  //! Scaling of the path parameter to the rotation angle.
+  double scale_rot_ {1.};
+  //! Scaling of the path parameter to the translational distance.
+  double scale_lin_ {1.};
+};
+
+/**
+ * @brief Straight line from the start to the goal pose.
+ */
+class CartesianPathLine : public CartesianPathSegment
+{
+public:
+  /**
+   * @param eqradius Equivalent radius to compare rotational and translational motion.
+   */
+  CartesianPathLine(const Eigen::Isometry3d& start_pose,
+                    const Eigen::Isometry3d& goal_pose,
+                    const double eqradius);
+
+private:
+  virtual void setPositions(const std::vector<double>& path_params, PoseBuffer& poses) const override;
+
+private:
+  Eigen::Vector3d start_position_;
+  //! Unit vector from start to goal (zero if both positions are equal).
+  Eigen::Vector3d direction_ {Eigen::Vector3d::Zero()};
+};
+
+/**
+ * @brief Arc around a center point.
+ */
+class CartesianPathCircle : public CartesianPathSegment
+{
+public:
+  /**
+   * @param start_pose start of the path
+   * @param center_point center of the circle
+   * @param aux_point point in the plane of the circle (not colinear with start and center),
+   * the path moves from the start in the direction of this point
+   * @param goal_orientation orientation at the end of the path
+   * @param alpha rotation angle of the path around the center
+   * @param eqradius equivalent radius to compare rotational and translational motion
+   * @param tolerance minimal radius and minimal norm of the plane normal
+   *
+   * @throws KDL::Error_MotionPlanning_Circle_ToSmall if the radius is smaller than the tolerance.
+   * @throws KDL::Error_MotionPlanning_Circle_No_Plane if start, center and auxiliary point are colinear.
+   */
+  CartesianPathCircle(const Eigen::Isometry3d& start_pose,
+                      const Eigen::Vector3d& center_point,
+                      const Eigen::Vector3d& aux_point,
+                      const Eigen::Quaterniond& goal_orientation,
+                      const double alpha,
+                      const double eqradius,
+                      const double tolerance);
+
+private:
+  virtual void setPositions(const std::vector<double>& path_params, PoseBuffer& poses) const override;
+
+private:
+  Eigen::Vector3d center_;
+  //! Unit vector from the center to the start.
+  Eigen::Vector3d x_axis_;
+  //! Unit vector in the plane of the circle, perpendicular to x_axis_ in the direction of motion.
+  Eigen::Vector3d y_axis_;
+  double radius_;
+};
+
+/**
+ * @brief Smooth path through a sequence of poses.
+ *
+ * The positions are interpolated by a natural cubic spline, which is parametrized by the distances
+ * between consecutive positions. The orientation between two consecutive poses is interpolated
+ * by a single axis rotation. The length of each section between two poses is determined like
+ * for a CartesianPathSegment.
+ */
+class CartesianPathSpline : public CartesianPath
+{
+public:
+  /**
+   * @param poses poses the path passes through, including start and goal
+   * @param eqradius equivalent radius to compare rotational and translational motion
+   * @param tolerance minimal distance between consecutive positions
+   *
+   * @throws std::invalid_argument if less than two poses are given or if consecutive positions
+   * are closer than the tolerance.
+   */
+  CartesianPathSpline(const PoseBuffer& poses,
+                      const double eqradius,
+                      const double tolerance);
+
+  virtual void getPoses(const std::vector<double>& path_params, PoseBuffer& poses) const override;
+
+  //! Returns the maximal curvature of the translational path.
+  double getMaxCurvature() const;
+
+private:
+  //! Section of the path between two consecutive poses.
+  struct Section
+  {
+    //! Start of the section on the path.
+    double start;
+    double scale_rot;
+    double scale_lin;
+    //! Polynomial coefficients of the position over the spline parameter (in ascending order).
+    std::array<Eigen::Vector3d, 4> coefficients;
+    //! Range of the spline parameter.
+    double parameter_range;
+    //! Distance along the curve at equally spaced values of the spline parameter.
+    std::vector<double> arc_lengths;
+    SingleAxisRotation rotation;
+  };
+
+private:
+  Eigen::Vector3d getPosition(const Section& section, const double u) const;
+  Eigen::Vector3d getFirstDerivative(const Section& section, const double u) const;
+  Eigen::Vector3d getSecondDerivative(const Section& section, const double u) const;
+
+  //! Returns the spline parameter at the specified distance along the curve of the section.
+  double toSplineParameter(const Section& section, const double distance) const;
+
+private:
+  std::vector<Section> sections_;
+  double max_curvature_ {0.};
+
+  //! Number of intervals used to approximate the arc length of a section.
+  static constexpr std::size_t NUM_ARC_LENGTH_INTERVALS {64};
+};
+
+inline double SingleAxisRotation::getAngle() const
+{
+  return angle_;
+}
+
+inline double CartesianPath::getLength() const
+{
+  return path_length_;
+}
+
+inline double CartesianPathSegment::toDistance(const double s) const
+{
+  return s * scale_lin_;
+}
+
+inline double CartesianPathSpline::getMaxCurvature() const
+{
+  return max_curvature_;
+}
+
+} // namespace pilz
+
+#endif // CARTESIAN_PATH_H
@@ -17,7 +17,12 @@
 #ifndef COMMAND_LIST_MANAGER_H
 #define COMMAND_LIST_MANAGER_H
 
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <boost/optional.hpp>
 
@@ -28,6 +33,8 @@
 #include "pilz_msgs/MotionSequenceRequest.h"
 #include "pilz_trajectory_generation/trajectory_blender.h"
 #include "pilz_trajectory_generation/plan_components_builder.h"
+#include "pilz_trajectory_generation/joint_limits_container.h"
+#include "pilz_trajectory_generation/sequence_cache.h"
 #include "pilz_trajectory_generation/trajectory_generation_exceptions.h"
 
 namespace pilz_trajectory_generation
@@ -48,6 +55,14 @@ CREATE_MOVEIT_ERROR_CODE_EXCEPTION(PlanningPipelineException, moveit_msgs::MoveI
  */
 class CommandListManager
 {
+public:
+  /**
+   * @brief Called after each solved sequence item with the index of the item,
+   * the number of items, the planning time of the item (in seconds) and
+   * whether the result of the item was reused (from a previous planning).
+   */
+  using ProgressCallback = std::function<void(std::size_t, std::size_t, double, bool)>;
+
 public:
   CommandListManager(const ros::NodeHandle& nh, const robot_model::RobotModelConstPtr& model);
 
@@ -68,7 +83,7 @@ public:
    * @param req_list List of motion requests containing: PTP, LIN, CIRC
    * and/or gripper commands.
    * Please note: A request is only valid if:
-   *    - All blending radii are non negative.
+   *    - All blending radii are non negative (or BLEND_RADIUS_MAX).
    *    - The blending radius of the last request is 0.
    *    - Only the first request of each group has a start state.
    *    - Non of the blending radii overlapp each other.
@@ -79,17 +94,87 @@ public:
    * which it belongs to. Starts states can even be incomplete. In this case
    * default values are set for the unset joints.
    *
+   * Please note:
+   * A blending radius of BLEND_RADIUS_MAX is replaced by the largest radius
+   * for which the blend sphere intersects both trajectories and does not
+   * overlap with the neighbouring blend spheres (limited by the parameter
+   * "max_auto_blend_radius").
+   *
+   * Please note:
+   * If the parameter "reuse_sequence_items" is set, the planning results of the
+   * previous call are cached. A sequence item is only planned again if its request
+   * or its (resolved) start state changed. An empty start state is resolved to the
+   * current state of the planning scene. Other changes of the planning scene do not
+   * invalidate the cached results.
+   *
+   * Please note:
+   * If the parameter "sequence_cache_size" is greater than zero, the final
+   * trajectories of the last sequences are cached, too. A cached result is returned
+   * if the request and the planning scene (except for the robot state) are the same.
+   * If one of the start states is taken from the current state, the current state
+   * has to be within the tolerance "sequence_cache_start_state_tolerance" of the
+   * current state the result was planned for.
+   *
+   * Please note:
+   * A positive "allowed_planning_time" of the request list limits the planning
+   * time of the whole sequence. The time left is passed on to each sequence item
+   * (as its allowed planning time) and to the blending. If the time is exceeded,
+   * a MoveItErrorCodeException with the error code TIMED_OUT is thrown.
+   *
+   * Please note:
+   * If the parameter "merge_ptp_sequences" is set, consecutive PTP commands
+   * with a blend radius greater than zero are merged into one joint trajectory
+   * which passes the goals of the commands without stopping (see mergePtpItems()).
+   *
+   * Please note:
+   * If the parameter "speculative_planning" is set, the sequence items are
+   * planned concurrently (see solveSequenceItems()) by at most
+   * "speculative_planning_threads" threads. The result is the same
+   * as the result of the sequential planning.
+   *
    * @return Contains the calculated/generated trajectories.
    */
   RobotTrajCont solve(const planning_scene::PlanningSceneConstPtr& planning_scene,
                       const planning_pipeline::PlanningPipelinePtr& planning_pipeline,
                       const pilz_msgs::MotionSequenceRequest& req_list);
 
+  /**
+   * @return The number of hits and misses of the sequence cache (zero if the cache is disabled).
+   */
+  SequenceCache::Statistics getSequenceCacheStatistics() const;
+
+  /**
+   * @brief Sets the callback which is called after each solved sequence item
+   * (an empty callback disables the notification).
+   */
+  void setProgressCallback(const ProgressCallback& callback);
+
+  /**
+   * @brief Sets the token which cancels a running solve() with a
+   * PlanningCancelledException. The token is checked between the sequence
+   * items and during the blending. The token has to outlive the manager.
+   *
+   * @note A sequence item which is already planned is only stopped by terminate().
+   */
+  void setCancellationToken(const pilz::CancellationToken* cancellation_token);
+
+  /**
+   * @brief Terminates the planning contexts of the sequence items which are currently
+   * planned by solve() of this manager, thread-safe.
+   *
+   * Call it after cancelling the token set by setCancellationToken(). The planning of
+   * other managers and other users of the planning pipeline is not affected.
+   */
+  void terminate() const;
+
 private:
   using MotionResponseCont = std::vector<planning_interface::MotionPlanResponse>;
   using RobotState_OptRef = boost::optional<const robot_state::RobotState& >;
   using RadiiCont = std::vector<double>;
-  using GroupNamesCont = std::vector<std::string>;
+  //! Last trajectory of each group (giving access to the end state of the group).
+  using GroupTrajCont = std::unordered_map<std::string, robot_trajectory::RobotTrajectoryPtr>;
+  //! Planning results accessed via the serialized request (including the start state).
+  using ResponseCache = std::unordered_map<std::string, planning_interface::MotionPlanResponse>;
 
 private:
   /**
@@ -104,14 +189,82 @@ private:
   /**
    * @brief Solve each sequence item individually.
    *
+   * Items whose request (including the resolved start state) was already solved
+   * by the previous call or earlier in this call are taken from the cache.
+   *
+   * If speculative planning is enabled, the items are first planned concurrently
+   * (see planSpeculatively()). A speculative result is only used if its request
+   * equals the request with the resolved start state, otherwise the item is
+   * planned again.
+   *
    * @param planning_scene The planning_scene to be used for trajectory generation.
    * @param req_list Container of requests for calculation/generation.
+   * @param deadline Deadline of the sequence (zero: no deadline), see limitPlanningTime().
    *
    * @return Container of generated trajectories.
    */
   MotionResponseCont solveSequenceItems(const planning_scene::PlanningSceneConstPtr& planning_scene,
                                         const planning_pipeline::PlanningPipelinePtr& planning_pipeline,
-                                        const pilz_msgs::MotionSequenceRequest &req_list) const;
+                                        const pilz_msgs::MotionSequenceRequest &req_list,
+                                        const ros::Time& deadline);
+
+  /**
+   * @brief Plans the sequence items concurrently.
+   *
+   * The start state of an item is predicted by the end state of the previous
+   * item of the same group (see predictEndState()). Items for which
+   * no start state can be predicted are not planned. Failed items are skipped, their
+   * errors are reported by the sequential planning.
+   *
+   * @return The successfully planned results accessed via their (predicted) request.
+   */
+  ResponseCache planSpeculatively(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                                  const planning_pipeline::PlanningPipelinePtr& planning_pipeline,
+                                  const pilz_msgs::MotionSequenceRequest &req_list,
+                                  const ros::Time& deadline) const;
+
+  /**
+   * @brief Limits the allowed planning time of the specified request to the
+   * time left until the deadline of the sequence. The allowed planning time of the
+   * request is kept if it is smaller.
+   *
+   * @return FALSE if the deadline is exceeded, otherwise TRUE.
+   */
+  static bool limitPlanningTime(const ros::Time& deadline, planning_interface::MotionPlanRequest& req);
+
+  /**
+   * @return The end state of the trajectory planned for the specified request,
+   * if it is known without planning, otherwise boost::none. Only the end states of
+   * PTP commands are predicted: The goal of a joint goal, respectively the IK solution
+   * of a Cartesian goal (computed like the PTP generator does).
+   * The end states of LIN and CIRC commands depend on the IK along the path.
+   */
+  boost::optional<moveit_msgs::RobotState> predictEndState(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                                                           const planning_interface::MotionPlanRequest& req) const;
+
+  /**
+   * @brief Replaces each run of consecutive PTP commands, which are blended with each
+   * other, by one trajectory passing the goals of the commands as via points
+   * (see pilz::generateViaPointTrajectory()).
+   *
+   * The blend radius of the merged trajectory is the blend radius of the last command
+   * of the run. If the merging fails, the commands are kept (and blended).
+   *
+   * @param resp_cont Container of calculated/generated trajectories, replaced by the merged trajectories.
+   * @param radii Container stating the blend radii, replaced by the radii of the merged trajectories.
+   */
+  void mergePtpItems(const pilz_msgs::MotionSequenceRequest& req_list,
+                     MotionResponseCont& resp_cont,
+                     RadiiCont& radii) const;
+
+  /**
+   * @return The trajectory passing the goals of the sequence items "first" to "last",
+   * or nullptr if the trajectory could not be generated.
+   */
+  robot_trajectory::RobotTrajectoryPtr mergeTrajectories(const pilz_msgs::MotionSequenceRequest& req_list,
+                                                         const MotionResponseCont& resp_cont,
+                                                         const std::size_t first,
+                                                         const std::size_t last) const;
 
   /**
    * @return TRUE if the blending radii of specified trajectories overlap,
@@ -123,19 +276,42 @@ private:
                             const robot_trajectory::RobotTrajectory& traj_B,
                             const double radii_B) const;
 
+  /**
+   * @brief Replaces each blend radius of BLEND_RADIUS_MAX by the largest
+   * blend radius which is allowed at the corresponding junction.
+   *
+   * The radius is limited by:
+   * - the distances of the waypoints of both trajectories to the junction
+   * (the blend sphere has to intersect both trajectories),
+   * - the distances to the neighbouring junctions minus their blend radii
+   * (if both neighbouring radii are BLEND_RADIUS_MAX, the distance is split equally),
+   * - the parameter "max_auto_blend_radius".
+   *
+   * @param resp_cont Container of calculated/generated trajectories.
+   * @param radii Container stating the blend radii.
+   */
+  void setMaximalBlendRadii(const MotionResponseCont& resp_cont,
+                            RadiiCont &radii) const;
+
+  /**
+   * @return The tip frame of the planning group of the specified trajectory
+   * (the frame used for blending).
+   */
+  const std::string& getBlendFrame(const robot_trajectory::RobotTrajectory& traj) const;
+
 private:
   /**
-   * @return The last RobotState of the specified group which can
-   * be found in the specified vector.
+   * @return The end state of the specified group stored in the specified
+   * container of last trajectories.
    */
-  static RobotState_OptRef getPreviousEndState(const MotionResponseCont &motion_plan_responses,
+  static RobotState_OptRef getPreviousEndState(const GroupTrajCont& last_trajs,
                                                const std::string &group_name);
 
   /**
    * @brief Set start state to end state of previous calculated trajectory
    * from group.
    */
-  static void setStartState(const MotionResponseCont &motion_plan_responses,
+  static void setStartState(const GroupTrajCont& last_trajs,
                             const std::string &group_name,
                             moveit_msgs::RobotState& start_state);
 
@@ -161,33 +337,58 @@ private:
                                   const pilz_msgs::MotionSequenceItem& item_B);
 
   /**
-   * @brief Checks that all blend radii are greater or equal to zero.
+   * @return The largest distance between the specified position and the
+   * specified frame along the trajectory.
    */
-  static void checkForNegativeRadii(const pilz_msgs::MotionSequenceRequest &req_list);
+  static double getMaximalDistance(const robot_trajectory::RobotTrajectory& traj,
+                                   const std::string& frame,
+                                   const Eigen::Vector3d& position);
+
+  void notifyProgress(const std::size_t index, const std::size_t num_items,
+                      const double planning_time, const bool reused) const;
 
   /**
-   * @brief Checks that last blend radius is zero.
+   * @brief Solves the specified request with a planning context of the planner of the pipeline.
+   *
+   * The context is obtained directly from the planner (request adapters of the pipeline are
+   * not applied), so that terminate() stops only the contexts of this manager.
    */
-  static void checkLastBlendRadiusZero(const pilz_msgs::MotionSequenceRequest &req_list);
+  void solveRequest(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                    const planning_pipeline::PlanningPipelinePtr& planning_pipeline,
+                    const planning_interface::MotionPlanRequest& req,
+                    planning_interface::MotionPlanResponse& res) const;
 
   /**
-   * @brief Checks that only the first request of the specified group has
-   * a start state in the specified request list.
+   * @return The key of the specified request and planning scene in the sequence cache.
+   *
+   * The key contains a fingerprint of the planning scene (object ids, poses and
+   * primitive dimensions) instead of the serialized geometry.
    */
-  static void checkStartStatesOfGroup(const pilz_msgs::MotionSequenceRequest &req_list,
-                                      const std::string& group_name);
+  static std::string getSequenceKey(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                                    const pilz_msgs::MotionSequenceRequest& req_list);
 
   /**
-   * @brief Checks that each group in the specified request list has only
-   * one start state.
+   * @return The positions of the current state, if it is used as start state of a
+   * group (because no start state is given), otherwise an empty container.
    */
-  static void checkStartStates(const pilz_msgs::MotionSequenceRequest &req_list);
+  static std::vector<double> getResolvedStartPositions(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                                                       const pilz_msgs::MotionSequenceRequest& req_list);
 
   /**
-   * @return Returns all group names which are present in the specified
-   * request.
+   * @brief Checks that all blend radii are greater or equal to zero (or BLEND_RADIUS_MAX).
    */
-  static GroupNamesCont getGroupNames(const pilz_msgs::MotionSequenceRequest &req_list);
+  static void checkForNegativeRadii(const pilz_msgs::MotionSequenceRequest &req_list);
+
+  /**
+   * @brief Checks that last blend radius is zero.
+   */
+  static void checkLastBlendRadiusZero(const pilz_msgs::MotionSequenceRequest &req_list);
+
+  /**
+   * @brief Checks that only the first request of each group has a start
+   * state in the specified request list.
+   */
+  static void checkStartStates(const pilz_msgs::MotionSequenceRequest &req_list);
 
 private:
   //! Node handle
@@ -199,8 +400,59 @@ private:
   //! @brief Builder to construct the container containing the final
   //! trajectories.
   PlanComponentsBuilder plan_comp_builder_;
+
+  //! Planning results of the sequence items of the previous call (only filled if enabled).
+  ResponseCache response_cache_;
+
+  //! Reuse the planning results of the previous call.
+  bool reuse_sequence_items_ {false};
+
+  //! Upper limit for blend radii of BLEND_RADIUS_MAX.
+  double max_auto_blend_radius_;
+
+  //! Plan the sequence items concurrently based on predicted start states.
+  bool speculative_planning_ {false};
+
+  //! Maximal number of threads of the speculative planning.
+  std::size_t speculative_planning_threads_;
+
+  //! Merge consecutive blended PTP commands into one trajectory.
+  bool merge_ptp_sequences_ {false};
+
+  //! Joint limits of the active joints (used to merge PTP commands).
+  pilz::JointLimitsContainer joint_limits_;
+
+  //! Final trajectories of the last sequences (only set if enabled).
+  std::unique_ptr<SequenceCache> sequence_cache_;
+
+  //! Notified after each solved sequence item.
+  ProgressCallback progress_callback_;
+
+  //! Optional token to cancel the planning.
+  const pilz::CancellationToken* cancellation_token_ {nullptr};
+
+  //! Planning contexts of the sequence items which are currently planned.
+  mutable std::vector<planning_interface::PlanningContextPtr> active_contexts_;
+
+  //! Protects the active contexts.
+  mutable std::mutex active_contexts_mutex_;
+
+private:
+  //! Scaling applied to the maximal blend radius, to stay strictly inside the limits.
+  static constexpr double MAX_BLEND_RADIUS_SCALING = 0.99;
 };
 
+inline void CommandListManager::setProgressCallback(const ProgressCallback& callback)
+{
+  progress_callback_ = callback;
+}
+
+inline void CommandListManager::setCancellationToken(const pilz::CancellationToken* cancellation_token)
+{
+  cancellation_token_ = cancellation_token;
+  plan_comp_builder_.setCancellationToken(cancellation_token);
+}
+
 inline void CommandListManager::checkLastBlendRadiusZero(const pilz_msgs::MotionSequenceRequest &req_list)
 {
   if(req_list.items.back().blend_radius != 0.0)
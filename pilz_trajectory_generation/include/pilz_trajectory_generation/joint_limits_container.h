@@ -21,6 +21,7 @@
 #include "pilz_extensions/joint_limits_extension.h"
 
 #include <map>
+#include <string>
 #include <vector>
 
 namespace pilz
@@ -38,6 +39,7 @@ public:
    * @param joint_limit Limit of the joint
    * @return true if the limit was added, false
    *         if joint_limit.has_deceleration_limit && joint_limit.max_deceleration >= 0
+   *         or if the joint is already limited
    */
   bool addLimit(const std::string& joint_name, pilz_extensions::JointLimit joint_limit);
 
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2018 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIMITS_AGGREGATOR_H
+#define LIMITS_AGGREGATOR_H
+
+#include <memory>
+
+#include <ros/ros.h>
+
+#include <moveit/robot_model/robot_model.h>
+
+#include "pilz_trajectory_generation/limits_container.h"
+
+namespace pilz {
+
+typedef std::shared_ptr<const LimitsContainer> LimitsContainerConstPtr;
+
+/**
+ * @brief Obtains the joint limits of the active joints and the cartesian limits from the parameter server
+ * (see JointLimitsAggregator and CartesianLimitsAggregator).
+ *
+ * The limits are aggregated once per namespace and robot model and shared afterwards, so that
+ * the sequence capabilities of a move_group do not read them again. The command planner reloads
+ * the limits on each initialization, so that changes of the limits on the parameter server
+ * are taken into account by the planner and all users created afterwards.
+ *
+ * The shared limits exist once per process, because the aggregators are only built into the
+ * pilz_trajectory_generation_limits library, which all plugins link.
+ */
+class LimitsAggregator
+{
+  public:
+    /**
+     * @brief Returns the aggregated limits, thread-safe.
+     * @return the shared limits, the same object for all calls until the limits are reloaded
+     * @param nh node handle to access the parameters
+     * @param model robot model whose active joints are limited
+     * @throw AggregationBoundsViolationException if the parameters violate the limits of the robot model
+     */
+    static LimitsContainerConstPtr getAggregatedLimits(const ros::NodeHandle& nh,
+                                                       const moveit::core::RobotModelConstPtr& model);
+
+    /**
+     * @brief Reads the limits from the parameter server and replaces the shared limits, thread-safe.
+     * @return the new shared limits, the limits returned before stay unchanged
+     * @param nh node handle to access the parameters
+     * @param model robot model whose active joints are limited
+     * @throw AggregationBoundsViolationException if the parameters violate the limits of the robot model
+     */
+    static LimitsContainerConstPtr reloadAggregatedLimits(const ros::NodeHandle& nh,
+                                                          const moveit::core::RobotModelConstPtr& model);
+};
+
+}
+
+#endif // LIMITS_AGGREGATOR_H
@@ -18,13 +18,19 @@
 #ifndef SEQUENCE_ACTION_CAPABILITY_H
 #define SEQUENCE_ACTION_CAPABILITY_H
 
+#include <map>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
 #include <moveit/move_group/move_group_capability.h>
 #include <actionlib/server/simple_action_server.h>
 
 #include <pilz_msgs/MoveGroupSequenceAction.h>
 
+#include "pilz_trajectory_generation/cancellation_token.h"
+
 namespace pilz_trajectory_generation
 {
 
@@ -46,11 +52,28 @@ private:
 
   using StartStateMsgs = pilz_msgs::MoveGroupSequenceResult::_trajectory_start_type;
   using PlannedTrajMsgs = pilz_msgs::MoveGroupSequenceResult::_planned_trajectory_type;
+  using SequenceSegments = std::vector<pilz_msgs::MotionSequenceRequest>;
+  using GroupStateMsgs = std::map<std::string, moveit_msgs::RobotState>;
 
 private:
   void executeSequenceCallback(const pilz_msgs::MoveGroupSequenceGoalConstPtr &goal);
   void executeSequenceCallbackPlanAndExecute(const pilz_msgs::MoveGroupSequenceGoalConstPtr& goal,
                                               pilz_msgs::MoveGroupSequenceResult& action_res);
+  /**
+   * @brief Plans and executes the sequence segment by segment (see splitSequence()).
+   *
+   * The segments are planned by a separate thread, at most "lookahead" segments ahead
+   * of the segment which is executed. If the planning of a segment fails, the
+   * execution stops at the end of the previous segment. If the execution fails,
+   * the running planning is cancelled.
+   *
+   * The planning time of the result is the sum of the planning times of the segments.
+   * If replanning is requested, the sequence is planned and executed as a whole
+   * (see executeSequenceCallbackPlanAndExecute()).
+   */
+  void executeSequenceCallbackPlanAndExecuteStreamed(const pilz_msgs::MoveGroupSequenceGoalConstPtr& goal,
+                                                      const std::size_t lookahead,
+                                                      pilz_msgs::MoveGroupSequenceResult& action_res);
   void executeMoveCallbackPlanOnly(const pilz_msgs::MoveGroupSequenceGoalConstPtr& goal,
                                     pilz_msgs::MoveGroupSequenceResult& res);
   void startMoveExecutionCallback();
@@ -58,16 +81,71 @@ private:
   void preemptMoveCallback();
   void setMoveState(move_group::MoveGroupState state);
   bool planUsingSequenceManager(const pilz_msgs::MotionSequenceRequest &req,
+                                const bool return_partial_result,
                                 plan_execution::ExecutableMotionPlan& plan);
+  /**
+   * @brief Plans the specified sequence.
+   *
+   * @param return_partial_result If TRUE and the planning fails, the plan is set to the
+   * trajectories of the items planned before the failure (see solvePartialSequence()).
+   */
+  bool planSequence(const pilz_msgs::MotionSequenceRequest &req,
+                    const bool return_partial_result,
+                    plan_execution::ExecutableMotionPlan& plan);
+
+  /**
+   * @brief Plans the items of the specified sequence which were successfully planned
+   * before the planning of the sequence failed. The robot stops at the end of the last of these items.
+   *
+   * @return The trajectories of the partial sequence, or an empty container if no item was planned.
+   */
+  std::vector<robot_trajectory::RobotTrajectoryPtr> solvePartialSequence(
+      const planning_scene::PlanningSceneConstPtr& scene,
+      const pilz_msgs::MotionSequenceRequest& req);
+
+  //! Publishes the planning progress of the sequence as feedback.
+  void publishPlanningProgress(const std::size_t index,
+                               const std::size_t num_items,
+                               const double planning_time,
+                               const bool reused);
 
 private:
+  static void setPlanComponents(const std::vector<robot_trajectory::RobotTrajectoryPtr>& traj_vec,
+                                plan_execution::ExecutableMotionPlan& plan);
+
   static void convertToMsg(const ExecutableTrajs& trajs,
                            StartStateMsgs& startStatesMsgs,
                            PlannedTrajMsgs& plannedTrajsMsgs);
 
+  /**
+   * @brief Splits the sequence after each command with a blend radius of zero, so that
+   * the robot stops at the end of each segment.
+   *
+   * @return FALSE if a command, which is not the first command of its group, has a start state.
+   */
+  static bool splitSequence(const pilz_msgs::MotionSequenceRequest& req,
+                            SequenceSegments& segments);
+
+  /**
+   * @brief Sets the start state of the first command of each group in the specified segment.
+   *
+   * The start state is the end state of the group in the previous segments. Groups which were not
+   * moved by the previous segments start at the specified initial state, unless a start state is given.
+   */
+  static void setSegmentStartStates(const moveit_msgs::RobotState& initial_state,
+                                    const GroupStateMsgs& end_states,
+                                    pilz_msgs::MotionSequenceRequest& segment);
+
 private:
   std::unique_ptr<actionlib::SimpleActionServer<pilz_msgs::MoveGroupSequenceAction> > move_action_server_;
   pilz_msgs::MoveGroupSequenceFeedback move_feedback_;
+  //! Guards the feedback, which is also published from the planning threads.
+  std::mutex feedback_mutex_;
+  //! Index of the first item of the currently planned (streamed) segment within the goal.
+  std::size_t progress_offset_ {0};
+
+  //! Cancels the planning of the current goal if the goal is preempted.
+  pilz::CancellationToken cancellation_token_;
 
   move_group::MoveGroupState move_state_ {move_group::IDLE};
   std::unique_ptr<pilz_trajectory_generation::CommandListManager> command_list_manager_;
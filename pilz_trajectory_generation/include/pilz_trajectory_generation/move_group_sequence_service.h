@@ -18,9 +18,14 @@
 #ifndef SEQUENCE_SERVICE_CAPABILITY_H
 #define SEQUENCE_SERVICE_CAPABILITY_H
 
+#include <memory>
+#include <mutex>
+#include <vector>
+
 #include <moveit/move_group/move_group_capability.h>
 
 #include <pilz_msgs/GetMotionSequence.h>
+#include <pilz_msgs/GetMotionSequenceBatch.h>
 
 namespace pilz_trajectory_generation
 {
@@ -30,6 +35,9 @@ class CommandListManager;
 
 /**
  * @brief Provide service to blend multiple trajectories in the form of a MoveGroup capability (plugin).
+ *
+ * A second service plans a batch of independent sequences, concurrently if the parameter
+ * "batch_planning_threads" is greater than one.
  */
 class MoveGroupSequenceService : public move_group::MoveGroupCapability
 {
@@ -44,10 +52,23 @@ private:
   bool plan(pilz_msgs::GetMotionSequence::Request &req,
             pilz_msgs::GetMotionSequence::Response &res);
 
+  /**
+   * @brief Plans all sequences of the batch (concurrently, if enabled), using one snapshot
+   * of the planning scene. Each sequence gets its own error code.
+   */
+  bool planBatch(pilz_msgs::GetMotionSequenceBatch::Request &req,
+                 pilz_msgs::GetMotionSequenceBatch::Response &res);
+
 private:
   ros::ServiceServer sequence_service_;
   std::unique_ptr<CommandListManager> command_list_manager_ ;
 
+  ros::ServiceServer sequence_batch_service_;
+  //! One manager per worker thread of the batch planning.
+  std::vector<std::unique_ptr<CommandListManager> > batch_managers_;
+  //! Serializes the batch requests (which share the batch managers).
+  std::mutex batch_mutex_;
+
 };
 
 }
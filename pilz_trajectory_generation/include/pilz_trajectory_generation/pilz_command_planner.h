@@ -28,6 +28,8 @@
 
 #include <pluginlib/class_loader.h>
 
+#include <mutex>
+
 // Boost includes
 #include <boost/scoped_ptr.hpp>
 
@@ -38,6 +40,10 @@ namespace pilz {
  * This planner is dedicated to return a instance of PlanningContext that corresponds to the requested motion command
  * set as planner_id in the MotionPlanRequest).
  * It can be easily extended with additional commands by creating a class inherting from PlanningContextLoader.
+ *
+ * After initialize() (and registerContextLoader()) getPlanningContext() and the solve() of the returned contexts
+ * can be called concurrently from different threads. Each context is used by one request at a time. Note that
+ * the IK solver of the planning group has to support concurrent calls.
  */
 class CommandPlanner : public planning_interface::PlannerManager
 {
@@ -47,6 +53,8 @@ public:
   /**
    * @brief Initializes the planner
    * Upon initialization this planner will look for plugins implementing pilz::PlanningContextLoader.
+   * A plugin named "pilz::PlanningContextLoader<command>" is only created on the first request of its command,
+   * other plugins are created immediately to obtain their command.
    * @param model The robot model
    * @param ns The namespace
    * @return true on success, false otherwise
@@ -87,16 +95,40 @@ public:
    * @brief Register a PlanningContextLoader to be used by the CommandPlanner
    * @param planning_context_loader
    * @throw ContextLoaderRegistrationException if a loader with the same algorithm name is already registered
+   * @note Not thread-safe, has to be called before the planner is used concurrently.
    */
   void registerContextLoader(const pilz::PlanningContextLoaderPtr& planning_context_loader);
 
+private:
+  /// Loader of a command, plugins are created on first use
+  struct ContextLoaderEntry
+  {
+    /// Lookup name of the plugin (empty if the loader was registered directly)
+    std::string class_name;
+
+    /// The loader, nullptr until the plugin is created
+    mutable pilz::PlanningContextLoaderPtr loader;
+  };
+
+  /**
+   * @brief Returns the loader of the specified command, the plugin is created if necessary.
+   * @return nullptr if the plugin could not be created
+   */
+  pilz::PlanningContextLoaderPtr getContextLoader(const ContextLoaderEntry& entry) const;
+
+  /// Creates the plugin with the specified lookup name and passes the model and the limits to it
+  pilz::PlanningContextLoaderPtr createContextLoader(const std::string& class_name) const;
+
 private:
 
   /// Plugin loader
   boost::scoped_ptr<pluginlib::ClassLoader<PlanningContextLoader> > planner_context_loader;
 
   /// Mapping from command to loader
-  std::map<std::string, pilz::PlanningContextLoaderPtr> context_loader_map_;
+  std::map<std::string, ContextLoaderEntry> context_loader_map_;
+
+  /// Protects the creation of plugins
+  mutable std::mutex context_loader_mutex_;
 
   /// Robot model obtained at initialize
   moveit::core::RobotModelConstPtr model_;
@@ -104,11 +136,8 @@ private:
   /// Namespace where the parameters are stored, obtained at initialize
   std::string namespace_;
 
-  /// aggregated limits of the active joints
-  pilz::JointLimitsContainer aggregated_limit_active_joints_;
-
-  /// cartesian limit
-  pilz::CartesianLimit cartesian_limit_;
+  /// aggregated limits of the active joints and cartesian limits
+  pilz::LimitsContainer limits_;
 };
 
 MOVEIT_CLASS_FORWARD(CommandPlanner)
@@ -18,12 +18,18 @@
 #ifndef PLANCOMPONENTSBUILDER_H
 #define PLANCOMPONENTSBUILDER_H
 
+#include <algorithm>
 #include <string>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 #include <moveit/robot_model/robot_model.h>
 #include <moveit/robot_trajectory/robot_trajectory.h>
 
+#include "pilz_trajectory_generation/cancellation_token.h"
 #include "pilz_trajectory_generation/trajectory_functions.h"
 #include "pilz_trajectory_generation/trajectory_blend_request.h"
 #include "pilz_trajectory_generation/trajectory_blender.h"
@@ -39,6 +45,8 @@ CREATE_MOVEIT_ERROR_CODE_EXCEPTION(NoBlenderSetException, moveit_msgs::MoveItErr
 CREATE_MOVEIT_ERROR_CODE_EXCEPTION(NoTipFrameFunctionSetException, moveit_msgs::MoveItErrorCodes::FAILURE);
 CREATE_MOVEIT_ERROR_CODE_EXCEPTION(NoRobotModelSetException, moveit_msgs::MoveItErrorCodes::FAILURE);
 CREATE_MOVEIT_ERROR_CODE_EXCEPTION(BlendingFailedException, moveit_msgs::MoveItErrorCodes::FAILURE);
+CREATE_MOVEIT_ERROR_CODE_EXCEPTION(PlanningCancelledException, moveit_msgs::MoveItErrorCodes::PREEMPTED);
+CREATE_MOVEIT_ERROR_CODE_EXCEPTION(PlanningTimedOutException, moveit_msgs::MoveItErrorCodes::TIMED_OUT);
 
 /**
  * @brief Helper class to encapsulate the merge and blend process of
@@ -57,6 +65,35 @@ public:
    */
   void setModel(const moveit::core::RobotModelConstPtr &model);
 
+  /**
+   * @brief Enables/Disables the parallel blending mode.
+   *
+   * In parallel blending mode, append() only collects the trajectories. All
+   * blends are computed concurrently by build(), each one using the two complete
+   * neighbouring trajectories. The results are stitched together afterwards,
+   * which yields the same trajectories as the sequential blending.
+   *
+   * @note The blender has to support concurrent calls of blend().
+   */
+  void setParallelBlending(bool parallel_blending);
+
+  /**
+   * @brief Sets the maximal number of threads of the parallel blending mode (at least 1).
+   */
+  void setMaxBlendingThreads(std::size_t max_blending_threads);
+
+  /**
+   * @brief Sets the token which cancels running blends. The token has to
+   * outlive the builder.
+   */
+  void setCancellationToken(const pilz::CancellationToken* cancellation_token);
+
+  /**
+   * @brief Sets the deadline of the blending (zero: no deadline). Blends
+   * exceeding the deadline fail with a PlanningTimedOutException.
+   */
+  void setDeadline(const ros::Time& deadline);
+
   /**
    * @brief Appends the specified trajectory to the trajectory container
    * under construction.
@@ -82,9 +119,19 @@ public:
 
   /**
    * @brief Clears the trajectory container under construction.
+   *
+   * If enabled (see setBlendReuse()), the blends computed since the last reset are kept.
+   * They are reused, if the same trajectory objects are blended again with the same blend radius.
+   * In parallel blending mode this concerns all junctions between unchanged
+   * trajectories, in sequential mode only the junctions before the first change.
    */
   void reset();
 
+  /**
+   * @brief Enables or disables the reuse of the blends of the previous build (disabled by default).
+   */
+  void setBlendReuse(bool reuse_blends);
+
   /**
    * @return The final trajectory container which results from the append calls.
    */
@@ -94,6 +141,53 @@ private:
   void blend(const robot_trajectory::RobotTrajectoryPtr& other,
              const double blend_radius);
 
+  /**
+   * @brief Blends the two given trajectories or takes the result from the blend cache.
+   *
+   * @throw BlendingFailedException if the blending fails.
+   */
+  void blend(const robot_trajectory::RobotTrajectoryPtr& first,
+             const robot_trajectory::RobotTrajectoryPtr& second,
+             const double blend_radius,
+             pilz::TrajectoryBlendResponse& blend_response) const;
+
+  /**
+   * @return True if the trajectory with the given index is blended with its predecessor.
+   */
+  bool isBlended(const std::size_t index) const;
+
+  /**
+   * @brief Implements build() for the parallel blending mode.
+   */
+  std::vector<robot_trajectory::RobotTrajectoryPtr> buildParallel() const;
+
+  /**
+   * @brief Blends all junctions between the collected trajectories concurrently.
+   *
+   * Failed blends (BlendingFailedException) are only marked, all other exceptions
+   * (e.g. PlanningCancelledException, PlanningTimedOutException) stop the blending
+   * and are rethrown.
+   *
+   * @param blend_responses Response of the blend between trajectory i-1 and i at position i.
+   * @param blend_success True at position i if the blend between trajectory i-1 and i succeeded.
+   */
+  void blendConcurrently(std::vector<pilz::TrajectoryBlendResponse>& blend_responses,
+                         std::vector<char>& blend_success) const;
+
+  /**
+   * @brief Joins the part of a trajectory which remains after the previous blend (tail)
+   * with the first trajectory of a blend, which was computed using the complete trajectory.
+   *
+   * Both parts share the waypoints with the complete trajectory, except for the waypoints
+   * resampled by the blender. They are joined at the last shared waypoint.
+   *
+   * @return The joined trajectory or nullptr, if the parts cannot be joined (e.g. because the
+   * blend spheres overlap).
+   */
+  static robot_trajectory::RobotTrajectoryPtr joinBlendParts(const robot_trajectory::RobotTrajectory &complete,
+                                                             robot_trajectory::RobotTrajectory &tail,
+                                                             robot_trajectory::RobotTrajectory &blend_first);
+
 private:
   /**
    * @brief Appends a trajectory to a result trajectory leaving out the
@@ -103,9 +197,26 @@ private:
    * ros_controllers::JointTrajectoryController require a timewise strictly
    * increasing trajectory. If through appending the last point of the
    * original trajectory gets repeated, it is removed here.
+   *
+   * @note The waypoints of the source are shared with the result (no deep copy).
    */
   static void appendWithStrictTimeIncrease(robot_trajectory::RobotTrajectory &result,
-                                           const robot_trajectory::RobotTrajectory &source);
+                                           robot_trajectory::RobotTrajectory &source);
+
+private:
+  //! Result of a blend together with the blended trajectories.
+  struct BlendCacheEntry
+  {
+    robot_trajectory::RobotTrajectoryPtr first;
+    robot_trajectory::RobotTrajectoryPtr second;
+    double blend_radius;
+    pilz::TrajectoryBlendResponse response;
+  };
+
+  //! Blend results accessed via the addresses of the blended trajectories.
+  //! (The entries hold the trajectories, so the addresses cannot be reused.)
+  using BlendCache = std::map<std::pair<const robot_trajectory::RobotTrajectory*,
+                                        const robot_trajectory::RobotTrajectory*>, BlendCacheEntry>;
 
 private:
   //! Blender used to blend two trajectories.
@@ -120,9 +231,38 @@ private:
   //! The trajectory container under construction.
   std::vector<robot_trajectory::RobotTrajectoryPtr> traj_cont_;
 
+  //! Flag indicating if the parallel blending mode is enabled.
+  bool parallel_blending_ {false};
+
+  //! Maximal number of threads of the parallel blending mode.
+  std::size_t max_blending_threads_ {DEFAULT_MAX_BLENDING_THREADS};
+
+  //! Optional token to cancel the blending.
+  const pilz::CancellationToken* cancellation_token_ {nullptr};
+
+  //! Deadline of the blending (zero: no deadline).
+  ros::Time deadline_;
+
+  //! Trajectories and blend radii collected in parallel blending mode.
+  std::vector<std::pair<robot_trajectory::RobotTrajectoryPtr, double> > segments_;
+
+  //! Keep the blends on reset().
+  bool reuse_blends_ {false};
+
+  //! Blends computed before the last reset.
+  BlendCache blend_cache_;
+
+  //! Blends computed or reused since the last reset.
+  mutable BlendCache used_blends_;
+
+  //! Protects used_blends_ during concurrent blending.
+  mutable std::mutex used_blends_mutex_;
+
 private:
   //! Constant to check for equality of variables of two RobotState instances.
   static constexpr double ROBOT_STATE_EQUALITY_EPSILON = 1e-4;
+
+  static constexpr std::size_t DEFAULT_MAX_BLENDING_THREADS {4};
 };
 
 inline void PlanComponentsBuilder::setBlender(std::unique_ptr<pilz::TrajectoryBlender> blender)
@@ -135,10 +275,42 @@ inline void PlanComponentsBuilder::setModel(const moveit::core::RobotModelConstP
   model_ = model;
 }
 
+inline void PlanComponentsBuilder::setParallelBlending(bool parallel_blending)
+{
+  parallel_blending_ = parallel_blending;
+}
+
+inline void PlanComponentsBuilder::setMaxBlendingThreads(std::size_t max_blending_threads)
+{
+  max_blending_threads_ = std::max<std::size_t>(1, max_blending_threads);
+}
+
+inline void PlanComponentsBuilder::setCancellationToken(const pilz::CancellationToken* cancellation_token)
+{
+  cancellation_token_ = cancellation_token;
+}
+
+inline void PlanComponentsBuilder::setDeadline(const ros::Time& deadline)
+{
+  deadline_ = deadline;
+}
+
 inline void PlanComponentsBuilder::reset()
 {
   traj_tail_ = nullptr;
   traj_cont_.clear();
+  segments_.clear();
+  if (reuse_blends_)
+  {
+    blend_cache_.swap(used_blends_);
+  }
+  used_blends_.clear();
+}
+
+inline void PlanComponentsBuilder::setBlendReuse(bool reuse_blends)
+{
+  reuse_blends_ = reuse_blends;
+  blend_cache_.clear();
 }
 
 
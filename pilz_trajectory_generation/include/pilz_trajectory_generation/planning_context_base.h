@@ -18,6 +18,7 @@
 #ifndef PLANNING_CONTEXT_BASE_H
 #define PLANNING_CONTEXT_BASE_H
 
+#include "pilz_trajectory_generation/cancellation_token.h"
 #include "pilz_trajectory_generation/joint_limits_container.h"
 #include "pilz_trajectory_generation/trajectory_generator.h"
 
@@ -49,7 +50,10 @@ public:
   terminated_(false),
   model_(model),
   limits_(limits),
-  generator_(model, limits_){}
+  generator_(model, limits_)
+  {
+    generator_.setCancellationToken(&cancellation_token_);
+  }
 
   virtual ~PlanningContextBase() {}
 
@@ -71,8 +75,10 @@ public:
 
   /**
    * @brief Will terminate solve()
-   * @return
-   * @note Currently will not stop a runnning solve but
+   *
+   * A running solve() stops at the next trajectory sample with
+   * moveit_msgs::MoveItErrorCodes::PREEMPTED, later calls of solve() fail.
+   * @return true
    */
   virtual bool terminate() override;
 
@@ -81,6 +87,18 @@ public:
    */
   virtual void clear() override;
 
+  /**
+   * @brief Prepares the context for the next request, so that it can be reused
+   *
+   * Removes request and planning scene and revokes a previous terminate().
+   */
+  void reset();
+
+  /**
+   * @brief Sets the sampling time of the trajectories calculated by solve()
+   */
+  void setSamplingTime(double sampling_time);
+
   /// Flag if terminated
   std::atomic_bool terminated_;
 
@@ -91,8 +109,13 @@ public:
   pilz::LimitsContainer limits_;
 
 protected:
+  /// Cancels a running generation on terminate()
+  pilz::CancellationToken cancellation_token_;
+
   GeneratorT generator_;
 
+  /// Sampling time of the calculated trajectories
+  double sampling_time_ {TrajectoryGenerator::DEFAULT_SAMPLING_TIME};
 };
 
 
@@ -108,7 +131,7 @@ bool pilz::PlanningContextBase<GeneratorT>::solve(planning_interface::MotionPlan
       moveit::core::robotStateToRobotStateMsg(getPlanningScene()->getCurrentState(), currentState);
       request_.start_state = currentState;
     }
-    bool result = generator_.generate(request_, res);
+    bool result = generator_.generate(request_, res, sampling_time_);
     return result;
     //res.error_code_.val = moveit_msgs::MoveItErrorCodes::INVALID_MOTION_PLAN;
     //return false; // TODO
@@ -149,10 +172,28 @@ bool pilz::PlanningContextBase<GeneratorT>::terminate()
 {
   ROS_DEBUG_STREAM("Terminate called");
   terminated_ = true;
+  cancellation_token_.cancel();
   return true;
 }
 
 
+template <typename GeneratorT>
+void pilz::PlanningContextBase<GeneratorT>::reset()
+{
+  request_ = planning_interface::MotionPlanRequest();
+  planning_scene_.reset();
+  cancellation_token_.reset();
+  terminated_ = false;
+}
+
+
+template <typename GeneratorT>
+void pilz::PlanningContextBase<GeneratorT>::setSamplingTime(double sampling_time)
+{
+  sampling_time_ = sampling_time;
+}
+
+
 template <typename GeneratorT>
 void pilz::PlanningContextBase<GeneratorT>::clear()
 {
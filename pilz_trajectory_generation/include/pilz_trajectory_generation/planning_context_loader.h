@@ -26,6 +26,8 @@
 #include <moveit/planning_interface/planning_interface.h>
 
 #include "pilz_trajectory_generation/limits_container.h"
+#include "pilz_trajectory_generation/planning_context_pool.h"
+#include "pilz_trajectory_generation/trajectory_generator.h"
 
 namespace pilz {
 
@@ -33,6 +35,8 @@ namespace pilz {
  * @brief Base class for all PlanningContextLoaders.
  * Since planning_interface::PlanningContext has a non empty ctor classes derived from it can not be plugins.
  * This class serves as base class for wrappers.
+ *
+ * loadContext() can be called concurrently, setModel() and setLimits() can not.
  */
 class PlanningContextLoader
 {
@@ -57,8 +61,20 @@ public:
    */
   virtual bool setLimits(const pilz::LimitsContainer& limits);
 
+  /**
+   * @brief Sets the sampling time of the trajectories generated by the contexts
+   * @param sampling_time sampling time in seconds
+   * @return false if the sampling time is not positive (the previous sampling time is kept)
+   */
+  bool setSamplingTime(double sampling_time);
+
   /**
    * @brief Return the planning context
+   *
+   * The contexts are reused: A context is reset and returned to the pool of the
+   * loader once it is no longer referenced, and handed out again by the next call
+   * with the same name and group.
+   *
    * @param planning_context
    * @param name context name
    * @param group name of the planning group
@@ -98,6 +114,12 @@ protected:
 
   /// The robot model
   moveit::core::RobotModelConstPtr model_;
+
+  /// Sampling time of the generated trajectories
+  double sampling_time_ {TrajectoryGenerator::DEFAULT_SAMPLING_TIME};
+
+  /// Idle planning contexts (replaced by an empty pool if the model or the limits change)
+  std::shared_ptr<PlanningContextPool> context_pool_ {std::make_shared<PlanningContextPool>()};
 };
 
 
@@ -111,7 +133,25 @@ bool PlanningContextLoader::loadContext(planning_interface::PlanningContextPtr&
                                                          const std::string& group) const
 {
   if(limits_set_ && model_set_) {
-    planning_context.reset(new T(name, group, model_, limits_));
+    PlanningContextPool::ContextUPtr context {context_pool_->acquire(name, group)};
+    if(!context)
+    {
+      context.reset(new T(name, group, model_, limits_));
+    }
+    static_cast<T*>(context.get())->setSamplingTime(sampling_time_);
+
+    // Reset the context and return it to the pool once it is released (unless the loader is gone)
+    std::weak_ptr<PlanningContextPool> pool {context_pool_};
+    planning_context.reset(context.release(), [pool](planning_interface::PlanningContext* released_context)
+    {
+      PlanningContextPool::ContextUPtr context {released_context};
+      std::shared_ptr<PlanningContextPool> locked_pool {pool.lock()};
+      if(locked_pool)
+      {
+        static_cast<T*>(released_context)->reset();
+        locked_pool->release(std::move(context));
+      }
+    });
     return true;
   }
   else
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2018 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PLANNING_CONTEXT_POOL_H
+#define PLANNING_CONTEXT_POOL_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <moveit/planning_interface/planning_interface.h>
+
+namespace pilz {
+
+/**
+ * @brief Thread-safe pool of idle planning contexts, accessed via the name and the group of the context.
+ *
+ * Allows to reuse the contexts (and their trajectory generators) instead of constructing
+ * a new context for each request.
+ */
+class PlanningContextPool
+{
+public:
+  using ContextUPtr = std::unique_ptr<planning_interface::PlanningContext>;
+
+public:
+  /**
+   * @return An idle context of the specified name and group (removed from the pool),
+   * or nullptr if there is none.
+   */
+  ContextUPtr acquire(const std::string& name, const std::string& group);
+
+  /**
+   * @brief Adds the specified (reset) context to the idle contexts.
+   */
+  void release(ContextUPtr context);
+
+private:
+  using Key = std::pair<std::string, std::string>;
+
+private:
+  std::mutex mutex_;
+  std::map<Key, std::vector<ContextUPtr> > idle_contexts_;
+};
+
+inline PlanningContextPool::ContextUPtr PlanningContextPool::acquire(const std::string& name,
+                                                                     const std::string& group)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it {idle_contexts_.find(Key(name, group))};
+  if (it == idle_contexts_.end() || it->second.empty())
+  {
+    return nullptr;
+  }
+  ContextUPtr context {std::move(it->second.back())};
+  it->second.pop_back();
+  return context;
+}
+
+inline void PlanningContextPool::release(ContextUPtr context)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  idle_contexts_[Key(context->getName(), context->getGroupName())].push_back(std::move(context));
+}
+
+} // namespace
+
+#endif // PLANNING_CONTEXT_POOL_H
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2018 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PLANNING_CORE_H
+#define PLANNING_CORE_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Eigen/Geometry>
+#include <kdl/velocityprofile.hpp>
+
+#include "pilz_trajectory_generation/cartesian_limit.h"
+#include "pilz_trajectory_generation/cartesian_path.h"
+#include "pilz_trajectory_generation/joint_limits_container.h"
+
+/**
+ * @file
+ * @brief Trajectory generation on plain C++ and Eigen types without ROS dependencies.
+ *
+ * The functions can be used without a running ROS system, e.g. for planning offline. The trajectory
+ * generators of the planning context plugins convert the requests and results for these functions.
+ *
+ * The core covers the PTP joint trajectories and the Cartesian trajectories of LIN and CIRC. The inverse
+ * kinematics of the Cartesian samples and the blending of trajectories operate on the robot model of MoveIt!
+ * and therefore remain in the plugins (see generateJointTrajectory() and TrajectoryBlender).
+ */
+
+namespace pilz {
+
+//! Sample of a joint trajectory, the values are in the order of JointSpaceTrajectory::joint_names.
+struct JointTrajectorySample
+{
+  double time_from_start {0.};
+  std::vector<double> positions;
+  std::vector<double> velocities;
+  std::vector<double> accelerations;
+};
+
+//! Joint trajectory sampled at discrete times.
+struct JointSpaceTrajectory
+{
+  std::vector<std::string> joint_names;
+  std::vector<JointTrajectorySample> samples;
+};
+
+//! Cartesian trajectory sampled at discrete times.
+struct CartesianSamples
+{
+  std::vector<double> time_samples;
+  //! Pose at each time sample.
+  PoseBuffer poses;
+};
+
+//! Result of checking a trajectory sample against the joint limits.
+enum class JointLimitViolation
+{
+  NONE,
+  SAMPLE_DURATION_TOO_SMALL,
+  VELOCITY,
+  ACCELERATION,
+  DECELERATION
+};
+
+/**
+ * @brief Generates the time samples from zero to the duration, the last interval can be shorter
+ * than the sampling time.
+ */
+std::vector<double> sampleTimes(const double duration, const double sampling_time);
+
+/**
+ * @brief Samples the poses of a Cartesian path moved along with the specified velocity profile.
+ */
+void sampleCartesianTrajectory(const CartesianPath& path,
+                               const KDL::VelocityProfile& velocity_profile,
+                               const double sampling_time,
+                               CartesianSamples& samples);
+
+/**
+ * @brief Builds the trapezoid velocity profile of a Cartesian path with the translational limits.
+ *
+ * The path length is the longer distance of translational and rotational motion
+ * (see CartesianPath::getLength()).
+ */
+std::unique_ptr<KDL::VelocityProfile> cartesianTrapVelocityProfile(const CartesianLimit& limit,
+                                                                   const double velocity_scaling_factor,
+                                                                   const double acceleration_scaling_factor,
+                                                                   const double path_length);
+
+/**
+ * @brief Creates the Cartesian straight line of a LIN command.
+ *
+ * The ratio of translational by rotational velocity limit is used as equivalent radius of the rotation.
+ */
+std::unique_ptr<CartesianPath> createLINPath(const Eigen::Isometry3d& start_pose,
+                                             const Eigen::Isometry3d& goal_pose,
+                                             const CartesianLimit& limit);
+
+/**
+ * @brief Creates the Cartesian circle of a CIRC command.
+ * @param path_point center or interim point of the circle
+ * @param path_point_is_center true if path_point is the center, false if it is an interim point
+ * @throw KDL::Error_MotionPlanning_Circle_No_Plane, KDL::Error_MotionPlanning_Circle_ToSmall or
+ * Error_MotionPlanning_CenterPointDifferentRadius if the circle can not be constructed
+ * (see PathCircleGenerator)
+ */
+std::unique_ptr<CartesianPath> createCIRCPath(const Eigen::Isometry3d& start_pose,
+                                              const Eigen::Isometry3d& goal_pose,
+                                              const Eigen::Vector3d& path_point,
+                                              const bool path_point_is_center,
+                                              const CartesianLimit& limit);
+
+/**
+ * @brief Samples the poses of a Cartesian path moved with the trapezoid velocity profile of the limits.
+ *
+ * Together with createLINPath() and createCIRCPath() this gives the Cartesian trajectory of a LIN or CIRC
+ * command. The joint trajectory additionally requires the inverse kinematics of each sample.
+ */
+void planCartesianTrajectory(const CartesianPath& path,
+                             const CartesianLimit& limit,
+                             const double velocity_scaling_factor,
+                             const double acceleration_scaling_factor,
+                             const double sampling_time,
+                             CartesianSamples& samples);
+
+/**
+ * @brief Plans a point to point joint trajectory with zero start and goal velocity.
+ *
+ * All joints move with a trapezoid velocity profile, the profiles are synchronized to the slowest joint.
+ * @param limit common limit of all joints, velocity, acceleration and deceleration limits have to be set
+ * @param trajectory the joints are ordered by name
+ * @return false if the goal is already reached, the trajectory then consists of the start positions at the sampling time
+ * @throw std::runtime_error if the velocity profiles can not be synchronized
+ */
+bool planPTPTrajectory(const std::map<std::string, double>& start_positions,
+                       const std::map<std::string, double>& goal_positions,
+                       const pilz_extensions::JointLimit& limit,
+                       const double velocity_scaling_factor,
+                       const double acceleration_scaling_factor,
+                       const double sampling_time,
+                       JointSpaceTrajectory& trajectory);
+
+/**
+ * @brief Checks the velocity/acceleration limits of the current sample (based on backward difference computation)
+ * v(k) = [x(k) - x(k-1)]/[t(k) - t(k-1)]
+ * a(k) = [v(k) - v(k-1)]/[t(k) - t(k-2)]*2
+ * @param violating_joint set to the joint violating the limits
+ * @param violating_value set to the velocity or acceleration of the violating joint
+ */
+JointLimitViolation checkSampleJointLimits(const std::map<std::string, double>& position_last,
+                                           const std::map<std::string, double>& velocity_last,
+                                           const std::map<std::string, double>& position_current,
+                                           const double duration_last,
+                                           const double duration_current,
+                                           const JointLimitsContainer& joint_limits,
+                                           std::string& violating_joint,
+                                           double& violating_value);
+
+} // namespace pilz
+
+#endif // PLANNING_CORE_H
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2018 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PLANNING_SCENE_SNAPSHOT_H
+#define PLANNING_SCENE_SNAPSHOT_H
+
+#include <moveit/planning_scene/planning_scene.h>
+#include <moveit/planning_scene_monitor/planning_scene_monitor.h>
+#include <moveit_msgs/PlanningScene.h>
+
+namespace pilz_trajectory_generation
+{
+
+/**
+ * @return A copy of the monitored planning scene, taken under a short read lock, so
+ * that the planning does not block the scene updates of the planning scene monitor.
+ *
+ * The copy is decoupled from the monitored scene. The geometry of the world objects
+ * (e.g. the octomap) is shared and only copied if it is modified.
+ *
+ * @param planning_scene_diff Applied to the copy (if not empty).
+ */
+inline planning_scene::PlanningSceneConstPtr takePlanningSceneSnapshot(
+    const planning_scene_monitor::PlanningSceneMonitorPtr& planning_scene_monitor,
+    const moveit_msgs::PlanningScene& planning_scene_diff = moveit_msgs::PlanningScene())
+{
+  planning_scene::PlanningScenePtr snapshot;
+  {
+    planning_scene_monitor::LockedPlanningSceneRO lscene(planning_scene_monitor);
+    snapshot = planning_scene::PlanningScene::clone(lscene);
+  }
+  if (!planning_scene::PlanningScene::isEmpty(planning_scene_diff))
+  {
+    snapshot->setPlanningSceneDiffMsg(planning_scene_diff);
+  }
+  return snapshot;
+}
+
+/**
+ * @return A copy of the specified planning scene, taken under a short read lock of the
+ * specified planning scene monitor (see above).
+ */
+inline planning_scene::PlanningSceneConstPtr takePlanningSceneSnapshot(
+    const planning_scene_monitor::PlanningSceneMonitorPtr& planning_scene_monitor,
+    const planning_scene::PlanningSceneConstPtr& planning_scene)
+{
+  planning_scene_monitor::LockedPlanningSceneRO lscene(planning_scene_monitor);
+  return planning_scene::PlanningScene::clone(planning_scene);
+}
+
+}
+
+#endif // PLANNING_SCENE_SNAPSHOT_H
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2018 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SEQUENCE_CACHE_H
+#define SEQUENCE_CACHE_H
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <moveit/robot_trajectory/robot_trajectory.h>
+
+namespace pilz_trajectory_generation
+{
+
+/**
+ * @brief Bounded cache of the final (blended) trajectories of complete sequences.
+ *
+ * Each entry is accessed via a key (e.g. the serialized request and planning scene)
+ * and is only valid for start positions which are within a tolerance of the
+ * start positions the entry was stored with. If the capacity is exceeded,
+ * the least recently used entry is removed.
+ */
+class SequenceCache
+{
+public:
+  using TrajCont = std::vector<robot_trajectory::RobotTrajectoryPtr>;
+
+  //! Number of successful and failed lookups.
+  struct Statistics
+  {
+    std::size_t hits {0};
+    std::size_t misses {0};
+  };
+
+public:
+  /**
+   * @param capacity Maximal number of entries.
+   * @param start_position_tolerance Maximal deviation of each start position
+   * for which an entry is still valid.
+   */
+  SequenceCache(const std::size_t capacity, const double start_position_tolerance);
+
+  /**
+   * @brief Looks up the trajectories stored for the specified key.
+   *
+   * @param start_positions The start positions which have to match the
+   * stored start positions (within the tolerance).
+   * @param trajs Set to copies of the stored trajectories in case of a hit.
+   *
+   * @return TRUE in case of a hit, otherwise FALSE.
+   */
+  bool lookup(const std::string& key,
+              const std::vector<double>& start_positions,
+              TrajCont& trajs);
+
+  /**
+   * @brief Stores copies of the specified trajectories, replacing the previous entry
+   * of the specified key.
+   */
+  void insert(const std::string& key,
+              const std::vector<double>& start_positions,
+              const TrajCont& trajs);
+
+  void clear();
+
+  std::size_t size() const;
+
+  const Statistics& getStatistics() const;
+
+private:
+  struct Entry
+  {
+    std::string key;
+    std::vector<double> start_positions;
+    TrajCont trajs;
+  };
+  //! Entries ordered by their last usage (most recently used first).
+  using EntryList = std::list<Entry>;
+
+private:
+  //! @return Deep copies (including the waypoints) of the specified trajectories.
+  static TrajCont copyTrajectories(const TrajCont& trajs);
+
+  bool isWithinTolerance(const std::vector<double>& positions_A,
+                         const std::vector<double>& positions_B) const;
+
+private:
+  const std::size_t capacity_;
+  const double start_position_tolerance_;
+
+  EntryList entries_;
+  std::unordered_map<std::string, EntryList::iterator> index_;
+
+  Statistics statistics_;
+};
+
+inline void SequenceCache::clear()
+{
+  entries_.clear();
+  index_.clear();
+}
+
+inline std::size_t SequenceCache::size() const
+{
+  return entries_.size();
+}
+
+inline const SequenceCache::Statistics& SequenceCache::getStatistics() const
+{
+  return statistics_;
+}
+
+}
+
+#endif // SEQUENCE_CACHE_H
@@ -21,6 +21,9 @@
 #include <string>
 
 #include <moveit/robot_trajectory/robot_trajectory.h>
+#include <ros/time.h>
+
+#include "pilz_trajectory_generation/cancellation_token.h"
 
 namespace pilz
 {
@@ -39,6 +42,12 @@ struct TrajectoryBlendRequest
 
   // Blend radius in meter
   double blend_radius;
+
+  // Optional token to cancel the blending
+  const CancellationToken* cancellation_token {nullptr};
+
+  // Optional deadline of the blending (zero: no deadline)
+  ros::Time deadline;
 };
 
 
@@ -43,8 +43,10 @@ public:
 
 
   /**
-   * @brief Blend two trajectories using transition window. The trajectories have to be equally and uniformly
-   * discretized.
+   * @brief Blend two trajectories using transition window. Each trajectory has to be uniformly discretized.
+   * If the sampling times differ, the coarser trajectory is resampled, so that the blend trajectory and the
+   * second trajectory of the response use the finer sampling time. The second trajectory of the response
+   * therefore stays uniformly discretized and can be blended with a following trajectory.
    * @param req: following fields need to be filled for a valid request:
    *    - group_name : name of the planning group
    *    - link_name : name of the target link
@@ -62,6 +64,10 @@ public:
    *    - second trajectory: Part of the second original trajectory which is outside of the blend sphere.
    *                         The first waypoint has non-zero time from start.
    * error_code: information of failed blend
+   *
+   * @note The waypoints of the first and second trajectory in the response are shared with the
+   * trajectories of the request (no deep copy), they must not be modified in place. Resampled waypoints
+   * are the only exception.
    * @return true if succeed
    */
   virtual bool blend(const pilz::TrajectoryBlendRequest& req,
@@ -71,20 +77,53 @@ private:
   /**
    * @brief validate trajectory blend request
    * @param req
-   * @param sampling_time: get the same sampling time of the two input trajectories
+   * @param sampling_time: get the finer one of the (uniform) sampling times of the two input trajectories
    * @param error_code
    * @return
    */
   bool validateRequest(const pilz::TrajectoryBlendRequest& req,
                        double &sampling_time,
                        moveit_msgs::MoveItErrorCodes& error_code) const;
+
+  /**
+   * @brief Bring the parts of the two trajectories which are relevant for blending onto the given sampling time.
+   *
+   * A trajectory with a coarser sampling time is resampled (see pilz::sampleTrajectory). The first trajectory
+   * is resampled from the last waypoint outside of the blend sphere to its end, the second trajectory from its
+   * start to the waypoint after the first waypoint outside of the blend sphere. The other waypoints are shared
+   * with the original trajectories. The remainder of the second trajectory returned by blend() consists of the
+   * original waypoints, so that a following blend resamples its own window.
+   * @param req: trajectory blend request
+   * @param sampling_time: sampling time of the blend trajectory
+   * @param resampled_req: copy of req with the resampled trajectories
+   * @return false if the first trajectory does not intersect with the blend sphere
+   */
+  bool resampleBlendWindows(const pilz::TrajectoryBlendRequest& req,
+                            double sampling_time,
+                            pilz::TrajectoryBlendRequest& resampled_req) const;
+
+  /**
+   * @brief Computes the center of the blend sphere, the position of the target link at the end of the
+   * first trajectory.
+   *
+   * The pose is computed on a copy of the last waypoint, because the waypoint might be shared with
+   * trajectories which are blended concurrently and its transforms might not be up to date.
+   */
+  Eigen::Vector3d blendSphereCenter(const pilz::TrajectoryBlendRequest& req) const;
+
   /**
    * @brief searchBlendPoint
    * @param req: trajectory blend request
+   * @param first_poses: filled with the poses of the target link for the waypoints of the first trajectory
+   * which are inside the blend sphere
+   * @param second_poses: filled with the poses of the target link for the waypoints of the second trajectory
+   * which are inside the blend sphere
    * @param first_interse_index: index of the first point of the first trajectory that is inside the blend sphere
    * @param second_interse_index: index of the last point of the second trajectory that is still inside the blend sphere
    */
   bool searchIntersectionPoints(const pilz::TrajectoryBlendRequest& req,
+                                pilz::LinkPoses& first_poses,
+                                pilz::LinkPoses& second_poses,
                                 std::size_t& first_interse_index,
                                 std::size_t& second_interse_index) const;
 
@@ -123,6 +162,8 @@ private:
    * @brief blend two trajectories in Cartesian space, result in a MultiDOFJointTrajectory which consists
    * of a list of transforms for the blend phase.
    * @param req
+   * @param first_poses: poses of the target link on the first trajectory inside the blend sphere
+   * @param second_poses: poses of the target link on the second trajectory inside the blend sphere
    * @param first_interse_index
    * @param second_interse_index
    * @param blend_begin_index
@@ -130,6 +171,8 @@ private:
    * @param trajectory: the resulting blend trajectory inside the blending sphere
    */
   void blendTrajectoryCartesian(const pilz::TrajectoryBlendRequest& req,
+                                const pilz::LinkPoses& first_poses,
+                                const pilz::LinkPoses& second_poses,
                                 const std::size_t first_interse_index,
                                 const std::size_t second_interse_index,
                                 const std::size_t blend_align_index,
@@ -19,17 +19,24 @@
 #define TRAJECTORY_FUNCTIONS_H
 
 #include <Eigen/Geometry>
+#include <Eigen/StdVector>
 #include <kdl/trajectory.hpp>
+#include <kdl/velocityprofile.hpp>
 #include <moveit/robot_model/robot_model.h>
 #include <moveit/robot_state/robot_state.h>
 #include <eigen_conversions/eigen_kdl.h>
 #include <eigen_conversions/eigen_msg.h>
 #include <trajectory_msgs/MultiDOFJointTrajectory.h>
+#include <moveit_msgs/Constraints.h>
 #include <moveit/robot_trajectory/robot_trajectory.h>
 #include <tf/transform_datatypes.h>
+#include <ros/time.h>
 
 #include "pilz_trajectory_generation/limits_container.h"
+#include "pilz_trajectory_generation/cancellation_token.h"
+#include "pilz_trajectory_generation/cartesian_path.h"
 #include "pilz_trajectory_generation/cartesian_trajectory.h"
+#include "pilz_trajectory_generation/planning_core.h"
 
 
 namespace pilz {
@@ -67,6 +74,22 @@ bool computePoseIK(const robot_model::RobotModelConstPtr& robot_model,
                    bool check_self_collision = true,
                    const double timeout = 0.1);
 
+/**
+ * @brief compute the joint positions of the Cartesian goal of a PTP request
+ * (the pose of the first position/orientation constraint minus the target point offset)
+ * @param robot_model: kinematic model of the robot
+ * @param group_name: name of planning group
+ * @param goal: goal constraints containing a position and an orientation constraint
+ * @param seed: seed state of IK solver (the start positions of the request)
+ * @param solution: solution of IK
+ * @return true if succeed
+ */
+bool computePTPGoalIK(const robot_model::RobotModelConstPtr& robot_model,
+                      const std::string& group_name,
+                      const moveit_msgs::Constraints& goal,
+                      const std::map<std::string, double>& seed,
+                      std::map<std::string, double>& solution);
+
 /**
  * @brief compute the pose of a link at give robot state
  * @param robot_model: kinematic model of the robot
@@ -119,6 +142,10 @@ bool verifySampleJointLimits(const std::map<std::string, double>& position_last,
  * and acceleration
  * @param error_code: detailed error information
  * @param check_self_collision: check for self collision during creation
+ * @param cancellation_token: optional token checked before each sample,
+ * moveit_msgs::MoveItErrorCodes::PREEMPTED if cancelled
+ * @param deadline: optional deadline (zero: none), the IK timeouts are reduced to meet it,
+ * moveit_msgs::MoveItErrorCodes::TIMED_OUT if it is exceeded
  * @return true if succeed
  */
 bool generateJointTrajectory(const robot_model::RobotModelConstPtr& robot_model,
@@ -130,7 +157,32 @@ bool generateJointTrajectory(const robot_model::RobotModelConstPtr& robot_model,
                              const double& sampling_time,
                              trajectory_msgs::JointTrajectory& joint_trajectory,
                              moveit_msgs::MoveItErrorCodes& error_code,
-                             bool check_self_collision = false);
+                             bool check_self_collision = false,
+                             const CancellationToken* cancellation_token = nullptr,
+                             const ros::Time& deadline = ros::Time());
+
+/**
+ * @brief Generate joint trajectory from a Cartesian path and a velocity profile along the path
+ *
+ * All sample poses are evaluated at once before the inverse kinematics is solved for each of them.
+ * @param path: Cartesian path
+ * @param velocity_profile: profile of the path parameter over time
+ *
+ * The other parameters and the return value are the same as for the KDL Cartesian trajectory.
+ */
+bool generateJointTrajectory(const robot_model::RobotModelConstPtr& robot_model,
+                             const JointLimitsContainer& joint_limits,
+                             const CartesianPath& path,
+                             const KDL::VelocityProfile& velocity_profile,
+                             const std::string& group_name,
+                             const std::string& link_name,
+                             const std::map<std::string, double>& initial_joint_position,
+                             const double& sampling_time,
+                             trajectory_msgs::JointTrajectory& joint_trajectory,
+                             moveit_msgs::MoveItErrorCodes& error_code,
+                             bool check_self_collision = false,
+                             const CancellationToken* cancellation_token = nullptr,
+                             const ros::Time& deadline = ros::Time());
 
 /**
  * @brief Generate joint trajectory from a MultiDOFJointTrajectory
@@ -139,6 +191,11 @@ bool generateJointTrajectory(const robot_model::RobotModelConstPtr& robot_model,
  * @param sampling_time
  * @param joint_trajectory
  * @param error_code
+ * @param check_self_collision
+ * @param cancellation_token: optional token checked before each sample,
+ * moveit_msgs::MoveItErrorCodes::PREEMPTED if cancelled
+ * @param deadline: optional deadline (zero: none), the IK timeouts are reduced to meet it,
+ * moveit_msgs::MoveItErrorCodes::TIMED_OUT if it is exceeded
  * @return true if succeed
  */
 bool generateJointTrajectory(const robot_model::RobotModelConstPtr& robot_model,
@@ -150,19 +207,38 @@ bool generateJointTrajectory(const robot_model::RobotModelConstPtr& robot_model,
                              const std::map<std::string, double>& initial_joint_velocity,
                              trajectory_msgs::JointTrajectory& joint_trajectory,
                              moveit_msgs::MoveItErrorCodes& error_code,
-                             bool check_self_collision = false);
+                             bool check_self_collision = false,
+                             const CancellationToken* cancellation_token = nullptr,
+                             const ros::Time& deadline = ros::Time());
+
 
+/**
+ * @brief Determines the uniform sampling time of a single trajectory.
+ * @param sampling_time Set to 0 if the trajectory does not have enough points to determine
+ * the sampling time.
+ * @return TRUE if the sampling time is equal between all given points (except the last two points),
+ * otherwise FALSE.
+ */
+bool determineSamplingTime(const robot_trajectory::RobotTrajectoryPtr& trajectory,
+                           double EPSILON,
+                           double& sampling_time);
 
 /**
- * @brief Determines the sampling time and checks that both trajectroies use the
- * same sampling time.
- * @return TRUE if the sampling time is equal between all given points (except the last two points
- * of each trajectory), otherwise FALSE.
+ * @brief Samples a trajectory at the given points in time.
+ *
+ * The joint positions, velocities and accelerations of the planning group are interpolated by the
+ * quintic polynomial which matches the positions, velocities and accelerations of the two enclosing
+ * waypoints, so that the sampled values are consistent with each other. Sample times outside of the
+ * trajectory yield copies of the first respectively last waypoint.
+ * @param traj The trajectory.
+ * @param group_name Name of the planning group.
+ * @param times Sample times (relative to the start of the trajectory) in increasing order.
+ * @param states Filled with one new robot state per sample time.
  */
-bool determineAndCheckSamplingTime(const robot_trajectory::RobotTrajectoryPtr& first_trajectory,
-                                   const robot_trajectory::RobotTrajectoryPtr& second_trajectory,
-                                   double EPSILON,
-                                   double& sampling_time);
+void sampleTrajectory(const robot_trajectory::RobotTrajectory& traj,
+                      const std::string& group_name,
+                      const std::vector<double>& times,
+                      std::vector<robot_state::RobotStatePtr>& states);
 
 /**
  * @brief Check if the two robot states have the same joint position/velocity/acceleration.
@@ -191,21 +267,38 @@ bool isRobotStateStationary(const robot_state::RobotState& state,
 
 
 /**
- * @brief Performs a linear search for the intersection point of the trajectory with the blending radius.
+ * @brief Translations and orientations of one link for all waypoints of a trajectory.
+ *
+ * Both containers have one entry per waypoint, so that repeated pose queries
+ * (e.g. during blending) do not need to access the robot states again.
+ */
+struct LinkPoses
+{
+  std::vector<Eigen::Vector3d> translations;
+  std::vector<Eigen::Quaterniond, Eigen::aligned_allocator<Eigen::Quaterniond> > orientations;
+};
+
+/**
+ * @brief Searches the intersection point of the trajectory with the blending sphere, starting at the
+ * sphere center. The link poses are only evaluated for the waypoints visited by the search.
+ * @param traj The trajectory.
+ * @param link_name Name of the link (or attached body) which is checked against the sphere.
  * @param center_position Center of blending sphere.
  * @param r Radius of blending sphere.
- * @param traj The trajectory.
  * @param inverseOrder TRUE: Farthest element from blending sphere center is located at the
  * smallest index of trajectroy.
+ * @param poses Resized to the number of waypoints. On success, the entries of all waypoints from the
+ * sphere center up to and including the first waypoint outside of the sphere hold the link poses,
+ * all other entries are unspecified.
  * @param index The intersection index which has to be determined.
  */
-bool linearSearchIntersectionPoint(const std::string &link_name,
-                                   const Eigen::Vector3d &center_position,
-                                   const double &r,
-                                   const robot_trajectory::RobotTrajectoryPtr& traj,
-                                   bool inverseOrder,
-                                   std::size_t &index);
-
+bool searchIntersectionPoint(const robot_trajectory::RobotTrajectory& traj,
+                             const std::string& link_name,
+                             const Eigen::Vector3d& center_position,
+                             const double& r,
+                             bool inverseOrder,
+                             LinkPoses& poses,
+                             std::size_t& index);
 
 bool intersectionFound(const Eigen::Vector3d &p_center,
                        const Eigen::Vector3d &p_current,
@@ -28,6 +28,7 @@
 #include <kdl/trajectory.hpp>
 
 #include "pilz_extensions/joint_limits_extension.h"
+#include "pilz_trajectory_generation/cancellation_token.h"
 #include "pilz_trajectory_generation/limits_container.h"
 #include "pilz_trajectory_generation/trajectory_functions.h"
 #include "pilz_trajectory_generation/trajectory_generation_exceptions.h"
@@ -65,6 +66,9 @@ CREATE_MOVEIT_ERROR_CODE_EXCEPTION(NoPrimitivePoseGiven, moveit_msgs::MoveItErro
  * @brief Base class of trajectory generators
  *
  * Note: All derived classes cannot have a start velocity
+ *
+ * Note: A generator is not thread-safe, each planning context owns its own generator.
+ * The robot model and the limits are not modified by the generators.
  */
 class TrajectoryGenerator
 {
@@ -79,16 +83,28 @@ public:
 
   virtual ~TrajectoryGenerator() = default;
 
+  //! Sampling time of the generated trajectories if none is specified
+  static constexpr double DEFAULT_SAMPLING_TIME {0.1};
+
   /**
    * @brief generate robot trajectory with given sampling time
    * @param req: motion plan request
    * @param res: motion plan response
    * @param sampling_time: sampling time of the generate trajectory
    * @return motion plan succeed/fail, detailed information in motion plan responce
+   *
+   * A positive req.allowed_planning_time limits the planning time. If it is exceeded,
+   * the generation fails with moveit_msgs::MoveItErrorCodes::TIMED_OUT.
    */
   bool generate(const planning_interface::MotionPlanRequest& req,
                 planning_interface::MotionPlanResponse&  res,
-                double sampling_time=0.1);
+                double sampling_time=DEFAULT_SAMPLING_TIME);
+
+  /**
+   * @brief Sets the token which cancels a running generate() with
+   * moveit_msgs::MoveItErrorCodes::PREEMPTED. The token has to outlive the generator.
+   */
+  void setCancellationToken(const CancellationToken* cancellation_token);
 
 protected:
   /**
@@ -104,18 +120,20 @@ protected:
     std::map<std::string, double> start_joint_position;
     std::map<std::string, double> goal_joint_position;
     std::pair<std::string, Eigen::Vector3d> circ_path_point;
+    //! Intermediate poses of the path (in the model frame).
+    PoseBuffer waypoints;
   };
 
   /**
    * @brief build cartesian velocity profile for the path
    *
-   * Uses the path to get the cartesian length and the angular distance from start to goal.
-   * The trap profile returns uses the longer distance of translational and rotational motion.
+   * The path length is the longer distance of translational and rotational motion
+   * (see CartesianPath::getLength()).
    */
   std::unique_ptr<KDL::VelocityProfile> cartesianTrapVelocityProfile(
       const double& max_velocity_scaling_factor,
       const double& max_acceleration_scaling_factor,
-      const std::unique_ptr<KDL::Path> &path) const;
+      const double path_length) const;
 
 private:
   virtual void cmdSpecificRequestValidation(const planning_interface::MotionPlanRequest &req) const;
@@ -227,11 +245,19 @@ private:
 protected:
   const robot_model::RobotModelConstPtr robot_model_;
   const pilz::LimitsContainer planner_limits_;
+  const CancellationToken* cancellation_token_ {nullptr};
+  //! Deadline of the running generate() call (zero if the planning time is not limited).
+  ros::Time deadline_;
   static constexpr double MIN_SCALING_FACTOR {0.0001};
   static constexpr double MAX_SCALING_FACTOR {1.};
   static constexpr double VELOCITY_TOLERANCE {1e-8};
 };
 
+inline void TrajectoryGenerator::setCancellationToken(const CancellationToken* cancellation_token)
+{
+  cancellation_token_ = cancellation_token;
+}
+
 inline bool TrajectoryGenerator::isScalingFactorValid(const double& scaling_factor)
 {
   return (scaling_factor > MIN_SCALING_FACTOR && scaling_factor <= MAX_SCALING_FACTOR);
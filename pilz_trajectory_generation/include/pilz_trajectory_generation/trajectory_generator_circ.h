@@ -19,9 +19,9 @@
 #define TRAJECTORY_GENERATOR_CIRC_H
 
 #include <eigen3/Eigen/Eigen>
-#include <kdl/path.hpp>
 #include <kdl/velocityprofile.hpp>
 
+#include "pilz_trajectory_generation/cartesian_path.h"
 #include "pilz_trajectory_generation/trajectory_generator.h"
 
 using namespace pilz_trajectory_generation;
@@ -76,7 +76,7 @@ private:
                     trajectory_msgs::JointTrajectory& joint_trajectory) override;
 
   /**
-   * @brief Construct a KDL::Path object for a Cartesian path of an arc.
+   * @brief Construct a CartesianPath object for a Cartesian path of an arc.
    *
    * @return A unique pointer of the path object, null_ptr in case of an error.
    *
@@ -88,7 +88,7 @@ private:
    * @throws CenterPointDifferentRadius if the distances between start-center
    * and goal-center are different.
    */
-  std::unique_ptr<KDL::Path> setPathCIRC(const MotionPlanInfo &info) const;
+  std::unique_ptr<CartesianPath> setPathCIRC(const MotionPlanInfo &info) const;
 
 
 };
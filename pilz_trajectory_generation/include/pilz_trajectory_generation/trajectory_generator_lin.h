@@ -19,8 +19,8 @@
 #define TRAJECTORY_GENERATOR_LIN_H
 
 #include <eigen3/Eigen/Eigen>
-#include <kdl/rotational_interpolation_sa.hpp>
 
+#include "pilz_trajectory_generation/cartesian_path.h"
 #include "pilz_trajectory_generation/trajectory_generator.h"
 #include "pilz_trajectory_generation/velocity_profile_atrap.h"
 
@@ -66,11 +66,11 @@ private:
                     trajectory_msgs::JointTrajectory& joint_trajectory) override;
 
   /**
-   * @brief construct a KDL::Path object for a Cartesian straight line
-   * @return a unique pointer of the path object. null_ptr in case of an error.
+   * @brief construct a CartesianPath object for a Cartesian straight line
+   * @return a unique pointer of the path object.
    */
-  std::unique_ptr<KDL::Path> setPathLIN(const Eigen::Affine3d& start_pose,
-                                        const Eigen::Affine3d& goal_pose) const;
+  std::unique_ptr<CartesianPath> setPathLIN(const Eigen::Isometry3d& start_pose,
+                                            const Eigen::Isometry3d& goal_pose) const;
 
 
 };
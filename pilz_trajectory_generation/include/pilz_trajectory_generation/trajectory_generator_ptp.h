@@ -56,7 +56,7 @@ private:
                                      MotionPlanInfo& info) const override;
 
   /**
-   * @brief plan ptp joint trajectory with zero start velocity
+   * @brief plan ptp joint trajectory with zero start velocity (see planPTPTrajectory())
    * @param start_pos
    * @param goal_pos
    * @param joint_trajectory
@@ -79,7 +79,6 @@ private:
                     trajectory_msgs::JointTrajectory& joint_trajectory) override;
 
 private:
-  const double MIN_MOVEMENT = 0.001;
   pilz::JointLimitsContainer joint_limits_;
   // most strict joint limits for each group
   std::map<std::string, pilz_extensions::JointLimit> most_strict_limits_;
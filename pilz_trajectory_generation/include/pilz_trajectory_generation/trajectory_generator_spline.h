@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2018 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRAJECTORY_GENERATOR_SPLINE_H
+#define TRAJECTORY_GENERATOR_SPLINE_H
+
+#include <eigen3/Eigen/Eigen>
+#include <kdl/velocityprofile.hpp>
+
+#include "pilz_trajectory_generation/cartesian_path.h"
+#include "pilz_trajectory_generation/trajectory_generator.h"
+
+using namespace pilz_trajectory_generation;
+
+namespace pilz
+{
+
+CREATE_MOVEIT_ERROR_CODE_EXCEPTION(SplineTrajectoryConversionFailure, moveit_msgs::MoveItErrorCodes::FAILURE);
+CREATE_MOVEIT_ERROR_CODE_EXCEPTION(WaypointOrientationMissing, moveit_msgs::MoveItErrorCodes::INVALID_MOTION_PLAN);
+CREATE_MOVEIT_ERROR_CODE_EXCEPTION(NoWaypointPrimitivePose, moveit_msgs::MoveItErrorCodes::INVALID_MOTION_PLAN);
+CREATE_MOVEIT_ERROR_CODE_EXCEPTION(WaypointsTooClose, moveit_msgs::MoveItErrorCodes::INVALID_MOTION_PLAN);
+
+CREATE_MOVEIT_ERROR_CODE_EXCEPTION(WaypointLinkNameMismatch, moveit_msgs::MoveItErrorCodes::INVALID_LINK_NAME);
+CREATE_MOVEIT_ERROR_CODE_EXCEPTION(SplineJointNumberMismatch, moveit_msgs::MoveItErrorCodes::INVALID_GOAL_CONSTRAINTS);
+CREATE_MOVEIT_ERROR_CODE_EXCEPTION(SplineJointMissingInStartState, moveit_msgs::MoveItErrorCodes::INVALID_ROBOT_STATE);
+CREATE_MOVEIT_ERROR_CODE_EXCEPTION(SplineInverseForGoalIncalculable, moveit_msgs::MoveItErrorCodes::NO_IK_SOLUTION);
+
+/**
+ * @brief This class implements a trajectory generator of smooth paths through multiple
+ * waypoints in Cartesian space (see CartesianPathSpline).
+ *
+ * The waypoints are given as pairs of position and orientation path constraints. The Cartesian
+ * trajectory is based on a trapezoid velocity profile, whose velocity is reduced to respect the
+ * Cartesian acceleration limit in the curves. If the resulting joint trajectory violates the
+ * joint limits, the trajectory is slowed down uniformly to meet them.
+ */
+class TrajectoryGeneratorSPLINE : public TrajectoryGenerator
+{
+public:
+  /**
+   * @brief Constructor of SPLINE Trajectory Generator
+   * @throw TrajectoryGeneratorInvalidLimitsException
+   * @param model: robot model
+   * @param planner_limits: limits in joint and Cartesian spaces
+   */
+  TrajectoryGeneratorSPLINE(const robot_model::RobotModelConstPtr& robot_model,
+                            const pilz::LimitsContainer& planner_limits);
+
+  virtual ~TrajectoryGeneratorSPLINE() = default;
+
+private:
+  /**
+   * @brief Checks that each waypoint consists of a position constraint with a primitive pose
+   * and an orientation constraint.
+   */
+  virtual void cmdSpecificRequestValidation(const planning_interface::MotionPlanRequest &req) const override;
+
+  virtual void extractMotionPlanInfo(const planning_interface::MotionPlanRequest& req,
+                                     MotionPlanInfo& info) const final override;
+
+  virtual void plan(const planning_interface::MotionPlanRequest &req,
+                    const MotionPlanInfo& plan_info,
+                    const double& sampling_time,
+                    trajectory_msgs::JointTrajectory& joint_trajectory) override;
+
+  /**
+   * @brief Construct the spline through the start pose, the waypoints and the goal pose.
+   *
+   * @throws WaypointsTooClose if consecutive positions are too close to each other.
+   */
+  std::unique_ptr<CartesianPathSpline> setPathSPLINE(const MotionPlanInfo& info) const;
+
+  /**
+   * @brief Samples the Cartesian trajectory and computes the joint trajectory.
+   *
+   * @throws SplineTrajectoryConversionFailure on failure.
+   */
+  void sampleJointTrajectory(const MotionPlanInfo& plan_info,
+                             const CartesianPath& path,
+                             const KDL::VelocityProfile& velocity_profile,
+                             const JointLimitsContainer& joint_limits,
+                             const double& sampling_time,
+                             trajectory_msgs::JointTrajectory& joint_trajectory) const;
+
+  /**
+   * @brief Returns the factor by which the joint trajectory has to be slowed down uniformly
+   * to meet the joint velocity/acceleration/deceleration limits (at least 1).
+   */
+  static double computeJointLimitsScaling(const trajectory_msgs::JointTrajectory& joint_trajectory,
+                                          const JointLimitsContainer& joint_limits,
+                                          const double& sampling_time);
+
+private:
+  //! Minimal distance between consecutive waypoints.
+  static constexpr double MIN_WAYPOINT_DISTANCE {1e-5};
+  //! Additional slow down, because the slowed down trajectory is sampled at different points.
+  static constexpr double JOINT_LIMITS_SCALING_MARGIN {1.05};
+};
+
+}
+
+#endif // TRAJECTORY_GENERATOR_SPLINE_H
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2018 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef VIA_POINT_TRAJECTORY_H
+#define VIA_POINT_TRAJECTORY_H
+
+#include <vector>
+
+#include <moveit/robot_state/robot_state.h>
+#include <moveit/robot_trajectory/robot_trajectory.h>
+
+#include "pilz_trajectory_generation/joint_limits_container.h"
+
+namespace pilz
+{
+
+/**
+ * @brief Velocity and acceleration scaling of the segment between two waypoints.
+ */
+struct ViaPointScaling
+{
+  double velocity {1.};
+  double acceleration {1.};
+};
+
+/**
+ * @brief Generate one joint trajectory passing all waypoints without stopping at the via points
+ *
+ * Each segment between two waypoints is a quintic polynomial per joint with zero acceleration at both ends,
+ * so the acceleration is continuous at the via points. The velocity of a joint at a via point
+ * is the harmonic mean of its average velocities in the neighbouring segments (zero, if the joint changes its
+ * direction), so that no joint overshoots a waypoint. The segment durations are the shortest durations
+ * (determined iteratively) for which the common velocity and acceleration limits of the group joints,
+ * scaled by the factors of the segment, are met. The trajectory starts and stops with zero velocity
+ * and zero acceleration.
+ *
+ * @param joint_limits: joint limits
+ * @param group_name: name of the planning group
+ * @param waypoints: start state, via points and goal state (at least two states)
+ * @param scaling: scaling factors of each segment (one less than waypoints)
+ * @param sampling_time: sampling time of the generated trajectory (the last sample may be shorter)
+ * @param trajectory: output, the waypoints are appended
+ * @return true if succeed, false if the input is invalid or the group joints have no velocity/acceleration limits
+ */
+bool generateViaPointTrajectory(const JointLimitsContainer& joint_limits,
+                                const std::string& group_name,
+                                const std::vector<robot_state::RobotStateConstPtr>& waypoints,
+                                const std::vector<ViaPointScaling>& scaling,
+                                const double sampling_time,
+                                robot_trajectory::RobotTrajectory& trajectory);
+
+}
+
+#endif // VIA_POINT_TRAJECTORY_H
@@ -0,0 +1,403 @@
+/*
+ * Copyright (c) 2018 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pilz_trajectory_generation/batch_planner.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <sstream>
+#include <thread>
+
+#include <geometry_msgs/PoseStamped.h>
+#include <moveit/kinematic_constraints/utils.h>
+#include <moveit/robot_state/conversions.h>
+#include <moveit/robot_state/robot_state.h>
+#include <rosbag/bag.h>
+#include <rosbag/view.h>
+
+namespace pilz_trajectory_generation
+{
+
+static const std::string RESPONSES_TOPIC {"responses"};
+
+namespace
+{
+
+double toDouble(XmlRpc::XmlRpcValue& value, const std::string& description)
+{
+  if(value.getType() == XmlRpc::XmlRpcValue::TypeInt)
+  {
+    return static_cast<int>(value);
+  }
+  if(value.getType() == XmlRpc::XmlRpcValue::TypeDouble)
+  {
+    return static_cast<double>(value);
+  }
+  throw InvalidSequenceDescription(description + " is not a number");
+}
+
+std::vector<double> toDoubles(XmlRpc::XmlRpcValue& value, const std::string& description)
+{
+  if(value.getType() != XmlRpc::XmlRpcValue::TypeArray)
+  {
+    throw InvalidSequenceDescription(description + " is not a list");
+  }
+
+  std::vector<double> values;
+  for(int i = 0; i < value.size(); ++i)
+  {
+    values.push_back(toDouble(value[i], description));
+  }
+  return values;
+}
+
+std::string toString(XmlRpc::XmlRpcValue& value, const std::string& description)
+{
+  if(value.getType() != XmlRpc::XmlRpcValue::TypeString)
+  {
+    throw InvalidSequenceDescription(description + " is not a string");
+  }
+  return static_cast<std::string>(value);
+}
+
+//! Converts [x, y, z, qx, qy, qz, qw] into a pose.
+geometry_msgs::Pose toPose(XmlRpc::XmlRpcValue& value, const std::string& description)
+{
+  const std::vector<double> values {toDoubles(value, description)};
+  if(values.size() != 7)
+  {
+    throw InvalidSequenceDescription(description + " needs 7 values [x, y, z, qx, qy, qz, qw]");
+  }
+
+  geometry_msgs::Pose pose;
+  pose.position.x = values.at(0);
+  pose.position.y = values.at(1);
+  pose.position.z = values.at(2);
+  pose.orientation.x = values.at(3);
+  pose.orientation.y = values.at(4);
+  pose.orientation.z = values.at(5);
+  pose.orientation.w = values.at(6);
+  return pose;
+}
+
+//! Returns the default state of the model with the specified positions of the joints of the group.
+robot_state::RobotState toRobotState(XmlRpc::XmlRpcValue& value,
+                                     const robot_model::RobotModelConstPtr& model,
+                                     const robot_model::JointModelGroup* group,
+                                     const std::string& description)
+{
+  const std::vector<double> positions {toDoubles(value, description)};
+  if(positions.size() != group->getVariableCount())
+  {
+    std::ostringstream os;
+    os << description << " needs " << group->getVariableCount() << " values for the group "
+       << group->getName() << " (found " << positions.size() << ")";
+    throw InvalidSequenceDescription(os.str());
+  }
+
+  robot_state::RobotState state(model);
+  state.setToDefaultValues();
+  state.setJointGroupPositions(group, positions);
+  return state;
+}
+
+moveit_msgs::PositionConstraint toPositionConstraint(const geometry_msgs::Point& position,
+                                                     const std::string& link_name,
+                                                     const std::string& frame_id)
+{
+  moveit_msgs::PositionConstraint position_constraint;
+  position_constraint.header.frame_id = frame_id;
+  position_constraint.link_name = link_name;
+  geometry_msgs::Pose primitive_pose;
+  primitive_pose.position = position;
+  primitive_pose.orientation.w = 1.;
+  position_constraint.constraint_region.primitive_poses.push_back(primitive_pose);
+  return position_constraint;
+}
+
+pilz_msgs::MotionSequenceItem toSequenceItem(XmlRpc::XmlRpcValue& item,
+                                             const robot_model::RobotModelConstPtr& model,
+                                             const std::string& description)
+{
+  if(item.getType() != XmlRpc::XmlRpcValue::TypeStruct)
+  {
+    throw InvalidSequenceDescription(description + " is not a dictionary");
+  }
+  for(const std::string& member : {"planner_id", "group_name"})
+  {
+    if(!item.hasMember(member))
+    {
+      throw InvalidSequenceDescription(description + " has no " + member);
+    }
+  }
+
+  pilz_msgs::MotionSequenceItem sequence_item;
+  moveit_msgs::MotionPlanRequest& req {sequence_item.req};
+  req.planner_id = toString(item["planner_id"], description + ": planner_id");
+  req.group_name = toString(item["group_name"], description + ": group_name");
+
+  const robot_model::JointModelGroup* group {model->getJointModelGroup(req.group_name)};
+  if(!group)
+  {
+    throw InvalidSequenceDescription(description + ": unknown group " + req.group_name);
+  }
+
+  sequence_item.blend_radius = item.hasMember("blend_radius") ?
+        toDouble(item["blend_radius"], description + ": blend_radius") : 0.;
+  req.max_velocity_scaling_factor = item.hasMember("velocity_scaling") ?
+        toDouble(item["velocity_scaling"], description + ": velocity_scaling") : 1.;
+  req.max_acceleration_scaling_factor = item.hasMember("acceleration_scaling") ?
+        toDouble(item["acceleration_scaling"], description + ": acceleration_scaling") : 1.;
+
+  if(item.hasMember("start_joints"))
+  {
+    moveit::core::robotStateToRobotStateMsg(toRobotState(item["start_joints"], model, group,
+                                                         description + ": start_joints"),
+                                            req.start_state, false);
+  }
+
+  const std::string link_name {item.hasMember("link_name") ?
+          toString(item["link_name"], description + ": link_name") : ""};
+
+  if(item.hasMember("joints") == item.hasMember("pose"))
+  {
+    throw InvalidSequenceDescription(description + " needs either joints or pose as goal");
+  }
+  if(item.hasMember("joints"))
+  {
+    req.goal_constraints.push_back(kinematic_constraints::constructGoalConstraints(
+                                     toRobotState(item["joints"], model, group, description + ": joints"), group));
+  }
+  else
+  {
+    if(link_name.empty())
+    {
+      throw InvalidSequenceDescription(description + " needs a link_name for the goal pose");
+    }
+    geometry_msgs::PoseStamped goal_pose;
+    goal_pose.header.frame_id = model->getModelFrame();
+    goal_pose.pose = toPose(item["pose"], description + ": pose");
+    req.goal_constraints.push_back(kinematic_constraints::constructGoalConstraints(link_name, goal_pose));
+  }
+
+  // auxiliary point of the CIRC command
+  for(const std::string& name : {"center", "interim"})
+  {
+    if(!item.hasMember(name))
+    {
+      continue;
+    }
+    if(!req.path_constraints.name.empty())
+    {
+      throw InvalidSequenceDescription(description + " needs either center or interim, not both");
+    }
+    const std::vector<double> values {toDoubles(item[name], description + ": " + name)};
+    if(values.size() != 3)
+    {
+      throw InvalidSequenceDescription(description + ": " + name + " needs 3 values [x, y, z]");
+    }
+    geometry_msgs::Point point;
+    point.x = values.at(0);
+    point.y = values.at(1);
+    point.z = values.at(2);
+    req.path_constraints.name = name;
+    req.path_constraints.position_constraints.push_back(toPositionConstraint(point, link_name,
+                                                                             model->getModelFrame()));
+  }
+
+  // waypoints of the SPLINE command
+  if(item.hasMember("waypoints"))
+  {
+    XmlRpc::XmlRpcValue& waypoints {item["waypoints"]};
+    if(waypoints.getType() != XmlRpc::XmlRpcValue::TypeArray)
+    {
+      throw InvalidSequenceDescription(description + ": waypoints is not a list");
+    }
+    for(int i = 0; i < waypoints.size(); ++i)
+    {
+      const geometry_msgs::Pose waypoint {toPose(waypoints[i], description + ": waypoint " + std::to_string(i))};
+      req.path_constraints.position_constraints.push_back(toPositionConstraint(waypoint.position, link_name,
+                                                                               model->getModelFrame()));
+      moveit_msgs::OrientationConstraint orientation_constraint;
+      orientation_constraint.header.frame_id = model->getModelFrame();
+      orientation_constraint.link_name = link_name;
+      orientation_constraint.orientation = waypoint.orientation;
+      req.path_constraints.orientation_constraints.push_back(orientation_constraint);
+    }
+  }
+
+  return sequence_item;
+}
+
+} // namespace
+
+BatchPlanner::BatchPlanner(const ros::NodeHandle& nh,
+                           const robot_model::RobotModelConstPtr& model,
+                           const std::size_t num_threads)
+  : scene_(new planning_scene::PlanningScene(model))
+  , pipeline_(new planning_pipeline::PlanningPipeline(model, nh))
+{
+  if(!pipeline_->getPlannerManager())
+  {
+    throw PlanningPipelineException("Could not load the planner plugin of the planning pipeline");
+  }
+
+  scene_->getCurrentStateNonConst().setToDefaultValues();
+
+  for(std::size_t i = 0; i < std::max(num_threads, std::size_t {1}); ++i)
+  {
+    managers_.emplace_back(new CommandListManager(nh, model));
+  }
+}
+
+std::vector<pilz_msgs::MotionSequenceResponse> BatchPlanner::plan(
+    const std::vector<pilz_msgs::MotionSequenceRequest>& sequences)
+{
+  std::vector<pilz_msgs::MotionSequenceResponse> responses(sequences.size());
+  std::atomic<std::size_t> next_index {0};
+  auto worker = [&](CommandListManager& manager)
+  {
+    for(std::size_t i = next_index++; i < sequences.size(); i = next_index++)
+    {
+      pilz_msgs::MotionSequenceResponse& res {responses.at(i)};
+      const auto planning_start {std::chrono::steady_clock::now()};
+      try
+      {
+        const RobotTrajCont traj_vec {manager.solve(scene_, pipeline_, sequences.at(i))};
+        res.trajectory_start.resize(traj_vec.size());
+        res.planned_trajectory.resize(traj_vec.size());
+        for(RobotTrajCont::size_type j = 0; j < traj_vec.size(); ++j)
+        {
+          moveit::core::robotStateToRobotStateMsg(traj_vec.at(j)->getFirstWayPoint(), res.trajectory_start.at(j));
+          traj_vec.at(j)->getRobotTrajectoryMsg(res.planned_trajectory.at(j));
+        }
+        res.error_code.val = moveit_msgs::MoveItErrorCodes::SUCCESS;
+      }
+      catch(const MoveItErrorCodeException& ex)
+      {
+        ROS_ERROR_STREAM("Planning of sequence " << i << " failed (error code: "
+                         << ex.getErrorCode() << "): " << ex.what());
+        res.error_code.val = ex.getErrorCode();
+      }
+      catch(const std::exception& ex)
+      {
+        ROS_ERROR_STREAM("Planning of sequence " << i << " failed: " << ex.what());
+        res.error_code.val = moveit_msgs::MoveItErrorCodes::FAILURE;
+      }
+      res.planning_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - planning_start).count();
+    }
+  };
+
+  const std::size_t num_threads {std::min(managers_.size(), sequences.size())};
+  std::vector<std::thread> threads;
+  for(std::size_t i = 1; i < num_threads; ++i)
+  {
+    threads.emplace_back(worker, std::ref(*managers_.at(i)));
+  }
+  worker(*managers_.front());
+  for(auto& thread : threads)
+  {
+    thread.join();
+  }
+  return responses;
+}
+
+std::vector<pilz_msgs::MotionSequenceRequest> BatchPlanner::readSequences(XmlRpc::XmlRpcValue& sequences,
+                                                                          const robot_model::RobotModelConstPtr& model)
+{
+  if(sequences.getType() != XmlRpc::XmlRpcValue::TypeArray)
+  {
+    throw InvalidSequenceDescription("The sequences are not a list");
+  }
+
+  std::vector<pilz_msgs::MotionSequenceRequest> requests;
+  for(int i = 0; i < sequences.size(); ++i)
+  {
+    const std::string description {"Sequence " + std::to_string(i)};
+    XmlRpc::XmlRpcValue& items {sequences[i]};
+    if(items.getType() != XmlRpc::XmlRpcValue::TypeArray || items.size() == 0)
+    {
+      throw InvalidSequenceDescription(description + " is not a list of sequence items");
+    }
+
+    pilz_msgs::MotionSequenceRequest request;
+    for(int j = 0; j < items.size(); ++j)
+    {
+      request.items.push_back(toSequenceItem(items[j], model, description + ", item " + std::to_string(j)));
+    }
+    requests.push_back(request);
+  }
+  return requests;
+}
+
+std::vector<pilz_msgs::MotionSequenceRequest> BatchPlanner::readSequencesFromBag(const std::string& file_name)
+{
+  rosbag::Bag bag(file_name, rosbag::bagmode::Read);
+  rosbag::View view(bag, rosbag::TypeQuery(ros::message_traits::datatype<pilz_msgs::MotionSequenceRequest>()));
+
+  std::vector<pilz_msgs::MotionSequenceRequest> requests;
+  for(const rosbag::MessageInstance& message : view)
+  {
+    const pilz_msgs::MotionSequenceRequest::ConstPtr request {message.instantiate<pilz_msgs::MotionSequenceRequest>()};
+    if(request)
+    {
+      requests.push_back(*request);
+    }
+  }
+  return requests;
+}
+
+void BatchPlanner::writeResponsesToBag(const std::string& file_name,
+                                       const std::vector<pilz_msgs::MotionSequenceResponse>& responses)
+{
+  rosbag::Bag bag(file_name, rosbag::bagmode::Write);
+  for(std::size_t i = 0; i < responses.size(); ++i)
+  {
+    // distinct stamps keep the order of the responses when the bag is read
+    ros::Time stamp;
+    stamp.fromNSec(i + 1);
+    bag.write(RESPONSES_TOPIC, stamp, responses.at(i));
+  }
+}
+
+void BatchPlanner::writeStatistics(std::ostream& os, const std::vector<pilz_msgs::MotionSequenceResponse>& responses)
+{
+  os << "sequence,error_code,trajectories,cycle_time,planning_time\n";
+  for(std::size_t i = 0; i < responses.size(); ++i)
+  {
+    const pilz_msgs::MotionSequenceResponse& res {responses.at(i)};
+    os << i << "," << res.error_code.val << "," << res.planned_trajectory.size() << ","
+       << getCycleTime(res) << "," << res.planning_time << "\n";
+  }
+}
+
+double BatchPlanner::getCycleTime(const pilz_msgs::MotionSequenceResponse& response)
+{
+  double cycle_time {0.};
+  for(const auto& trajectory : response.planned_trajectory)
+  {
+    if(!trajectory.joint_trajectory.points.empty())
+    {
+      cycle_time += trajectory.joint_trajectory.points.back().time_from_start.toSec();
+    }
+  }
+  return cycle_time;
+}
+
+}
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2018 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <ros/ros.h>
+#include <moveit/robot_model_loader/robot_model_loader.h>
+
+#include "pilz_trajectory_generation/batch_planner.h"
+
+using namespace pilz_trajectory_generation;
+
+static const std::string PARAM_ROBOT_DESCRIPTION {"robot_description"};
+static const std::string PARAM_SEQUENCES {"sequences"};
+static const std::string PARAM_SEQUENCES_BAG {"sequences_bag"};
+static const std::string PARAM_OUTPUT_BAG {"output_bag"};
+static const std::string PARAM_STATISTICS_FILE {"statistics_file"};
+//! Number of sequences planned in parallel (default: 1). More than one thread requires that the
+//! planners and the IK solvers of the planning groups support concurrent calls.
+static const std::string PARAM_THREADS {"threads"};
+
+/**
+ * @brief Plans the sequences given by the parameter "~sequences" (usually loaded from a YAML file,
+ * see BatchPlanner::readSequences()) or by the bag file "~sequences_bag" offline, in parallel
+ * if "~threads" is greater than one.
+ *
+ * The responses are written to the bag file "~output_bag" and the statistics of each
+ * sequence to the CSV file "~statistics_file" (both optional).
+ */
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "pilz_batch_planner");
+  ros::NodeHandle ph("~");
+
+  robot_model_loader::RobotModelLoader model_loader(PARAM_ROBOT_DESCRIPTION);
+  const robot_model::RobotModelConstPtr model {model_loader.getModel()};
+  if(!model)
+  {
+    ROS_ERROR_STREAM("Could not load the robot model from the parameter " << PARAM_ROBOT_DESCRIPTION);
+    return EXIT_FAILURE;
+  }
+
+  std::vector<pilz_msgs::MotionSequenceRequest> sequences;
+  try
+  {
+    XmlRpc::XmlRpcValue sequences_param;
+    std::string sequences_bag;
+    if(ph.getParam(PARAM_SEQUENCES, sequences_param))
+    {
+      sequences = BatchPlanner::readSequences(sequences_param, model);
+    }
+    else if(ph.getParam(PARAM_SEQUENCES_BAG, sequences_bag))
+    {
+      sequences = BatchPlanner::readSequencesFromBag(sequences_bag);
+    }
+    else
+    {
+      ROS_ERROR_STREAM("Neither " << ph.resolveName(PARAM_SEQUENCES) << " nor "
+                       << ph.resolveName(PARAM_SEQUENCES_BAG) << " is set");
+      return EXIT_FAILURE;
+    }
+  }
+  catch(const std::exception& ex)
+  {
+    ROS_ERROR_STREAM("Could not read the sequences: " << ex.what());
+    return EXIT_FAILURE;
+  }
+
+  const int num_threads {std::max(1, ph.param(PARAM_THREADS, 1))};
+
+  std::vector<pilz_msgs::MotionSequenceResponse> responses;
+  const auto planning_start {std::chrono::steady_clock::now()};
+  try
+  {
+    BatchPlanner planner(ph, model, static_cast<std::size_t>(num_threads));
+    responses = planner.plan(sequences);
+  }
+  catch(const std::exception& ex)
+  {
+    ROS_ERROR_STREAM("Batch planning failed: " << ex.what());
+    return EXIT_FAILURE;
+  }
+  const double total_time {std::chrono::duration<double>(std::chrono::steady_clock::now() - planning_start).count()};
+
+  std::size_t num_successful {0};
+  double max_planning_time {0.};
+  double sum_planning_time {0.};
+  double sum_cycle_time {0.};
+  for(const auto& res : responses)
+  {
+    max_planning_time = std::max(max_planning_time, res.planning_time);
+    sum_planning_time += res.planning_time;
+    if(res.error_code.val == moveit_msgs::MoveItErrorCodes::SUCCESS)
+    {
+      ++num_successful;
+      sum_cycle_time += BatchPlanner::getCycleTime(res);
+    }
+  }
+
+  ROS_INFO_STREAM("Planned " << num_successful << " of " << responses.size() << " sequences successfully with "
+                  << num_threads << " threads in " << total_time << "s");
+  if(!responses.empty())
+  {
+    ROS_INFO_STREAM("Planning latency (mean/max): " << sum_planning_time / responses.size() << "s / "
+                    << max_planning_time << "s");
+  }
+  if(num_successful > 0)
+  {
+    ROS_INFO_STREAM("Mean cycle time of the successful sequences: " << sum_cycle_time / num_successful << "s");
+  }
+
+  std::string output_bag;
+  std::string statistics_file;
+  try
+  {
+    if(ph.getParam(PARAM_OUTPUT_BAG, output_bag) && !output_bag.empty())
+    {
+      BatchPlanner::writeResponsesToBag(output_bag, responses);
+      ROS_INFO_STREAM("Wrote the trajectories to " << output_bag);
+    }
+    if(ph.getParam(PARAM_STATISTICS_FILE, statistics_file) && !statistics_file.empty())
+    {
+      std::ofstream os(statistics_file);
+      if(!os)
+      {
+        ROS_ERROR_STREAM("Could not open " << statistics_file);
+        return EXIT_FAILURE;
+      }
+      BatchPlanner::writeStatistics(os, responses);
+      ROS_INFO_STREAM("Wrote the statistics to " << statistics_file);
+    }
+  }
+  catch(const std::exception& ex)
+  {
+    ROS_ERROR_STREAM("Could not write the results: " << ex.what());
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
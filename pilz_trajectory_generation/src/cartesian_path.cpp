@@ -0,0 +1,323 @@
+/*
+ * Copyright (c) 2018 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pilz_trajectory_generation/cartesian_path.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+
+#include <kdl/utilities/error.h>
+
+namespace pilz {
+
+SingleAxisRotation::SingleAxisRotation(const Eigen::Quaterniond& start_orientation,
+                                       const Eigen::Quaterniond& goal_orientation)
+  : start_orientation_(start_orientation.normalized())
+{
+  Eigen::Quaterniond relative_rotation {start_orientation_.conjugate() * goal_orientation.normalized()};
+  // rotate along the shorter way
+  if(relative_rotation.w() < 0.)
+  {
+    relative_rotation.coeffs() = -relative_rotation.coeffs();
+  }
+
+  const double sin_half_angle {relative_rotation.vec().norm()};
+  angle_ = 2. * std::atan2(sin_half_angle, relative_rotation.w());
+  if(sin_half_angle > 0.)
+  {
+    axis_ = relative_rotation.vec() / sin_half_angle;
+  }
+}
+
+Eigen::Quaterniond SingleAxisRotation::getOrientation(const double angle) const
+{
+  const double half_angle {0.5 * std::max(0., std::min(angle, angle_))};
+  const Eigen::Vector3d rotation_vector {axis_ * std::sin(half_angle)};
+  const Eigen::Quaterniond rotation {std::cos(half_angle),
+                                     rotation_vector.x(),
+                                     rotation_vector.y(),
+                                     rotation_vector.z()};
+  return start_orientation_ * rotation;
+}
+
+Eigen::Isometry3d CartesianPath::getPose(const double s) const
+{
+  PoseBuffer poses;
+  getPoses(std::vector<double> {s}, poses);
+  return poses.front();
+}
+
+CartesianPathSegment::CartesianPathSegment(const Eigen::Quaterniond& start_orientation,
+                                           const Eigen::Quaterniond& goal_orientation)
+  : rotation_(start_orientation, goal_orientation)
+{
+}
+
+void CartesianPathSegment::setScaling(const double distance, const double eqradius)
+{
+  const double rotation_angle {rotation_.getAngle()};
+  if(rotation_angle * eqradius > distance)
+  {
+    path_length_ = rotation_angle * eqradius;
+    scale_rot_ = 1. / eqradius;
+    scale_lin_ = distance / path_length_;
+  }
+  else if(distance > 0.)
+  {
+    path_length_ = distance;
+    scale_rot_ = rotation_angle / path_length_;
+    scale_lin_ = 1.;
+  }
+  else
+  {
+    path_length_ = 0.;
+    scale_rot_ = 1.;
+    scale_lin_ = 1.;
+  }
+}
+
+void CartesianPathSegment::getPoses(const std::vector<double>& path_params, PoseBuffer& poses) const
+{
+  poses.assign(path_params.size(), Eigen::Isometry3d::Identity());
+
+  for(std::size_t i = 0; i < path_params.size(); ++i)
+  {
+    poses[i].linear() = rotation_.getOrientation(path_params[i] * scale_rot_).toRotationMatrix();
+  }
+
+  setPositions(path_params, poses);
+}
+
+CartesianPathLine::CartesianPathLine(const Eigen::Isometry3d& start_pose,
+                                     const Eigen::Isometry3d& goal_pose,
+                                     const double eqradius)
+  : CartesianPathSegment(Eigen::Quaterniond(start_pose.linear()), Eigen::Quaterniond(goal_pose.linear()))
+  , start_position_(start_pose.translation())
+{
+  const Eigen::Vector3d difference {goal_pose.translation() - start_pose.translation()};
+  const double distance {difference.norm()};
+  if(distance > 0.)
+  {
+    direction_ = difference / distance;
+  }
+  setScaling(distance, eqradius);
+}
+
+void CartesianPathLine::setPositions(const std::vector<double>& path_params, PoseBuffer& poses) const
+{
+  for(std::size_t i = 0; i < path_params.size(); ++i)
+  {
+    poses[i].translation() = start_position_ + direction_ * toDistance(path_params[i]);
+  }
+}
+
+CartesianPathCircle::CartesianPathCircle(const Eigen::Isometry3d& start_pose,
+                                         const Eigen::Vector3d& center_point,
+                                         const Eigen::Vector3d& aux_point,
+                                         const Eigen::Quaterniond& goal_orientation,
+                                         const double alpha,
+                                         const double eqradius,
+                                         const double tolerance)
+  : CartesianPathSegment(Eigen::Quaterniond(start_pose.linear()), goal_orientation)
+  , center_(center_point)
+{
+  x_axis_ = start_pose.translation() - center_point;
+  radius_ = x_axis_.norm();
+  if(radius_ < tolerance)
+  {
+    throw KDL::Error_MotionPlanning_Circle_ToSmall();
+  }
+  x_axis_ /= radius_;
+
+  const Eigen::Vector3d z_axis {x_axis_.cross((aux_point - center_point).normalized())};
+  const double z_norm {z_axis.norm()};
+  if(z_norm < tolerance)
+  {
+    throw KDL::Error_MotionPlanning_Circle_No_Plane();
+  }
+  y_axis_ = (z_axis / z_norm).cross(x_axis_);
+
+  setScaling(alpha * radius_, eqradius);
+}
+
+void CartesianPathCircle::setPositions(const std::vector<double>& path_params, PoseBuffer& poses) const
+{
+  for(std::size_t i = 0; i < path_params.size(); ++i)
+  {
+    const double angle {toDistance(path_params[i]) / radius_};
+    poses[i].translation() = center_ + radius_ * (std::cos(angle) * x_axis_ + std::sin(angle) * y_axis_);
+  }
+}
+
+CartesianPathSpline::CartesianPathSpline(const PoseBuffer& poses,
+                                         const double eqradius,
+                                         const double tolerance)
+{
+  if(poses.size() < 2)
+  {
+    throw std::invalid_argument("A spline needs at least two poses.");
+  }
+
+  const std::size_t num_sections {poses.size() - 1};
+  std::vector<double> parameter_ranges(num_sections);
+  for(std::size_t i = 0; i < num_sections; ++i)
+  {
+    parameter_ranges[i] = (poses[i + 1].translation() - poses[i].translation()).norm();
+    if(parameter_ranges[i] < tolerance)
+    {
+      std::ostringstream os;
+      os << "The positions of pose " << i << " and pose " << i + 1 << " of the spline are too close.";
+      throw std::invalid_argument(os.str());
+    }
+  }
+
+  // Second derivatives at the poses, zero at start and goal (natural spline).
+  // The inner ones are the solution of a tridiagonal system, solved by the Thomas algorithm.
+  std::vector<Eigen::Vector3d> second_derivatives(poses.size(), Eigen::Vector3d::Zero());
+  std::vector<double> upper(poses.size(), 0.);
+  std::vector<Eigen::Vector3d> rhs(poses.size(), Eigen::Vector3d::Zero());
+  for(std::size_t i = 1; i < num_sections; ++i)
+  {
+    const double lower {parameter_ranges[i - 1]};
+    const Eigen::Vector3d slope_diff {
+      (poses[i + 1].translation() - poses[i].translation()) / parameter_ranges[i]
+          - (poses[i].translation() - poses[i - 1].translation()) / parameter_ranges[i - 1]};
+    const double diagonal {2. * (parameter_ranges[i - 1] + parameter_ranges[i]) - lower * upper[i - 1]};
+    upper[i] = parameter_ranges[i] / diagonal;
+    rhs[i] = (6. * slope_diff - lower * rhs[i - 1]) / diagonal;
+  }
+  for(std::size_t i = num_sections - 1; i > 0; --i)
+  {
+    second_derivatives[i] = rhs[i] - upper[i] * second_derivatives[i + 1];
+  }
+
+  for(std::size_t i = 0; i < num_sections; ++i)
+  {
+    const double h {parameter_ranges[i]};
+    const Eigen::Vector3d& p_start {poses[i].translation()};
+    const Eigen::Vector3d& p_end {poses[i + 1].translation()};
+    const Eigen::Vector3d& m_start {second_derivatives[i]};
+    const Eigen::Vector3d& m_end {second_derivatives[i + 1]};
+
+    Section section {0., 1., 1.,
+                     {{p_start,
+                       (p_end - p_start) / h - h * (2. * m_start + m_end) / 6.,
+                       0.5 * m_start,
+                       (m_end - m_start) / (6. * h)}},
+                     h,
+                     std::vector<double>(NUM_ARC_LENGTH_INTERVALS + 1, 0.),
+                     SingleAxisRotation(Eigen::Quaterniond(poses[i].linear()),
+                                        Eigen::Quaterniond(poses[i + 1].linear()))};
+
+    Eigen::Vector3d last_position {p_start};
+    for(std::size_t k = 0; k <= NUM_ARC_LENGTH_INTERVALS; ++k)
+    {
+      const double u {h * static_cast<double>(k) / NUM_ARC_LENGTH_INTERVALS};
+      const Eigen::Vector3d position {getPosition(section, u)};
+      if(k > 0)
+      {
+        section.arc_lengths[k] = section.arc_lengths[k - 1] + (position - last_position).norm();
+      }
+      last_position = position;
+
+      const Eigen::Vector3d first_derivative {getFirstDerivative(section, u)};
+      const double speed {first_derivative.norm()};
+      if(speed > 0.)
+      {
+        max_curvature_ = std::max(max_curvature_,
+                                  first_derivative.cross(getSecondDerivative(section, u)).norm()
+                                  / (speed * speed * speed));
+      }
+    }
+
+    // same scaling as for a single segment
+    const double distance {section.arc_lengths.back()};
+    const double rotation_angle {section.rotation.getAngle()};
+    double section_length {distance};
+    if(rotation_angle * eqradius > distance)
+    {
+      section_length = rotation_angle * eqradius;
+      section.scale_rot = 1. / eqradius;
+      section.scale_lin = distance / section_length;
+    }
+    else
+    {
+      section.scale_rot = rotation_angle / section_length;
+    }
+
+    section.start = path_length_;
+    path_length_ += section_length;
+    sections_.push_back(section);
+  }
+}
+
+void CartesianPathSpline::getPoses(const std::vector<double>& path_params, PoseBuffer& poses) const
+{
+  poses.assign(path_params.size(), Eigen::Isometry3d::Identity());
+
+  for(std::size_t i = 0; i < path_params.size(); ++i)
+  {
+    const double s {std::max(0., std::min(path_params[i], path_length_))};
+    auto section_it {std::upper_bound(sections_.cbegin(), sections_.cend(), s,
+                                      [](const double value, const Section& section)
+                                      { return value < section.start; })};
+    const Section& section {*std::prev(section_it)};
+
+    const double local_s {s - section.start};
+    poses[i].translation() = getPosition(section, toSplineParameter(section, local_s * section.scale_lin));
+    poses[i].linear() = section.rotation.getOrientation(local_s * section.scale_rot).toRotationMatrix();
+  }
+}
+
+Eigen::Vector3d CartesianPathSpline::getPosition(const Section& section, const double u) const
+{
+  const auto& c = section.coefficients;
+  return c[0] + u * (c[1] + u * (c[2] + u * c[3]));
+}
+
+Eigen::Vector3d CartesianPathSpline::getFirstDerivative(const Section& section, const double u) const
+{
+  const auto& c = section.coefficients;
+  return c[1] + u * (2. * c[2] + 3. * u * c[3]);
+}
+
+Eigen::Vector3d CartesianPathSpline::getSecondDerivative(const Section& section, const double u) const
+{
+  const auto& c = section.coefficients;
+  return 2. * c[2] + 6. * u * c[3];
+}
+
+double CartesianPathSpline::toSplineParameter(const Section& section, const double distance) const
+{
+  const std::vector<double>& arc_lengths {section.arc_lengths};
+  auto it {std::upper_bound(arc_lengths.cbegin(), arc_lengths.cend(), distance)};
+  if(it == arc_lengths.cend())
+  {
+    return section.parameter_range;
+  }
+
+  // interpolate linearly within the interval
+  const std::size_t k {static_cast<std::size_t>(it - arc_lengths.cbegin())};
+  const double interval_length {arc_lengths[k] - arc_lengths[k - 1]};
+  const double fraction {interval_length > 0. ? (distance - arc_lengths[k - 1]) / interval_length : 0.};
+  return section.parameter_range * (static_cast<double>(k - 1) + fraction) / NUM_ARC_LENGTH_INTERVALS;
+}
+
+} // namespace pilz
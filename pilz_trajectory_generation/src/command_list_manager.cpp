@@ -17,45 +17,113 @@
 
 #include "pilz_trajectory_generation/command_list_manager.h"
 
+#include <algorithm>
+#include <atomic>
 #include <sstream>
 #include <functional>
 #include <cassert>
+#include <limits>
+#include <map>
+#include <thread>
+#include <unordered_set>
 
 #include <ros/ros.h>
+#include <ros/serialization.h>
+#include <geometric_shapes/shapes.h>
 #include <moveit/planning_pipeline/planning_pipeline.h>
+#include <moveit/robot_state/attached_body.h>
 #include <moveit/robot_state/conversions.h>
+#include <moveit_msgs/PlanningSceneComponents.h>
 
-#include "pilz_trajectory_generation/joint_limits_aggregator.h"
-#include "pilz_trajectory_generation/cartesian_limits_aggregator.h"
+#include "pilz_trajectory_generation/limits_aggregator.h"
 #include "pilz_trajectory_generation/trajectory_blender_transition_window.h"
 #include "pilz_trajectory_generation/trajectory_blend_request.h"
 #include "pilz_trajectory_generation/tip_frame_getter.h"
+#include "pilz_trajectory_generation/trajectory_functions.h"
+#include "pilz_trajectory_generation/via_point_trajectory.h"
 
 namespace pilz_trajectory_generation
 {
 
 static const std::string PARAM_NAMESPACE_LIMITS = "robot_description_planning";
-
-CommandListManager::CommandListManager(const ros::NodeHandle &nh, const moveit::core::RobotModelConstPtr &model):
-  nh_(nh),
-  model_(model)
+static const std::string PARAM_PARALLEL_BLENDING = "parallel_blending";
+static const std::string PARAM_PARALLEL_BLENDING_THREADS = "parallel_blending_threads";
+static const std::string PARAM_MAX_AUTO_BLEND_RADIUS = "max_auto_blend_radius";
+static const std::string PARAM_SPECULATIVE_PLANNING = "speculative_planning";
+static const std::string PARAM_SPECULATIVE_PLANNING_THREADS = "speculative_planning_threads";
+static const std::string PARAM_SEQUENCE_CACHE_SIZE = "sequence_cache_size";
+static const std::string PARAM_SEQUENCE_CACHE_TOLERANCE = "sequence_cache_start_state_tolerance";
+static const std::string PARAM_MERGE_PTP_SEQUENCES = "merge_ptp_sequences";
+static const std::string PARAM_REUSE_SEQUENCE_ITEMS = "reuse_sequence_items";
+static const std::string PTP_PLANNER_ID = "PTP";
+
+static constexpr double DEFAULT_SEQUENCE_CACHE_TOLERANCE {1e-6};
+static constexpr int DEFAULT_SPECULATIVE_PLANNING_THREADS {4};
+static constexpr int DEFAULT_PARALLEL_BLENDING_THREADS {4};
+//! Sampling time of merged PTP commands, if it can not be taken from the planned trajectories.
+static constexpr double DEFAULT_MERGE_SAMPLING_TIME {0.1};
+static constexpr double SAMPLING_TIME_EPSILON {10e-06};
+
+template<typename MsgType>
+static std::string serializeMsg(const MsgType& msg)
 {
-  // Obtain the aggregated joint limits
-  pilz::JointLimitsContainer aggregated_limit_active_joints;
+  std::string buffer(ros::serialization::serializationLength(msg), '\0');
+  ros::serialization::OStream stream(reinterpret_cast<uint8_t*>(&buffer[0]), static_cast<uint32_t>(buffer.size()));
+  ros::serialization::serialize(stream, msg);
+  return buffer;
+}
 
-  aggregated_limit_active_joints = pilz::JointLimitsAggregator::getAggregatedLimits(
-        ros::NodeHandle(PARAM_NAMESPACE_LIMITS),model_->getActiveJointModels());
+static std::string serializeRequest(const planning_interface::MotionPlanRequest& req)
+{
+  return serializeMsg(req);
+}
 
+//! Sets an empty start state to the current state of the planning scene (like the planning contexts do),
+//! so that the cache key of the request depends on the state the request is planned for.
+static void setEmptyStartState(const planning_scene::PlanningScene& scene, moveit_msgs::RobotState& start_state)
+{
+  if (start_state.joint_state.name.empty())
+  {
+    moveit::core::robotStateToRobotStateMsg(scene.getCurrentState(), start_state);
+  }
+}
 
-  // Obtain cartesian limits
-  pilz::CartesianLimit cartesian_limit = pilz::CartesianLimitsAggregator::getAggregatedLimits(ros::NodeHandle(PARAM_NAMESPACE_LIMITS));
+static const planning_interface::MotionPlanResponse* findResponse(
+    const std::unordered_map<std::string, planning_interface::MotionPlanResponse>& cache, const std::string& key)
+{
+  auto it {cache.find(key)};
+  return it != cache.cend() ? &(it->second) : nullptr;
+}
 
-  pilz::LimitsContainer limits;
-  limits.setJointLimits(aggregated_limit_active_joints);
-  limits.setCartesianLimits(cartesian_limit);
+CommandListManager::CommandListManager(const ros::NodeHandle &nh, const moveit::core::RobotModelConstPtr &model):
+  nh_(nh),
+  model_(model)
+{
+  // The limits are shared with the command planner and the other managers of the process
+  const pilz::LimitsContainerConstPtr limits {
+    pilz::LimitsAggregator::getAggregatedLimits(ros::NodeHandle(PARAM_NAMESPACE_LIMITS), model_)};
+  joint_limits_ = limits->getJointLimitContainer();
 
   plan_comp_builder_.setModel(model);
-  plan_comp_builder_.setBlender(std::unique_ptr<pilz::TrajectoryBlender>(new pilz::TrajectoryBlenderTransitionWindow(limits)));
+  plan_comp_builder_.setBlender(std::unique_ptr<pilz::TrajectoryBlender>(new pilz::TrajectoryBlenderTransitionWindow(*limits)));
+  plan_comp_builder_.setParallelBlending(nh_.param(PARAM_PARALLEL_BLENDING, false));
+  plan_comp_builder_.setMaxBlendingThreads(static_cast<std::size_t>(
+        std::max(1, nh_.param(PARAM_PARALLEL_BLENDING_THREADS, DEFAULT_PARALLEL_BLENDING_THREADS))));
+
+  max_auto_blend_radius_ = nh_.param(PARAM_MAX_AUTO_BLEND_RADIUS, std::numeric_limits<double>::infinity());
+  speculative_planning_ = nh_.param(PARAM_SPECULATIVE_PLANNING, false);
+  speculative_planning_threads_ = static_cast<std::size_t>(
+        std::max(1, nh_.param(PARAM_SPECULATIVE_PLANNING_THREADS, DEFAULT_SPECULATIVE_PLANNING_THREADS)));
+  merge_ptp_sequences_ = nh_.param(PARAM_MERGE_PTP_SEQUENCES, false);
+  reuse_sequence_items_ = nh_.param(PARAM_REUSE_SEQUENCE_ITEMS, false);
+  plan_comp_builder_.setBlendReuse(reuse_sequence_items_);
+
+  const int sequence_cache_size {nh_.param(PARAM_SEQUENCE_CACHE_SIZE, 0)};
+  if (sequence_cache_size > 0)
+  {
+    sequence_cache_.reset(new SequenceCache(static_cast<std::size_t>(sequence_cache_size),
+                                            nh_.param(PARAM_SEQUENCE_CACHE_TOLERANCE, DEFAULT_SEQUENCE_CACHE_TOLERANCE)));
+  }
 }
 
 RobotTrajCont CommandListManager::solve(const planning_scene::PlanningSceneConstPtr& planning_scene,
@@ -71,16 +139,43 @@ RobotTrajCont CommandListManager::solve(const planning_scene::PlanningSceneConst
   checkLastBlendRadiusZero(req_list);
   checkStartStates(req_list);
 
+  std::string sequence_key;
+  std::vector<double> start_positions;
+  if (sequence_cache_)
+  {
+    sequence_key = getSequenceKey(planning_scene, req_list);
+    start_positions = getResolvedStartPositions(planning_scene, req_list);
+    RobotTrajCont cached_trajs;
+    if (sequence_cache_->lookup(sequence_key, start_positions, cached_trajs))
+    {
+      ROS_DEBUG_STREAM("Reused sequence (hits: " << sequence_cache_->getStatistics().hits
+                       << ", misses: " << sequence_cache_->getStatistics().misses << ")");
+      for(std::size_t i = 0; i < req_list.items.size(); ++i)
+      {
+        notifyProgress(i, req_list.items.size(), 0., true);
+      }
+      return cached_trajs;
+    }
+  }
+
+  const ros::Time deadline {req_list.allowed_planning_time > 0. ?
+                             ros::Time::now() + ros::Duration(req_list.allowed_planning_time) : ros::Time()};
   MotionResponseCont resp_cont
   {
-    solveSequenceItems(planning_scene, planning_pipeline, req_list)
+    solveSequenceItems(planning_scene, planning_pipeline, req_list, deadline)
   };
 
   assert(model_);
   RadiiCont radii {extractBlendRadii(*model_, req_list)};
+  if (merge_ptp_sequences_)
+  {
+    mergePtpItems(req_list, resp_cont, radii);
+  }
+  setMaximalBlendRadii(resp_cont, radii);
   checkForOverlappingRadii(resp_cont, radii);
 
   plan_comp_builder_.reset();
+  plan_comp_builder_.setDeadline(deadline);
   for(MotionResponseCont::size_type i = 0; i < resp_cont.size(); ++i)
   {
     plan_comp_builder_.append(resp_cont.at(i).trajectory_,
@@ -89,7 +184,146 @@ RobotTrajCont CommandListManager::solve(const planning_scene::PlanningSceneConst
                               // therefore: "i-1".
                               ( i>0? radii.at(i-1) : 0.) );
   }
-  return plan_comp_builder_.build();
+  RobotTrajCont trajs {plan_comp_builder_.build()};
+
+  if (sequence_cache_)
+  {
+    sequence_cache_->insert(sequence_key, start_positions, trajs);
+  }
+  return trajs;
+}
+
+void CommandListManager::notifyProgress(const std::size_t index, const std::size_t num_items,
+                                        const double planning_time, const bool reused) const
+{
+  if (progress_callback_)
+  {
+    progress_callback_(index, num_items, planning_time, reused);
+  }
+}
+
+SequenceCache::Statistics CommandListManager::getSequenceCacheStatistics() const
+{
+  return sequence_cache_ ? sequence_cache_->getStatistics() : SequenceCache::Statistics();
+}
+
+//! Appends the raw bytes of the specified values to the key.
+template<typename T>
+static void appendToKey(std::string& key, const T* values, const std::size_t count)
+{
+  key.append(reinterpret_cast<const char*>(values), count * sizeof(T));
+}
+
+static void appendToKey(std::string& key, const std::string& value)
+{
+  const std::size_t size {value.size()};
+  appendToKey(key, &size, 1);
+  key.append(value);
+}
+
+static void appendToKey(std::string& key, const Eigen::Isometry3d& pose)
+{
+  appendToKey(key, pose.matrix().data(), 16);
+}
+
+//! Appends a fingerprint of the shape which does not contain the geometry of meshes.
+static void appendToKey(std::string& key, const shapes::ShapeConstPtr& shape)
+{
+  const int type {shape->type};
+  appendToKey(key, &type, 1);
+  switch (shape->type)
+  {
+  case shapes::BOX:
+    appendToKey(key, static_cast<const shapes::Box&>(*shape).size, 3);
+    break;
+  case shapes::SPHERE:
+    appendToKey(key, &static_cast<const shapes::Sphere&>(*shape).radius, 1);
+    break;
+  case shapes::CYLINDER:
+    appendToKey(key, &static_cast<const shapes::Cylinder&>(*shape).radius, 1);
+    appendToKey(key, &static_cast<const shapes::Cylinder&>(*shape).length, 1);
+    break;
+  case shapes::CONE:
+    appendToKey(key, &static_cast<const shapes::Cone&>(*shape).radius, 1);
+    appendToKey(key, &static_cast<const shapes::Cone&>(*shape).length, 1);
+    break;
+  default:
+    {
+      // Shapes are not modified once they are added to the scene (they are replaced),
+      // so the address together with the size identifies meshes, octrees, etc.
+      const shapes::Shape* address {shape.get()};
+      appendToKey(key, &address, 1);
+      if (shape->type == shapes::MESH)
+      {
+        appendToKey(key, &static_cast<const shapes::Mesh&>(*shape).vertex_count, 1);
+        appendToKey(key, &static_cast<const shapes::Mesh&>(*shape).triangle_count, 1);
+      }
+    }
+    break;
+  }
+}
+
+std::string CommandListManager::getSequenceKey(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                                               const pilz_msgs::MotionSequenceRequest& req_list)
+{
+  // The robot state is considered separately (see getResolvedStartPositions()). The geometry
+  // is not serialized, because the serialization of large meshes would take longer than
+  // the lookup saves.
+  moveit_msgs::PlanningSceneComponents components;
+  components.components = moveit_msgs::PlanningSceneComponents::SCENE_SETTINGS
+      | moveit_msgs::PlanningSceneComponents::TRANSFORMS
+      | moveit_msgs::PlanningSceneComponents::ALLOWED_COLLISION_MATRIX
+      | moveit_msgs::PlanningSceneComponents::LINK_PADDING_AND_SCALING;
+  moveit_msgs::PlanningScene scene_msg;
+  planning_scene->getPlanningSceneMsg(scene_msg, components);
+  std::string key {serializeMsg(req_list) + serializeMsg(scene_msg)};
+
+  // The objects are ordered by their id
+  for (const auto& id_and_object : *planning_scene->getWorld())
+  {
+    const collision_detection::World::Object& object {*id_and_object.second};
+    appendToKey(key, object.id_);
+    for (std::size_t i = 0; i < object.shapes_.size(); ++i)
+    {
+      appendToKey(key, object.shapes_.at(i));
+      appendToKey(key, object.shape_poses_.at(i));
+    }
+  }
+
+  std::vector<const robot_state::AttachedBody*> attached_bodies;
+  planning_scene->getCurrentState().getAttachedBodies(attached_bodies);
+  std::sort(attached_bodies.begin(), attached_bodies.end(),
+            [](const robot_state::AttachedBody* a, const robot_state::AttachedBody* b)
+            { return a->getName() < b->getName(); });
+  for (const robot_state::AttachedBody* body : attached_bodies)
+  {
+    appendToKey(key, body->getName());
+    appendToKey(key, body->getAttachedLinkName());
+    for (std::size_t i = 0; i < body->getShapes().size(); ++i)
+    {
+      appendToKey(key, body->getShapes().at(i));
+      appendToKey(key, body->getFixedTransforms().at(i));
+    }
+  }
+  return key;
+}
+
+std::vector<double> CommandListManager::getResolvedStartPositions(
+    const planning_scene::PlanningSceneConstPtr& planning_scene,
+    const pilz_msgs::MotionSequenceRequest& req_list)
+{
+  // The planning context replaces empty start states by the current state
+  std::unordered_set<std::string> group_names;
+  for (const pilz_msgs::MotionSequenceItem& item : req_list.items)
+  {
+    if (group_names.insert(item.req.group_name).second && item.req.start_state.joint_state.name.empty())
+    {
+      const robot_state::RobotState& current_state {planning_scene->getCurrentState()};
+      return std::vector<double>(current_state.getVariablePositions(),
+                                 current_state.getVariablePositions() + current_state.getVariableCount());
+    }
+  }
+  return std::vector<double>();
 }
 
 bool CommandListManager::checkRadiiForOverlap(const robot_trajectory::RobotTrajectory& traj_A,
@@ -109,12 +343,93 @@ bool CommandListManager::checkRadiiForOverlap(const robot_trajectory::RobotTraje
     return false;
   }
 
-  const std::string& blend_frame {getSolverTipFrame(model_->getJointModelGroup(traj_A.getGroupName()))};
+  const std::string& blend_frame {getBlendFrame(traj_A)};
   auto distance_endpoints = (traj_A.getLastWayPoint().getFrameTransform(blend_frame).translation() -
                              traj_B.getLastWayPoint().getFrameTransform(blend_frame).translation()).norm();
   return distance_endpoints <= sum_radii;
 }
 
+void CommandListManager::mergePtpItems(const pilz_msgs::MotionSequenceRequest& req_list,
+                                       MotionResponseCont& resp_cont,
+                                       RadiiCont& radii) const
+{
+  MotionResponseCont merged_resp_cont;
+  RadiiCont merged_radii;
+  for(std::size_t first = 0; first < resp_cont.size();)
+  {
+    // Determine the consecutive blended PTP commands starting at "first"
+    std::size_t last {first};
+    while (last + 1 < resp_cont.size() && radii.at(last) != 0.
+           && req_list.items.at(last).req.planner_id == PTP_PLANNER_ID
+           && req_list.items.at(last + 1).req.planner_id == PTP_PLANNER_ID)
+    {
+      ++last;
+    }
+
+    robot_trajectory::RobotTrajectoryPtr merged_traj;
+    if (last > first && (merged_traj = mergeTrajectories(req_list, resp_cont, first, last)))
+    {
+      planning_interface::MotionPlanResponse merged_resp {resp_cont.at(first)};
+      merged_resp.trajectory_ = merged_traj;
+      merged_resp_cont.push_back(merged_resp);
+      merged_radii.push_back(radii.at(last));
+    }
+    else
+    {
+      for(std::size_t i = first; i <= last; ++i)
+      {
+        merged_resp_cont.push_back(resp_cont.at(i));
+        merged_radii.push_back(radii.at(i));
+      }
+    }
+    first = last + 1;
+  }
+
+  resp_cont.swap(merged_resp_cont);
+  radii.swap(merged_radii);
+}
+
+robot_trajectory::RobotTrajectoryPtr CommandListManager::mergeTrajectories(
+    const pilz_msgs::MotionSequenceRequest& req_list,
+    const MotionResponseCont& resp_cont,
+    const std::size_t first,
+    const std::size_t last) const
+{
+  const std::string& group_name {resp_cont.at(first).trajectory_->getGroupName()};
+
+  std::vector<robot_state::RobotStateConstPtr> waypoints
+  {
+    std::make_shared<const robot_state::RobotState>(resp_cont.at(first).trajectory_->getFirstWayPoint())
+  };
+  std::vector<pilz::ViaPointScaling> scaling;
+  double sampling_time {0.};
+  for(std::size_t i = first; i <= last; ++i)
+  {
+    const robot_trajectory::RobotTrajectoryPtr& traj {resp_cont.at(i).trajectory_};
+    waypoints.push_back(std::make_shared<const robot_state::RobotState>(traj->getLastWayPoint()));
+
+    const planning_interface::MotionPlanRequest& req {req_list.items.at(i).req};
+    scaling.push_back(pilz::ViaPointScaling {req.max_velocity_scaling_factor, req.max_acceleration_scaling_factor});
+
+    double traj_sampling_time {0.};
+    if (pilz::determineSamplingTime(traj, SAMPLING_TIME_EPSILON, traj_sampling_time) && traj_sampling_time > 0.)
+    {
+      sampling_time = (sampling_time > 0.) ? std::min(sampling_time, traj_sampling_time) : traj_sampling_time;
+    }
+  }
+
+  robot_trajectory::RobotTrajectoryPtr merged_traj {new robot_trajectory::RobotTrajectory(model_, group_name)};
+  if (!pilz::generateViaPointTrajectory(joint_limits_, group_name, waypoints, scaling,
+                                        sampling_time > 0. ? sampling_time : DEFAULT_MERGE_SAMPLING_TIME,
+                                        *merged_traj))
+  {
+    ROS_WARN_STREAM("Failed to merge the PTP commands [" << first << "] to [" << last << "] => Commands are blended");
+    return nullptr;
+  }
+  ROS_DEBUG_STREAM("Merged the PTP commands [" << first << "] to [" << last << "]");
+  return merged_traj;
+}
+
 void CommandListManager::checkForOverlappingRadii(const MotionResponseCont &resp_cont,
                                                   const RadiiCont &radii) const
 {
@@ -133,24 +448,81 @@ void CommandListManager::checkForOverlappingRadii(const MotionResponseCont &resp
   }
 }
 
-CommandListManager::RobotState_OptRef  CommandListManager::getPreviousEndState(const MotionResponseCont &motion_plan_responses,
-                                                                               const std::string& group_name)
+const std::string& CommandListManager::getBlendFrame(const robot_trajectory::RobotTrajectory& traj) const
+{
+  return getSolverTipFrame(model_->getJointModelGroup(traj.getGroupName()));
+}
+
+double CommandListManager::getMaximalDistance(const robot_trajectory::RobotTrajectory& traj,
+                                              const std::string& frame,
+                                              const Eigen::Vector3d& position)
 {
-  for(MotionResponseCont::const_reverse_iterator it = motion_plan_responses.crbegin(); it != motion_plan_responses.crend(); ++it)
+  double max_distance {0.};
+  for(std::size_t i = 0; i < traj.getWayPointCount(); ++i)
   {
-    if (it->trajectory_->getGroupName() == group_name)
+    max_distance = std::max(max_distance,
+                            (traj.getWayPoint(i).getFrameTransform(frame).translation() - position).norm());
+  }
+  return max_distance;
+}
+
+void CommandListManager::setMaximalBlendRadii(const MotionResponseCont &resp_cont,
+                                              RadiiCont &radii) const
+{
+  for(RadiiCont::size_type i = 0; i+1 < radii.size(); ++i)
+  {
+    if (radii.at(i) != pilz_msgs::MotionSequenceItem::BLEND_RADIUS_MAX)
+    {
+      continue;
+    }
+
+    const robot_trajectory::RobotTrajectory& traj_A {*(resp_cont.at(i).trajectory_)};
+    const robot_trajectory::RobotTrajectory& traj_B {*(resp_cont.at(i+1).trajectory_)};
+    const std::string& blend_frame {getBlendFrame(traj_A)};
+    const Eigen::Vector3d center {traj_A.getLastWayPoint().getFrameTransform(blend_frame).translation()};
+
+    // The blend sphere has to intersect both trajectories
+    double radius {std::min({max_auto_blend_radius_,
+                             getMaximalDistance(traj_A, blend_frame, center),
+                             getMaximalDistance(traj_B, blend_frame, center)})};
+
+    // The blend sphere must not overlap with the previous blend sphere (already determined)
+    if (i > 0 && resp_cont.at(i-1).trajectory_->getGroupName() == traj_A.getGroupName())
     {
-      return it->trajectory_->getLastWayPoint();
+      const double distance {(resp_cont.at(i-1).trajectory_->getLastWayPoint().getFrameTransform(blend_frame).translation()
+                              - center).norm()};
+      radius = std::min(radius, distance - radii.at(i-1));
     }
+
+    // The blend sphere must not overlap with the next blend sphere
+    if (i+2 < radii.size() && traj_B.getGroupName() == traj_A.getGroupName())
+    {
+      const double distance {(traj_B.getLastWayPoint().getFrameTransform(blend_frame).translation() - center).norm()};
+      radius = std::min(radius, radii.at(i+1) == pilz_msgs::MotionSequenceItem::BLEND_RADIUS_MAX ?
+                          distance / 2. : distance - radii.at(i+1));
+    }
+
+    radii.at(i) = std::max(0., MAX_BLEND_RADIUS_SCALING * radius);
+    ROS_DEBUG_STREAM("Maximal blend radius between commands [" << i << "] and [" << i+1 << "]: " << radii.at(i));
   }
-  return boost::none;
 }
 
-void CommandListManager::setStartState(const MotionResponseCont &motion_plan_responses,
+CommandListManager::RobotState_OptRef CommandListManager::getPreviousEndState(const GroupTrajCont& last_trajs,
+                                                                              const std::string& group_name)
+{
+  GroupTrajCont::const_iterator it {last_trajs.find(group_name)};
+  if (it == last_trajs.cend())
+  {
+    return boost::none;
+  }
+  return it->second->getLastWayPoint();
+}
+
+void CommandListManager::setStartState(const GroupTrajCont& last_trajs,
                                        const std::string &group_name,
                                        moveit_msgs::RobotState& start_state)
 {
-  RobotState_OptRef rob_state_op {getPreviousEndState(motion_plan_responses, group_name)};
+  RobotState_OptRef rob_state_op {getPreviousEndState(last_trajs, group_name)};
   if (rob_state_op)
   {
     moveit::core::robotStateToRobotStateMsg(rob_state_op.value(), start_state);
@@ -205,96 +577,361 @@ CommandListManager::RadiiCont CommandListManager::extractBlendRadii(const moveit
 CommandListManager::MotionResponseCont CommandListManager::solveSequenceItems(
     const planning_scene::PlanningSceneConstPtr& planning_scene,
     const planning_pipeline::PlanningPipelinePtr& planning_pipeline,
-    const pilz_msgs::MotionSequenceRequest &req_list) const
+    const pilz_msgs::MotionSequenceRequest &req_list,
+    const ros::Time& deadline)
 {
+  ResponseCache speculative_responses;
+  if (speculative_planning_)
+  {
+    speculative_responses = planSpeculatively(planning_scene, planning_pipeline, req_list, deadline);
+  }
+
   MotionResponseCont motion_plan_responses;
+  motion_plan_responses.reserve(req_list.items.size());
+  GroupTrajCont last_trajs;
+  ResponseCache used_responses;
+  // Keeps the results of the solved items, so that they are reused if the sequence is planned again
+  auto keep_used_responses = [&]()
+  {
+    if (reuse_sequence_items_)
+    {
+      response_cache_.insert(used_responses.begin(), used_responses.end());
+    }
+  };
   size_t curr_req_index {0};
   const size_t num_req {req_list.items.size()};
   for(const auto& seq_item : req_list.items)
   {
+    if (pilz::isCancelled(cancellation_token_))
+    {
+      keep_used_responses();
+      throw PlanningCancelledException("Planning of the sequence cancelled");
+    }
+
     planning_interface::MotionPlanRequest req {seq_item.req};
-    setStartState(motion_plan_responses, req.group_name, req.start_state);
+    setStartState(last_trajs, req.group_name, req.start_state);
+
+    // The keys are only needed, if results can be reused
+    std::string cache_key;
+    if (reuse_sequence_items_ || !speculative_responses.empty())
+    {
+      setEmptyStartState(*planning_scene, req.start_state);
+      cache_key = serializeRequest(req);
+
+      boost::optional<planning_interface::MotionPlanResponse> cached;
+      const planning_interface::MotionPlanResponse* reused {nullptr};
+      if (reuse_sequence_items_)
+      {
+        reused = findResponse(used_responses, cache_key);
+        if (!reused)
+        {
+          reused = findResponse(response_cache_, cache_key);
+        }
+      }
+      if (reused)
+      {
+        cached = *reused;
+      }
+      else
+      {
+        // Each speculative result is used once, so that equal items do not share a trajectory
+        auto speculative_it {speculative_responses.find(cache_key)};
+        if (speculative_it != speculative_responses.end())
+        {
+          cached = std::move(speculative_it->second);
+          speculative_responses.erase(speculative_it);
+        }
+      }
+
+      if (cached)
+      {
+        motion_plan_responses.emplace_back(std::move(cached.value()));
+        last_trajs[req.group_name] = motion_plan_responses.back().trajectory_;
+        if (reuse_sequence_items_)
+        {
+          used_responses.emplace(std::move(cache_key), motion_plan_responses.back());
+        }
+        ROS_DEBUG_STREAM("Reused [" << ++curr_req_index << "/" << num_req << "]");
+        notifyProgress(curr_req_index - 1, num_req, 0., true);
+        continue;
+      }
+    }
+
+    // The cache key is determined before, so that the results do not depend on the time left
+    if (!limitPlanningTime(deadline, req))
+    {
+      keep_used_responses();
+      throw PlanningTimedOutException("Allowed planning time of the sequence exceeded");
+    }
 
     planning_interface::MotionPlanResponse res;
-    planning_pipeline->generatePlan(planning_scene, req, res);
+    solveRequest(planning_scene, planning_pipeline, req, res);
     if (res.error_code_.val != res.error_code_.SUCCESS)
     {
       std::ostringstream os;
       os << "Could not solve request\n---\n" << req << "\n---\n";
+      keep_used_responses();
       throw PlanningPipelineException(os.str(), res.error_code_.val);
     }
     motion_plan_responses.emplace_back(res);
+    last_trajs[req.group_name] = res.trajectory_;
+    if (reuse_sequence_items_)
+    {
+      used_responses.emplace(std::move(cache_key), res);
+    }
     ROS_DEBUG_STREAM("Solved [" << ++curr_req_index << "/" << num_req << "]");
+    notifyProgress(curr_req_index - 1, num_req, res.planning_time_, false);
   }
-  return motion_plan_responses;
-}
-
-void CommandListManager::checkForNegativeRadii(const pilz_msgs::MotionSequenceRequest &req_list)
-{
-  if(!std::all_of(req_list.items.begin(), req_list.items.end(),
-                  [](const pilz_msgs::MotionSequenceItem& req){return (req.blend_radius >= 0.);}))
+  if (reuse_sequence_items_)
   {
-    throw NegativeBlendRadiusException("All blending radii MUST be non negative");
+    response_cache_.swap(used_responses);
   }
+  return motion_plan_responses;
 }
 
-void CommandListManager::checkStartStatesOfGroup(const pilz_msgs::MotionSequenceRequest &req_list,
-                                                 const std::string& group_name)
+CommandListManager::ResponseCache CommandListManager::planSpeculatively(
+    const planning_scene::PlanningSceneConstPtr& planning_scene,
+    const planning_pipeline::PlanningPipelinePtr& planning_pipeline,
+    const pilz_msgs::MotionSequenceRequest &req_list,
+    const ros::Time& deadline) const
 {
-  bool first_elem {true};
-  for (const pilz_msgs::MotionSequenceItem& item : req_list.items)
+  // Predict the start states. The first item of each group keeps its own start state,
+  // the following items start at the predicted end state of their predecessor.
+  std::vector<planning_interface::MotionPlanRequest> requests;
+  std::vector<std::string> keys;
+  std::unordered_map<std::string, boost::optional<moveit_msgs::RobotState> > end_states;
+  for(const auto& seq_item : req_list.items)
   {
-    if (item.req.group_name != group_name)
+    planning_interface::MotionPlanRequest req {seq_item.req};
+    auto end_state_it {end_states.find(req.group_name)};
+    if (end_state_it != end_states.end())
     {
-      continue;
+      if (!end_state_it->second)
+      {
+        // Unknown start state, therefore all following end states are unknown, too
+        continue;
+      }
+      req.start_state = end_state_it->second.value();
     }
+    setEmptyStartState(*planning_scene, req.start_state);
+    end_states[req.group_name] = predictEndState(planning_scene, req);
 
-    if (first_elem)
+    std::string key {serializeRequest(req)};
+    if (findResponse(response_cache_, key))
     {
-      first_elem = false;
       continue;
     }
+    requests.emplace_back(std::move(req));
+    keys.emplace_back(std::move(key));
+  }
 
-    if (!(item.req.start_state.joint_state.position.empty()
-          && item.req.start_state.joint_state.velocity.empty()
-          && item.req.start_state.joint_state.effort.empty()
-          && item.req.start_state.joint_state.name.empty()))
+  std::vector<planning_interface::MotionPlanResponse> responses(requests.size());
+  std::atomic<std::size_t> next_index {0};
+  auto worker = [&]()
+  {
+    for(std::size_t i = next_index++; i < requests.size() && !pilz::isCancelled(cancellation_token_);
+        i = next_index++)
     {
-      std::ostringstream os;
-      os << "Only the first request is allowed to have a start state, but"
-         << " the requests for group: \"" << group_name << "\" violate the rule" ;
-      throw StartStateSetException(os.str());
+      if (limitPlanningTime(deadline, requests.at(i)))
+      {
+        solveRequest(planning_scene, planning_pipeline, requests.at(i), responses.at(i));
+      }
     }
+  };
+
+  const std::size_t num_threads {std::min({speculative_planning_threads_,
+                                           static_cast<std::size_t>(std::max(1u, std::thread::hardware_concurrency())),
+                                           requests.size()})};
+  std::vector<std::thread> threads;
+  for(std::size_t i = 1; i < num_threads; ++i)
+  {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for(auto& thread : threads)
+  {
+    thread.join();
   }
+
+  ResponseCache speculative_responses;
+  for(std::size_t i = 0; i < requests.size(); ++i)
+  {
+    if (responses.at(i).error_code_.val == moveit_msgs::MoveItErrorCodes::SUCCESS)
+    {
+      speculative_responses.emplace(std::move(keys.at(i)), std::move(responses.at(i)));
+    }
+  }
+  ROS_DEBUG_STREAM("Speculatively solved " << speculative_responses.size() << " of " << req_list.items.size()
+                   << " requests");
+  return speculative_responses;
 }
 
-void CommandListManager::checkStartStates(const pilz_msgs::MotionSequenceRequest &req_list)
+void CommandListManager::solveRequest(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                                      const planning_pipeline::PlanningPipelinePtr& planning_pipeline,
+                                      const planning_interface::MotionPlanRequest& req,
+                                      planning_interface::MotionPlanResponse& res) const
 {
-  if (req_list.items.size() <= 1)
+  const planning_interface::PlannerManagerPtr& planner {planning_pipeline->getPlannerManager()};
+  planning_interface::PlanningContextPtr context;
+  if (planner)
+  {
+    context = planner->getPlanningContext(planning_scene, req, res.error_code_);
+  }
+  if (!context)
   {
+    ROS_ERROR_STREAM("No planning context for planner_id \"" << req.planner_id << "\" of the pipeline.");
+    if (res.error_code_.val == moveit_msgs::MoveItErrorCodes::SUCCESS)
+    {
+      res.error_code_.val = moveit_msgs::MoveItErrorCodes::PLANNING_FAILED;
+    }
     return;
   }
 
-  GroupNamesCont group_names {getGroupNames(req_list)};
-  for(const auto& curr_group_name : group_names)
   {
-    checkStartStatesOfGroup(req_list, curr_group_name);
+    std::lock_guard<std::mutex> lock(active_contexts_mutex_);
+    active_contexts_.push_back(context);
+  }
+  // The token is cancelled before terminate() is called, therefore a context registered after
+  // terminate() is stopped here
+  if (pilz::isCancelled(cancellation_token_))
+  {
+    context->terminate();
+  }
+
+  try
+  {
+    context->solve(res);
+  }
+  catch (const std::exception& ex)
+  {
+    ROS_ERROR_STREAM("Exception while planning: " << ex.what());
+    res.error_code_.val = moveit_msgs::MoveItErrorCodes::FAILURE;
+  }
+
+  std::lock_guard<std::mutex> lock(active_contexts_mutex_);
+  active_contexts_.erase(std::find(active_contexts_.begin(), active_contexts_.end(), context));
+}
+
+void CommandListManager::terminate() const
+{
+  std::lock_guard<std::mutex> lock(active_contexts_mutex_);
+  for (const auto& context : active_contexts_)
+  {
+    context->terminate();
   }
 }
 
-CommandListManager::GroupNamesCont CommandListManager::getGroupNames(const pilz_msgs::MotionSequenceRequest &req_list)
+bool CommandListManager::limitPlanningTime(const ros::Time& deadline, planning_interface::MotionPlanRequest& req)
 {
-  GroupNamesCont group_names;
-  std::for_each(req_list.items.cbegin(), req_list.items.cend(),
-                [&group_names](const pilz_msgs::MotionSequenceItem& item)
+  if (deadline.isZero())
+  {
+    return true;
+  }
+
+  const double remaining_time {(deadline - ros::Time::now()).toSec()};
+  if (remaining_time <= 0.)
   {
-    if(std::find(group_names.cbegin(), group_names.cend(), item.req.group_name) == group_names.cend())
+    return false;
+  }
+  req.allowed_planning_time = req.allowed_planning_time > 0. ?
+        std::min(req.allowed_planning_time, remaining_time) : remaining_time;
+  return true;
+}
+
+boost::optional<moveit_msgs::RobotState> CommandListManager::predictEndState(
+    const planning_scene::PlanningSceneConstPtr& planning_scene,
+    const planning_interface::MotionPlanRequest& req) const
+{
+  // The end states of LIN and CIRC commands depend on the IK solutions along the path
+  if (req.planner_id != PTP_PLANNER_ID || req.goal_constraints.size() != 1)
+  {
+    return boost::none;
+  }
+  const moveit_msgs::Constraints& goal {req.goal_constraints.front()};
+  const bool is_cartesian_goal {goal.joint_constraints.empty()};
+  if (is_cartesian_goal && (goal.position_constraints.empty() || goal.orientation_constraints.empty()
+                            || goal.position_constraints.front().constraint_region.primitive_poses.empty()))
+  {
+    return boost::none;
+  }
+
+  // Mirrors the start state handling of the planning context and the trajectory generator
+  moveit_msgs::RobotState start_state {req.start_state};
+  if (start_state.joint_state.name.empty())
+  {
+    moveit::core::robotStateToRobotStateMsg(planning_scene->getCurrentState(), start_state);
+  }
+  moveit::core::RobotState end_state(model_);
+  end_state.setToDefaultValues();
+  moveit::core::robotStateMsgToRobotState(start_state, end_state, false);
+
+  // The last point of a PTP trajectory is located exactly at the goal and has zero velocity/acceleration
+  std::map<std::string, double> goal_positions;
+  if (is_cartesian_goal)
+  {
+    // Same IK (goal pose and seed) as the PTP generator, a different solution is detected
+    // by the sequential planning
+    std::map<std::string, double> seed;
+    for(std::size_t i = 0; i < start_state.joint_state.name.size(); ++i)
+    {
+      seed[start_state.joint_state.name.at(i)] = start_state.joint_state.position.at(i);
+    }
+    if (!pilz::computePTPGoalIK(model_, req.group_name, goal, seed, goal_positions))
     {
-      group_names.emplace_back(item.req.group_name);
+      return boost::none;
+    }
+  }
+  for(const auto& joint_constraint : goal.joint_constraints)
+  {
+    goal_positions[joint_constraint.joint_name] = joint_constraint.position;
+  }
+  for(const auto& goal : goal_positions)
+  {
+    end_state.setVariablePosition(goal.first, goal.second);
+    end_state.setVariableVelocity(goal.first, 0.);
+    end_state.setVariableAcceleration(goal.first, 0.);
+  }
+  end_state.update();
+
+  moveit_msgs::RobotState end_state_msg;
+  moveit::core::robotStateToRobotStateMsg(end_state, end_state_msg);
+  return end_state_msg;
+}
+
+void CommandListManager::checkForNegativeRadii(const pilz_msgs::MotionSequenceRequest &req_list)
+{
+  if(!std::all_of(req_list.items.begin(), req_list.items.end(),
+                  [](const pilz_msgs::MotionSequenceItem& req)
+  {
+    return (req.blend_radius >= 0.) || (req.blend_radius == pilz_msgs::MotionSequenceItem::BLEND_RADIUS_MAX);
+  }))
+  {
+    throw NegativeBlendRadiusException("All blending radii MUST be non negative (or BLEND_RADIUS_MAX)");
+  }
+}
+
+void CommandListManager::checkStartStates(const pilz_msgs::MotionSequenceRequest &req_list)
+{
+  std::unordered_set<std::string> group_names;
+  for (const pilz_msgs::MotionSequenceItem& item : req_list.items)
+  {
+    // The first request of each group is allowed to have a start state
+    if (group_names.insert(item.req.group_name).second)
+    {
+      continue;
+    }
+
+    if (!(item.req.start_state.joint_state.position.empty()
+          && item.req.start_state.joint_state.velocity.empty()
+          && item.req.start_state.joint_state.effort.empty()
+          && item.req.start_state.joint_state.name.empty()))
+    {
+      std::ostringstream os;
+      os << "Only the first request is allowed to have a start state, but"
+         << " the requests for group: \"" << item.req.group_name << "\" violate the rule" ;
+      throw StartStateSetException(os.str());
     }
   }
-  );
-  return group_names;
 }
 
 } // namespace pilz_trajectory_generation
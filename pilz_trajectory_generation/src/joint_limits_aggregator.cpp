@@ -76,7 +76,11 @@ pilz::JointLimitsContainer pilz::JointLimitsAggregator::getAggregatedLimits(cons
     }
 
     // Insert the joint limit into the map
-    container.addLimit(joint_model->getName(), joint_limit);
+    if(!container.addLimit(joint_model->getName(), joint_limit))
+    {
+      ROS_ERROR_STREAM("Failed to add the limits of joint " << joint_model->getName()
+                       << " (max_deceleration has to be negative and each joint can only be limited once).");
+    }
   }
 
   return container;
@@ -17,7 +17,7 @@
 
 #include "pilz_trajectory_generation/joint_limits_container.h"
 
-#include "ros/ros.h"
+#include <cmath>
 #include <stdexcept>
 
 namespace pilz
@@ -27,14 +27,12 @@ bool JointLimitsContainer::addLimit(const std::string &joint_name, pilz_extensio
 {
   if(joint_limit.has_deceleration_limits && joint_limit.max_deceleration >= 0)
   {
-    ROS_ERROR_STREAM("joint_limit.max_deceleration MUST be negative!");
     return false;
   }
   const auto& insertion_result { container_.insert(std::pair<std::string, pilz_extensions::JointLimit>(joint_name,
                                                                                                        joint_limit)) };
   if (!insertion_result.second)
   {
-    ROS_ERROR_STREAM("joint_limit for joint " << joint_name << " already contained.");
     return false;
   }
   return true;
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2018 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pilz_trajectory_generation/limits_aggregator.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "pilz_trajectory_generation/cartesian_limits_aggregator.h"
+#include "pilz_trajectory_generation/joint_limits_aggregator.h"
+
+namespace pilz {
+
+namespace {
+
+//! Limits aggregated for a namespace and a robot model.
+struct AggregatedLimits
+{
+  std::string ns;
+  //! Not owning, so that the cache does not prolong the lifetime of the model.
+  std::weak_ptr<const moveit::core::RobotModel> model;
+  LimitsContainerConstPtr limits;
+};
+
+std::mutex aggregated_limits_mutex;
+std::vector<AggregatedLimits> aggregated_limits;
+
+//! Reads the limits from the parameter server.
+LimitsContainerConstPtr readAggregatedLimits(const ros::NodeHandle& nh, const moveit::core::RobotModelConstPtr& model)
+{
+  JointLimitsContainer joint_limits {JointLimitsAggregator::getAggregatedLimits(nh, model->getActiveJointModels())};
+  CartesianLimit cartesian_limit {CartesianLimitsAggregator::getAggregatedLimits(nh)};
+
+  std::shared_ptr<LimitsContainer> limits {std::make_shared<LimitsContainer>()};
+  limits->setJointLimits(joint_limits);
+  limits->setCartesianLimits(cartesian_limit);
+  return limits;
+}
+
+//! Returns the cached limits of the namespace and the model (nullptr if there are none),
+//! the entries of destroyed models are removed. The mutex has to be locked.
+AggregatedLimits* findAggregatedLimits(const ros::NodeHandle& nh, const moveit::core::RobotModelConstPtr& model)
+{
+  aggregated_limits.erase(std::remove_if(aggregated_limits.begin(), aggregated_limits.end(),
+                                         [](const AggregatedLimits& entry) { return entry.model.expired(); }),
+                          aggregated_limits.end());
+
+  for(auto& entry : aggregated_limits)
+  {
+    if(entry.ns == nh.getNamespace() && entry.model.lock() == model)
+    {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+} // namespace
+
+LimitsContainerConstPtr LimitsAggregator::getAggregatedLimits(const ros::NodeHandle& nh,
+                                                              const moveit::core::RobotModelConstPtr& model)
+{
+  std::lock_guard<std::mutex> lock(aggregated_limits_mutex);
+
+  const AggregatedLimits* entry {findAggregatedLimits(nh, model)};
+  if(entry)
+  {
+    return entry->limits;
+  }
+
+  LimitsContainerConstPtr limits {readAggregatedLimits(nh, model)};
+  aggregated_limits.push_back(AggregatedLimits {nh.getNamespace(), model, limits});
+  return limits;
+}
+
+LimitsContainerConstPtr LimitsAggregator::reloadAggregatedLimits(const ros::NodeHandle& nh,
+                                                                 const moveit::core::RobotModelConstPtr& model)
+{
+  // Read before locking, if the parameters are invalid the shared limits stay unchanged
+  LimitsContainerConstPtr limits {readAggregatedLimits(nh, model)};
+
+  std::lock_guard<std::mutex> lock(aggregated_limits_mutex);
+  AggregatedLimits* entry {findAggregatedLimits(nh, model)};
+  if(entry)
+  {
+    entry->limits = limits;
+  }
+  else
+  {
+    aggregated_limits.push_back(AggregatedLimits {nh.getNamespace(), model, limits});
+  }
+  return limits;
+}
+
+} // namespace pilz
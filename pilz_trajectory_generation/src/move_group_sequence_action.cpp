@@ -39,6 +39,10 @@
 #include "pilz_trajectory_generation/move_group_sequence_action.h"
 
 #include <time.h>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <thread>
 
 #include <moveit/planning_pipeline/planning_pipeline.h>
 #include <moveit/plan_execution/plan_execution.h>
@@ -48,11 +52,14 @@
 #include <moveit/robot_state/conversions.h>
 
 #include "pilz_trajectory_generation/command_list_manager.h"
+#include "pilz_trajectory_generation/planning_scene_snapshot.h"
 #include "pilz_trajectory_generation/trajectory_generation_exceptions.h"
 
 namespace pilz_trajectory_generation
 {
 
+static const std::string PARAM_SEQUENCE_LOOKAHEAD = "sequence_lookahead";
+
 MoveGroupSequenceAction::MoveGroupSequenceAction()
   : MoveGroupCapability("SequenceAction")
 {
@@ -70,11 +77,27 @@ void MoveGroupSequenceAction::initialize()
 
   command_list_manager_.reset(new pilz_trajectory_generation::CommandListManager (
                             ros::NodeHandle("~"), context_->planning_scene_monitor_->getRobotModel()));
-
+  command_list_manager_->setProgressCallback(boost::bind(&MoveGroupSequenceAction::publishPlanningProgress,
+                                                         this, _1, _2, _3, _4));
+  command_list_manager_->setCancellationToken(&cancellation_token_);
 }
 
 void MoveGroupSequenceAction::executeSequenceCallback(const pilz_msgs::MoveGroupSequenceGoalConstPtr& goal)
 {
+  {
+    std::lock_guard<std::mutex> lock(feedback_mutex_);
+    move_feedback_.planned_item_index = -1;
+    move_feedback_.num_items = static_cast<uint32_t>(goal->request.items.size());
+    move_feedback_.item_planning_time = 0.;
+    move_feedback_.item_reused = false;
+    progress_offset_ = 0;
+  }
+  cancellation_token_.reset();
+  // The preempt callback might have been called before the reset
+  if (move_action_server_->isPreemptRequested())
+  {
+    cancellation_token_.cancel();
+  }
   setMoveState(move_group::PLANNING);
 
   // Handle empty requests
@@ -103,7 +126,15 @@ void MoveGroupSequenceAction::executeSequenceCallback(const pilz_msgs::MoveGroup
   }
   else
   {
-    executeSequenceCallbackPlanAndExecute(goal, action_res);
+    const int lookahead {ros::NodeHandle("~").param(PARAM_SEQUENCE_LOOKAHEAD, 0)};
+    if (lookahead > 0)
+    {
+      executeSequenceCallbackPlanAndExecuteStreamed(goal, static_cast<std::size_t>(lookahead), action_res);
+    }
+    else
+    {
+      executeSequenceCallbackPlanAndExecute(goal, action_res);
+    }
   }
 
   switch(action_res.error_code.val)
@@ -140,7 +171,8 @@ void MoveGroupSequenceAction::executeSequenceCallbackPlanAndExecute(const pilz_m
   opt.before_execution_callback_ = boost::bind(&MoveGroupSequenceAction::startMoveExecutionCallback, this);
 
   opt.plan_callback_ =
-      boost::bind(&MoveGroupSequenceAction::planUsingSequenceManager, this, boost::cref(goal->request), _1);
+      boost::bind(&MoveGroupSequenceAction::planUsingSequenceManager, this, boost::cref(goal->request),
+                  goal->return_partial_result, _1);
 
   if (goal->planning_options.look_around && context_->plan_with_sensing_)
   {
@@ -154,6 +186,211 @@ void MoveGroupSequenceAction::executeSequenceCallbackPlanAndExecute(const pilz_m
   action_res.error_code = plan.error_code_;
 }
 
+void MoveGroupSequenceAction::executeSequenceCallbackPlanAndExecuteStreamed(
+    const pilz_msgs::MoveGroupSequenceGoalConstPtr& goal,
+    const std::size_t lookahead,
+    pilz_msgs::MoveGroupSequenceResult& action_res)
+{
+  if (goal->planning_options.replan)
+  {
+    // A failed segment can not be replanned once the following segments are planned from its end state
+    ROS_WARN("Replanning is not supported by the streamed execution, "
+             "the whole sequence is planned before the execution.");
+    executeSequenceCallbackPlanAndExecute(goal, action_res);
+    return;
+  }
+
+  SequenceSegments segments;
+  if (!splitSequence(goal->request, segments))
+  {
+    ROS_ERROR("Only the first request of each group is allowed to have a start state.");
+    action_res.error_code.val = moveit_msgs::MoveItErrorCodes::INVALID_ROBOT_STATE;
+    return;
+  }
+  if (segments.size() < 2)
+  {
+    executeSequenceCallbackPlanAndExecute(goal, action_res);
+    return;
+  }
+  ROS_INFO_STREAM("Combined planning and execution request received for MoveGroupSequenceAction. Streaming "
+                  << segments.size() << " segments with a lookahead of " << lookahead << ".");
+
+  const moveit_msgs::PlanningScene& planning_scene_diff =
+      planning_scene::PlanningScene::isEmpty(goal->planning_options.planning_scene_diff.robot_state) ?
+        goal->planning_options.planning_scene_diff :
+        clearSceneRobotState(goal->planning_options.planning_scene_diff);
+
+  // All groups start at the current state, unless stated otherwise
+  moveit_msgs::RobotState initial_state;
+  {
+    planning_scene_monitor::LockedPlanningSceneRO lscene(context_->planning_scene_monitor_);
+    robot_state::robotStateToRobotStateMsg(lscene->getCurrentState(), initial_state);
+  }
+
+  std::vector<plan_execution::ExecutableMotionPlan> plans(segments.size());
+  std::mutex mutex;
+  std::condition_variable cond;
+  std::size_t num_planned {0};
+  std::size_t num_executed {0};
+  bool stop_planning {false};
+  double planning_time {0.};
+
+  auto plan_segments = [&]()
+  {
+    GroupStateMsgs end_states;
+    std::size_t segment_offset {0};
+    for(std::size_t i = 0; i < segments.size(); ++i)
+    {
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [&]() { return stop_planning || i <= num_executed + lookahead; });
+        if (stop_planning)
+        {
+          return;
+        }
+      }
+
+      setSegmentStartStates(initial_state, end_states, segments.at(i));
+      plan_execution::ExecutableMotionPlan& plan {plans.at(i)};
+      plan.planning_scene_monitor_ = context_->planning_scene_monitor_;
+      {
+        planning_scene_monitor::LockedPlanningSceneRO lscene(context_->planning_scene_monitor_);
+        plan.planning_scene_ = planning_scene::PlanningScene::isEmpty(planning_scene_diff) ?
+              static_cast<const planning_scene::PlanningSceneConstPtr&>(lscene) :
+              lscene->diff(planning_scene_diff);
+      }
+      {
+        std::lock_guard<std::mutex> lock(feedback_mutex_);
+        progress_offset_ = segment_offset;
+      }
+      segment_offset += segments.at(i).items.size();
+      const ros::Time planning_start {ros::Time::now()};
+      const bool success {planSequence(segments.at(i), false, plan)};
+      planning_time += (ros::Time::now() - planning_start).toSec();
+      for(const auto& component : plan.plan_components_)
+      {
+        robot_state::robotStateToRobotStateMsg(component.trajectory_->getLastWayPoint(),
+                                               end_states[component.trajectory_->getGroupName()]);
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++num_planned;
+      }
+      cond.notify_all();
+      if (!success)
+      {
+        return;
+      }
+    }
+  };
+  std::thread planning_thread(plan_segments);
+
+  action_res.error_code.val = moveit_msgs::MoveItErrorCodes::SUCCESS;
+  for(std::size_t i = 0; i < segments.size(); ++i)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cond.wait(lock, [&]() { return num_planned > i; });
+    }
+
+    plan_execution::ExecutableMotionPlan& plan {plans.at(i)};
+    if (plan.error_code_.val != moveit_msgs::MoveItErrorCodes::SUCCESS)
+    {
+      ROS_ERROR_STREAM("Planning of segment " << i << " failed, stopping execution.");
+      action_res.error_code = plan.error_code_;
+      break;
+    }
+    if (move_action_server_->isPreemptRequested())
+    {
+      action_res.error_code.val = moveit_msgs::MoveItErrorCodes::PREEMPTED;
+      break;
+    }
+
+    setMoveState(move_group::MONITOR);
+    action_res.error_code = context_->plan_execution_->executeAndMonitor(plan);
+
+    StartStateMsgs start_states;
+    PlannedTrajMsgs planned_trajs;
+    convertToMsg(plan.plan_components_, start_states, planned_trajs);
+    action_res.trajectory_start.insert(action_res.trajectory_start.end(), start_states.begin(), start_states.end());
+    action_res.planned_trajectory.insert(action_res.planned_trajectory.end(), planned_trajs.begin(),
+                                         planned_trajs.end());
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      ++num_executed;
+    }
+    cond.notify_all();
+    if (action_res.error_code.val != moveit_msgs::MoveItErrorCodes::SUCCESS)
+    {
+      break;
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stop_planning = true;
+  }
+  cond.notify_all();
+  if (action_res.error_code.val != moveit_msgs::MoveItErrorCodes::SUCCESS)
+  {
+    // Stop the planning of the following segments, otherwise the join waits for it
+    cancellation_token_.cancel();
+    command_list_manager_->terminate();
+  }
+  planning_thread.join();
+  action_res.planning_time = planning_time;
+}
+
+bool MoveGroupSequenceAction::splitSequence(const pilz_msgs::MotionSequenceRequest& req,
+                                            SequenceSegments& segments)
+{
+  segments.clear();
+  std::set<std::string> group_names;
+  bool new_segment {true};
+  for(const auto& item : req.items)
+  {
+    if (!group_names.insert(item.req.group_name).second
+        && !planning_scene::PlanningScene::isEmpty(item.req.start_state))
+    {
+      return false;
+    }
+
+    if (new_segment)
+    {
+      segments.emplace_back();
+    }
+    segments.back().items.push_back(item);
+    new_segment = (item.blend_radius == 0.);
+  }
+  return true;
+}
+
+void MoveGroupSequenceAction::setSegmentStartStates(const moveit_msgs::RobotState& initial_state,
+                                                    const GroupStateMsgs& end_states,
+                                                    pilz_msgs::MotionSequenceRequest& segment)
+{
+  std::set<std::string> group_names;
+  for(auto& item : segment.items)
+  {
+    if (!group_names.insert(item.req.group_name).second)
+    {
+      continue;
+    }
+
+    GroupStateMsgs::const_iterator end_state {end_states.find(item.req.group_name)};
+    if (end_state != end_states.cend())
+    {
+      item.req.start_state = end_state->second;
+    }
+    else if (planning_scene::PlanningScene::isEmpty(item.req.start_state))
+    {
+      item.req.start_state = initial_state;
+    }
+  }
+}
+
 void MoveGroupSequenceAction::convertToMsg(const ExecutableTrajs& trajs,
                                            StartStateMsgs& startStatesMsgs,
                                            PlannedTrajMsgs& plannedTrajsMsgs)
@@ -172,26 +409,27 @@ void MoveGroupSequenceAction::executeMoveCallbackPlanOnly(const pilz_msgs::MoveG
 {
   ROS_INFO("Planning request received for MoveGroupSequenceAction action.");
 
-  // lock the scene so that it does not modify the world representation while diff() is called
-  planning_scene_monitor::LockedPlanningSceneRO lscene(context_->planning_scene_monitor_);
-
-  const planning_scene::PlanningSceneConstPtr& the_scene =
-      (planning_scene::PlanningScene::isEmpty(goal->planning_options.planning_scene_diff)) ?
-        static_cast<const planning_scene::PlanningSceneConstPtr&>(lscene) :
-        lscene->diff(goal->planning_options.planning_scene_diff);
+  // Plan against a snapshot, so that the planning scene monitor is not blocked during planning
+  const planning_scene::PlanningSceneConstPtr the_scene {
+    takePlanningSceneSnapshot(context_->planning_scene_monitor_, goal->planning_options.planning_scene_diff)};
 
   ros::Time planning_start = ros::Time::now();
   RobotTrajCont traj_vec;
   try
   {
     traj_vec = command_list_manager_->solve(the_scene, context_->planning_pipeline_, goal->request);
+    res.error_code.val = moveit_msgs::MoveItErrorCodes::SUCCESS;
   }
   catch(const MoveItErrorCodeException& ex)
   {
     ROS_ERROR_STREAM("Planning pipeline threw an exception (error code: "
                      << ex.getErrorCode() << "): " << ex.what());
     res.error_code.val = ex.getErrorCode();
-    return;
+    if (!goal->return_partial_result)
+    {
+      return;
+    }
+    traj_vec = solvePartialSequence(the_scene, goal->request);
   }
   // LCOV_EXCL_START // Keep moveit up even if lower parts throw
   catch (const std::exception& ex)
@@ -210,23 +448,36 @@ void MoveGroupSequenceAction::executeMoveCallbackPlanOnly(const pilz_msgs::MoveG
                                                   res.trajectory_start.at(i),
                                                   res.planned_trajectory.at(i));
   }
-  res.error_code.val = moveit_msgs::MoveItErrorCodes::SUCCESS;
   res.planning_time = (ros::Time::now() - planning_start).toSec();
 }
 
 bool MoveGroupSequenceAction::planUsingSequenceManager(const pilz_msgs::MotionSequenceRequest& req,
+                                                       const bool return_partial_result,
                                                        plan_execution::ExecutableMotionPlan& plan)
 {
   setMoveState(move_group::PLANNING);
+  return planSequence(req, return_partial_result, plan);
+}
 
-  planning_scene_monitor::LockedPlanningSceneRO lscene(plan.planning_scene_monitor_);
+bool MoveGroupSequenceAction::planSequence(const pilz_msgs::MotionSequenceRequest& req,
+                                           const bool return_partial_result,
+                                           plan_execution::ExecutableMotionPlan& plan)
+{
+  // Plan against a snapshot, so that the planning scene monitor is not blocked during planning
+  const planning_scene::PlanningSceneConstPtr scene {
+    takePlanningSceneSnapshot(plan.planning_scene_monitor_, plan.planning_scene_)};
   RobotTrajCont traj_vec;
-  try { traj_vec = command_list_manager_->solve(plan.planning_scene_, context_->planning_pipeline_, req); }
+  try { traj_vec = command_list_manager_->solve(scene, context_->planning_pipeline_, req); }
   catch(const MoveItErrorCodeException& ex)
   {
     ROS_ERROR_STREAM("Planning pipeline threw an exception (error code: "
                      << ex.getErrorCode() << "): " << ex.what());
     plan.error_code_.val = ex.getErrorCode();
+    if (return_partial_result)
+    {
+      // The partial result is only reported, plan_execution does not execute failed plans
+      setPlanComponents(solvePartialSequence(scene, req), plan);
+    }
     return false;
   }
   // LCOV_EXCL_START // Keep moveit up even if lower parts throw
@@ -238,6 +489,14 @@ bool MoveGroupSequenceAction::planUsingSequenceManager(const pilz_msgs::MotionSe
   }
   // LCOV_EXCL_STOP
 
+  setPlanComponents(traj_vec, plan);
+  plan.error_code_.val = moveit_msgs::MoveItErrorCodes::SUCCESS;
+  return true;
+}
+
+void MoveGroupSequenceAction::setPlanComponents(const RobotTrajCont& traj_vec,
+                                                plan_execution::ExecutableMotionPlan& plan)
+{
   if (!traj_vec.empty())
   {
     plan.plan_components_.resize(traj_vec.size());
@@ -247,8 +506,51 @@ bool MoveGroupSequenceAction::planUsingSequenceManager(const pilz_msgs::MotionSe
       plan.plan_components_.at(i).description_ = "plan";
     }
   }
-  plan.error_code_.val = moveit_msgs::MoveItErrorCodes::SUCCESS;
-  return true;
+}
+
+RobotTrajCont MoveGroupSequenceAction::solvePartialSequence(const planning_scene::PlanningSceneConstPtr& scene,
+                                                            const pilz_msgs::MotionSequenceRequest& req)
+{
+  if (cancellation_token_.isCancelled())
+  {
+    return RobotTrajCont();
+  }
+
+  std::size_t num_solved_items {0};
+  {
+    std::lock_guard<std::mutex> lock(feedback_mutex_);
+    num_solved_items = static_cast<std::size_t>(move_feedback_.planned_item_index + 1) - progress_offset_;
+  }
+  if (num_solved_items == 0 || num_solved_items >= req.items.size())
+  {
+    return RobotTrajCont();
+  }
+
+  pilz_msgs::MotionSequenceRequest partial_req;
+  partial_req.items.assign(req.items.cbegin(), req.items.cbegin() + static_cast<long>(num_solved_items));
+  partial_req.items.back().blend_radius = 0.;
+  // The items solved before the failure are reused by the command list manager (if enabled)
+  try
+  {
+    return command_list_manager_->solve(scene, context_->planning_pipeline_, partial_req);
+  }
+  catch (const std::exception& ex)
+  {
+    ROS_WARN_STREAM("Could not determine partial result: " << ex.what());
+  }
+  return RobotTrajCont();
+}
+
+void MoveGroupSequenceAction::publishPlanningProgress(const std::size_t index,
+                                                      const std::size_t /*num_items*/,
+                                                      const double planning_time,
+                                                      const bool reused)
+{
+  std::lock_guard<std::mutex> lock(feedback_mutex_);
+  move_feedback_.planned_item_index = static_cast<int32_t>(progress_offset_ + index);
+  move_feedback_.item_planning_time = planning_time;
+  move_feedback_.item_reused = reused;
+  move_action_server_->publishFeedback(move_feedback_);
 }
 
 void MoveGroupSequenceAction::startMoveExecutionCallback()
@@ -258,11 +560,15 @@ void MoveGroupSequenceAction::startMoveExecutionCallback()
 
 void MoveGroupSequenceAction::preemptMoveCallback()
 {
+  cancellation_token_.cancel();
+  // Stops only the sequence items planned for this goal, other users of the pipeline keep planning
+  command_list_manager_->terminate();
   context_->plan_execution_->stop();
 }
 
 void MoveGroupSequenceAction::setMoveState(move_group::MoveGroupState state)
 {
+  std::lock_guard<std::mutex> lock(feedback_mutex_);
   move_state_ = state;
   move_feedback_.state = stateToStr(state);
   move_action_server_->publishFeedback(move_feedback_);
@@ -38,40 +38,37 @@
 
 #include "pilz_trajectory_generation/move_group_sequence_service.h"
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
 #include "pilz_trajectory_generation/capability_names.h"
 #include "pilz_trajectory_generation/command_list_manager.h"
+#include "pilz_trajectory_generation/planning_scene_snapshot.h"
 #include "pilz_trajectory_generation/trajectory_generation_exceptions.h"
 
 namespace pilz_trajectory_generation
 {
 
-MoveGroupSequenceService::MoveGroupSequenceService() : MoveGroupCapability("SequenceService")
-{
-}
-
-MoveGroupSequenceService::~MoveGroupSequenceService()
-{
-}
-
-void MoveGroupSequenceService::initialize()
-{
-  command_list_manager_.reset(new pilz_trajectory_generation::CommandListManager(ros::NodeHandle("~"),
-                                                                             context_->planning_scene_monitor_->getRobotModel()));
-
-  sequence_service_ = root_node_handle_.advertiseService(SEQUENCE_SERVICE_NAME,
-                                                         &MoveGroupSequenceService::plan,
-                                                         this);
-}
+//! Number of sequences of a batch which are planned concurrently (default: 1). More than one thread
+//! requires that the planners and the IK solvers of the planning groups support concurrent calls.
+static const std::string PARAM_BATCH_PLANNING_THREADS = "batch_planning_threads";
 
-bool MoveGroupSequenceService::plan(pilz_msgs::GetMotionSequence::Request& req,
-                                    pilz_msgs::GetMotionSequence::Response& res)
+/**
+ * @brief Solves the specified sequence and converts the result into the specified response.
+ *
+ * @return FALSE if the planning failed unexpectedly (no error code available), otherwise TRUE.
+ */
+template<typename ResponseType>
+static bool solveSequence(CommandListManager& manager,
+                          const planning_scene::PlanningSceneConstPtr& scene,
+                          const planning_pipeline::PlanningPipelinePtr& pipeline,
+                          const pilz_msgs::MotionSequenceRequest& req,
+                          ResponseType& res)
 {
-  // TODO: Do we lock on the correct scene? Does the lock belong to the scene used for planning?
-  planning_scene_monitor::LockedPlanningSceneRO ps(context_->planning_scene_monitor_);
-
   ros::Time planning_start = ros::Time::now();
   RobotTrajCont traj_vec;
-  try { traj_vec = command_list_manager_->solve(ps, context_->planning_pipeline_, req.commands); }
+  try { traj_vec = manager.solve(scene, pipeline, req); }
   catch(const MoveItErrorCodeException& ex)
   {
     ROS_ERROR_STREAM("Planner threw an exception (error code: "
@@ -83,7 +80,6 @@ bool MoveGroupSequenceService::plan(pilz_msgs::GetMotionSequence::Request& req,
   catch (const std::exception& ex)
   {
     ROS_ERROR_STREAM("Planner threw an exception: " << ex.what());
-    // If 'FALSE' then no response will be sent to the caller.
     return false;
   }
   // LCOV_EXCL_STOP
@@ -101,6 +97,84 @@ bool MoveGroupSequenceService::plan(pilz_msgs::GetMotionSequence::Request& req,
   return true;
 }
 
+MoveGroupSequenceService::MoveGroupSequenceService() : MoveGroupCapability("SequenceService")
+{
+}
+
+MoveGroupSequenceService::~MoveGroupSequenceService()
+{
+}
+
+void MoveGroupSequenceService::initialize()
+{
+  command_list_manager_.reset(new pilz_trajectory_generation::CommandListManager(ros::NodeHandle("~"),
+                                                                             context_->planning_scene_monitor_->getRobotModel()));
+
+  sequence_service_ = root_node_handle_.advertiseService(SEQUENCE_SERVICE_NAME,
+                                                         &MoveGroupSequenceService::plan,
+                                                         this);
+
+  ros::NodeHandle nh("~");
+  const int num_threads {std::max(1, nh.param(PARAM_BATCH_PLANNING_THREADS, 1))};
+  for(int i = 0; i < num_threads; ++i)
+  {
+    batch_managers_.emplace_back(new CommandListManager(nh, context_->planning_scene_monitor_->getRobotModel()));
+  }
+  sequence_batch_service_ = root_node_handle_.advertiseService(SEQUENCE_BATCH_SERVICE_NAME,
+                                                               &MoveGroupSequenceService::planBatch,
+                                                               this);
+}
+
+bool MoveGroupSequenceService::plan(pilz_msgs::GetMotionSequence::Request& req,
+                                    pilz_msgs::GetMotionSequence::Response& res)
+{
+  // Plan against a snapshot, so that the planning scene monitor is not blocked during planning
+  const planning_scene::PlanningSceneConstPtr scene {takePlanningSceneSnapshot(context_->planning_scene_monitor_)};
+
+  // If 'FALSE' then no response will be sent to the caller.
+  return solveSequence(*command_list_manager_, scene, context_->planning_pipeline_, req.commands, res);
+}
+
+bool MoveGroupSequenceService::planBatch(pilz_msgs::GetMotionSequenceBatch::Request& req,
+                                         pilz_msgs::GetMotionSequenceBatch::Response& res)
+{
+  std::lock_guard<std::mutex> lock(batch_mutex_);
+  ros::Time planning_start = ros::Time::now();
+
+  // Plan against a snapshot, so that the planning scene monitor is not blocked during planning
+  const planning_scene::PlanningSceneConstPtr scene {takePlanningSceneSnapshot(context_->planning_scene_monitor_)};
+
+  res.responses.resize(req.sequences.size());
+  std::atomic<std::size_t> next_index {0};
+  auto worker = [&](CommandListManager& manager)
+  {
+    for(std::size_t i = next_index++; i < req.sequences.size(); i = next_index++)
+    {
+      if (!solveSequence(manager, scene, context_->planning_pipeline_, req.sequences.at(i), res.responses.at(i)))
+      {
+        res.responses.at(i).error_code.val = moveit_msgs::MoveItErrorCodes::FAILURE;
+      }
+    }
+  };
+
+  const std::size_t num_threads {std::min(batch_managers_.size(), req.sequences.size())};
+  std::vector<std::thread> threads;
+  for(std::size_t i = 1; i < num_threads; ++i)
+  {
+    threads.emplace_back(worker, std::ref(*batch_managers_.at(i)));
+  }
+  worker(*batch_managers_.front());
+  for(auto& thread : threads)
+  {
+    thread.join();
+  }
+
+  res.planning_time = (ros::Time::now() - planning_start).toSec();
+  ROS_DEBUG_STREAM("Planned batch of " << req.sequences.size() << " sequences with " << num_threads
+                   << " threads in " << res.planning_time << "s");
+  return true;
+}
+
 } // namespace pilz_trajectory_generation
 
 #include <pluginlib/class_list_macros.h>
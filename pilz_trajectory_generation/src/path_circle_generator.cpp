@@ -17,18 +17,20 @@
 
 #include "pilz_trajectory_generation/path_circle_generator.h"
 
+#include <cmath>
+
 namespace pilz {
 
-std::unique_ptr<KDL::Path> PathCircleGenerator::circleFromCenter(
-    const KDL::Frame &start_pose,
-    const KDL::Frame &goal_pose,
-    const KDL::Vector &center_point,
+std::unique_ptr<CartesianPath> PathCircleGenerator::circleFromCenter(
+    const Eigen::Isometry3d &start_pose,
+    const Eigen::Isometry3d &goal_pose,
+    const Eigen::Vector3d &center_point,
     double eqradius
     )
 {
-  double a = (start_pose.p - center_point).Norm();
-  double b = (goal_pose.p - center_point).Norm();
-  double c = (start_pose.p - goal_pose.p).Norm();
+  double a = (start_pose.translation() - center_point).norm();
+  double b = (goal_pose.translation() - center_point).norm();
+  double c = (start_pose.translation() - goal_pose.translation()).norm();
 
   if(fabs(a-b) > MAX_RADIUS_DIFF)
   {
@@ -38,95 +40,70 @@ std::unique_ptr<KDL::Path> PathCircleGenerator::circleFromCenter(
   // compute the rotation angle
   double alpha = cosines(a,b,c);
 
-  KDL::RotationalInterpolation* rot_interpo = new KDL::RotationalInterpolation_SingleAxis();
-  double old_kdl_epsilon = KDL::epsilon;
-  try
-  {
-    KDL::epsilon = MAX_COLINEAR_NORM;
-    return std::unique_ptr<KDL::Path>(new KDL::Path_Circle(start_pose,
-                                           center_point,
-                                           goal_pose.p,
-                                           goal_pose.M,
-                                           alpha,
-                                           rot_interpo,
-                                           eqradius,
-                                           true /* take ownership of RotationalInterpolation */));
-    KDL::epsilon = old_kdl_epsilon;
-  }
-  catch(KDL::Error_MotionPlanning &)
-  {
-    delete rot_interpo; // in case we could not construct the Path object, avoid a memory leak
-    KDL::epsilon = old_kdl_epsilon;
-    throw; // and pass the exception on to the caller
-  }
+  return std::unique_ptr<CartesianPath>(new CartesianPathCircle(start_pose,
+                                                                center_point,
+                                                                goal_pose.translation(),
+                                                                Eigen::Quaterniond(goal_pose.linear()),
+                                                                alpha,
+                                                                eqradius,
+                                                                MAX_COLINEAR_NORM));
 }
 
-std::unique_ptr<KDL::Path> PathCircleGenerator::circleFromInterim(
-    const KDL::Frame &start_pose,
-    const KDL::Frame &goal_pose,
-    const KDL::Vector &interim_point,
+std::unique_ptr<CartesianPath> PathCircleGenerator::circleFromInterim(
+    const Eigen::Isometry3d &start_pose,
+    const Eigen::Isometry3d &goal_pose,
+    const Eigen::Vector3d &interim_point,
     double eqradius
     )
 {
   // compute the center point from interim point
   // triangle edges
-  const KDL::Vector t = interim_point - start_pose.p;
-  const KDL::Vector u = goal_pose.p - start_pose.p;
-  const KDL::Vector v = goal_pose.p - interim_point;
+  const Eigen::Vector3d t = interim_point - start_pose.translation();
+  const Eigen::Vector3d u = goal_pose.translation() - start_pose.translation();
+  const Eigen::Vector3d v = goal_pose.translation() - interim_point;
   // triangle normal
-  const KDL::Vector w = t*u; // cross product
+  const Eigen::Vector3d w = t.cross(u);
 
   // circle center
-  if (w.Norm() < MAX_COLINEAR_NORM)
+  if (w.norm() < MAX_COLINEAR_NORM)
   {
     throw KDL::Error_MotionPlanning_Circle_No_Plane();
   }
-  const KDL::Vector center_point = start_pose.p + (u*dot(t,t)*dot(u,v) - t*dot(u,u)*dot(t,v))* 0.5/pow(w.Norm(),2);
+  const Eigen::Vector3d center_point = start_pose.translation()
+      + (u*t.dot(t)*u.dot(v) - t*u.dot(u)*t.dot(v))* 0.5/pow(w.norm(),2);
 
   // compute the rotation angle
   // triangle edges
-  const KDL::Vector t_center = center_point - start_pose.p;
-  const KDL::Vector v_center = goal_pose.p - center_point;
-  double a = t_center.Norm();
-  double b = v_center.Norm();
-  double c = u.Norm();
+  const Eigen::Vector3d t_center = center_point - start_pose.translation();
+  const Eigen::Vector3d v_center = goal_pose.translation() - center_point;
+  double a = t_center.norm();
+  double b = v_center.norm();
+  double c = u.norm();
   double alpha = cosines(a,b,c);
 
-  KDL::Vector kdl_aux_point(interim_point);
+  Eigen::Vector3d aux_point(interim_point);
 
   // if the angle at the interim is an acute angle (<90deg), rotation angle is an obtuse angle (>90deg)
-  // in this case using the interim as auxiliary point for KDL::Path_Circle can lead to a path in the wrong direction
-  double interim_angle = cosines(t.Norm(), v.Norm(), u.Norm());
+  // in this case using the interim as auxiliary point for the circle can lead to a path in the wrong direction
+  double interim_angle = cosines(t.norm(), v.norm(), u.norm());
   if(interim_angle < M_PI/2)
   {
     alpha = 2*M_PI - alpha;
 
     // exclude that the goal is not colinear with start and center, then use the opposite of the goal as auxiliary point
-    if ((t_center*v_center).Norm() > MAX_COLINEAR_NORM)
+    if (t_center.cross(v_center).norm() > MAX_COLINEAR_NORM)
     {
-      kdl_aux_point = 2*center_point - goal_pose.p;
+      aux_point = 2*center_point - goal_pose.translation();
     }
   }
 
-  KDL::RotationalInterpolation* rot_interpo = new KDL::RotationalInterpolation_SingleAxis();
-  try
-  {
-    return std::unique_ptr<KDL::Path>(new KDL::Path_Circle(start_pose,
-                                                  center_point,
-                                                  kdl_aux_point,
-                                                  goal_pose.M,
-                                                  alpha,
-                                                  rot_interpo,
-                                                  eqradius,
-                                                  true /* take ownership of RotationalInterpolation */));
-  }
-  catch(KDL::Error_MotionPlanning &) // LCOV_EXCL_START // The cases where KDL would throw are already handled above,
-                                                        // we keep these lines to be safe
-  {
-    delete rot_interpo; // in case we could not construct the Path object, avoid a memory leak
-    throw; // and pass the exception on to the caller
-    // LCOV_EXCL_STOP
-  }
+  return std::unique_ptr<CartesianPath>(new CartesianPathCircle(start_pose,
+                                                                center_point,
+                                                                aux_point,
+                                                                Eigen::Quaterniond(goal_pose.linear()),
+                                                                alpha,
+                                                                eqradius,
+                                                                MAX_COLINEAR_NORM));
 }
 
 double PathCircleGenerator::cosines(const double a, const double b, const double c)
@@ -21,8 +21,7 @@
 #include "pilz_trajectory_generation/planning_context_loader_ptp.h"
 #include "pilz_trajectory_generation/planning_exceptions.h"
 
-#include "pilz_trajectory_generation/joint_limits_aggregator.h"
-#include "pilz_trajectory_generation/cartesian_limits_aggregator.h"
+#include "pilz_trajectory_generation/limits_aggregator.h"
 
 // Boost includes
 #include <boost/scoped_ptr.hpp>
@@ -35,6 +34,12 @@ namespace pilz {
 
 static const std::string PARAM_NAMESPACE_LIMTS = "robot_description_planning";
 
+/// Sampling times of the commands are read from "<ns>/sampling_time/<command>"
+static const std::string PARAM_SAMPLING_TIME = "sampling_time";
+
+/// Plugins with this prefix are named after their command and can therefore be created on first use
+static const std::string CONTEXT_LOADER_CLASS_PREFIX = "pilz::PlanningContextLoader";
+
 bool CommandPlanner::initialize(const moveit::core::RobotModelConstPtr &model, const std::string &ns)
 {
   // Call parent class initialize
@@ -44,12 +49,8 @@ bool CommandPlanner::initialize(const moveit::core::RobotModelConstPtr &model, c
   model_ = model;
   namespace_ = ns;
 
-  // Obtain the aggregated joint limits
-  aggregated_limit_active_joints_ = pilz::JointLimitsAggregator::getAggregatedLimits(
-        ros::NodeHandle(PARAM_NAMESPACE_LIMTS),model->getActiveJointModels());
-
-  // Obtain cartesian limits
-  cartesian_limit_ = pilz::CartesianLimitsAggregator::getAggregatedLimits(ros::NodeHandle(PARAM_NAMESPACE_LIMTS));
+  // Obtain the aggregated joint limits and the cartesian limits, they are read again on each initialization
+  limits_ = *pilz::LimitsAggregator::reloadAggregatedLimits(ros::NodeHandle(PARAM_NAMESPACE_LIMTS), model_);
 
   // Load the planning context loader
   planner_context_loader.reset(new pluginlib::ClassLoader<PlanningContextLoader>("pilz_trajectory_generation",
@@ -65,22 +66,25 @@ bool CommandPlanner::initialize(const moveit::core::RobotModelConstPtr &model, c
 
   ROS_INFO_STREAM("Available plugins: " << ss.str());
 
-  // Load each factory
+  // Register each factory, the plugins are created on first use if possible
   for (const auto& factory : factories)
   {
-
-    ROS_INFO_STREAM("About to load: " << factory);
-    PlanningContextLoaderPtr loader_pointer(planner_context_loader->createInstance(factory));
-
-    pilz::LimitsContainer limits;
-    limits.setJointLimits(aggregated_limit_active_joints_);
-    limits.setCartesianLimits(cartesian_limit_);
-
-    loader_pointer->setLimits(limits);
-    loader_pointer->setModel(model_);
-
-    registerContextLoader(loader_pointer);
-
+    if(factory.size() > CONTEXT_LOADER_CLASS_PREFIX.size() &&
+       factory.compare(0, CONTEXT_LOADER_CLASS_PREFIX.size(), CONTEXT_LOADER_CLASS_PREFIX) == 0)
+    {
+      const std::string algorithm {factory.substr(CONTEXT_LOADER_CLASS_PREFIX.size())};
+      if(context_loader_map_.find(algorithm) != context_loader_map_.end())
+      {
+        throw ContextLoaderRegistrationException("The command [" + algorithm + "] is already registered");
+      }
+      context_loader_map_[algorithm].class_name = factory;
+      ROS_INFO_STREAM("Registered Algorithm [" << algorithm << "] (" << factory << " is loaded on first use)");
+    }
+    else
+    {
+      ROS_INFO_STREAM("About to load: " << factory);
+      registerContextLoader(createContextLoader(factory));
+    }
   }
 
   return true;
@@ -115,9 +119,16 @@ planning_interface::PlanningContextPtr CommandPlanner::getPlanningContext(
     return nullptr;
   }
 
+  const pilz::PlanningContextLoaderPtr context_loader {getContextLoader(context_loader_map_.at(req.planner_id))};
+  if(!context_loader)
+  {
+    error_code.val = moveit_msgs::MoveItErrorCodes::PLANNING_FAILED;
+    return nullptr;
+  }
+
   planning_interface::PlanningContextPtr planning_context;
 
-  if(context_loader_map_.at(req.planner_id)->loadContext(planning_context, req.planner_id, req.group_name))
+  if(context_loader->loadContext(planning_context, req.planner_id, req.group_name))
   {
     ROS_DEBUG_STREAM("Found planning context loader for " << req.planner_id << " group:" << req.group_name);
     planning_context->setMotionPlanRequest(req);
@@ -141,7 +152,7 @@ void CommandPlanner::registerContextLoader(const pilz::PlanningContextLoaderPtr&
   // Only add if command is not already in list, throw exception if not
   if(context_loader_map_.find(planning_context_loader->getAlgorithm()) == context_loader_map_.end())
   {
-    context_loader_map_[planning_context_loader->getAlgorithm()] = planning_context_loader;
+    context_loader_map_[planning_context_loader->getAlgorithm()].loader = planning_context_loader;
     ROS_INFO_STREAM("Registered Algorithm [" << planning_context_loader->getAlgorithm() << "]");
   }
   else
@@ -151,6 +162,40 @@ void CommandPlanner::registerContextLoader(const pilz::PlanningContextLoaderPtr&
   }
 }
 
+pilz::PlanningContextLoaderPtr CommandPlanner::getContextLoader(const ContextLoaderEntry& entry) const
+{
+  std::lock_guard<std::mutex> lock(context_loader_mutex_);
+  if(!entry.loader)
+  {
+    try
+    {
+      ROS_INFO_STREAM("About to load: " << entry.class_name);
+      entry.loader = createContextLoader(entry.class_name);
+    }
+    catch(const pluginlib::PluginlibException& ex)
+    {
+      ROS_ERROR_STREAM("Failed to load " << entry.class_name << ": " << ex.what());
+    }
+  }
+  return entry.loader;
+}
+
+pilz::PlanningContextLoaderPtr CommandPlanner::createContextLoader(const std::string& class_name) const
+{
+  PlanningContextLoaderPtr loader_pointer(planner_context_loader->createInstance(class_name));
+  loader_pointer->setLimits(limits_);
+  loader_pointer->setModel(model_);
+
+  double sampling_time;
+  const std::string sampling_time_param {PARAM_SAMPLING_TIME + "/" + loader_pointer->getAlgorithm()};
+  if(ros::NodeHandle(namespace_).getParam(sampling_time_param, sampling_time)
+     && !loader_pointer->setSamplingTime(sampling_time))
+  {
+    ROS_WARN_STREAM("Ignoring invalid sampling time " << sampling_time << " of parameter " << sampling_time_param);
+  }
+  return loader_pointer;
+}
+
 } // namespace pilz
 
 PLUGINLIB_EXPORT_CLASS(pilz::CommandPlanner, planning_interface::PlannerManager)
@@ -17,7 +17,13 @@
 
 #include "pilz_trajectory_generation/plan_components_builder.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <exception>
+#include <thread>
+
+#include <ros/console.h>
 
 #include <pilz_trajectory_generation/tip_frame_getter.h>
 
@@ -26,6 +32,11 @@ namespace pilz_trajectory_generation
 
 std::vector<robot_trajectory::RobotTrajectoryPtr> PlanComponentsBuilder::build() const
 {
+  if (parallel_blending_)
+  {
+    return buildParallel();
+  }
+
   std::vector<robot_trajectory::RobotTrajectoryPtr> res_vec {traj_cont_};
   if (traj_tail_)
   {
@@ -35,7 +46,7 @@ std::vector<robot_trajectory::RobotTrajectoryPtr> PlanComponentsBuilder::build()
   return res_vec;
 }
 
-void PlanComponentsBuilder::appendWithStrictTimeIncrease(robot_trajectory::RobotTrajectory &result, const robot_trajectory::RobotTrajectory &source)
+void PlanComponentsBuilder::appendWithStrictTimeIncrease(robot_trajectory::RobotTrajectory &result, robot_trajectory::RobotTrajectory &source)
 {
   if (result.empty() ||
       !pilz::isRobotStateEqual(result.getLastWayPoint(), source.getFirstWayPoint(),
@@ -47,34 +58,64 @@ void PlanComponentsBuilder::appendWithStrictTimeIncrease(robot_trajectory::Robot
 
   for (size_t i = 1; i < source.getWayPointCount(); ++i)
   {
-    result.addSuffixWayPoint(source.getWayPoint(i), source.getWayPointDurationFromPrevious(i));
+    result.addSuffixWayPoint(source.getWayPointPtr(i), source.getWayPointDurationFromPrevious(i));
   }
 }
 
-void PlanComponentsBuilder::blend(const robot_trajectory::RobotTrajectoryPtr& other,
-                                  const double blend_radius)
+void PlanComponentsBuilder::blend(const robot_trajectory::RobotTrajectoryPtr& first,
+                                  const robot_trajectory::RobotTrajectoryPtr& second,
+                                  const double blend_radius,
+                                  pilz::TrajectoryBlendResponse& blend_response) const
 {
-  if (!blender_)
+  assert(first->getGroupName() == second->getGroupName());
+
+  const BlendCache::key_type key {first.get(), second.get()};
+  BlendCache::const_iterator cached {blend_cache_.find(key)};
+  if (cached != blend_cache_.cend() && cached->second.blend_radius == blend_radius)
   {
-    throw NoBlenderSetException("No blender set");
+    blend_response = cached->second.response;
   }
+  else
+  {
+    pilz::TrajectoryBlendRequest blend_request;
 
-  assert(other->getGroupName() == traj_tail_->getGroupName());
+    blend_request.first_trajectory = first;
+    blend_request.second_trajectory = second;
+    blend_request.blend_radius = blend_radius;
+    blend_request.group_name = first->getGroupName();
+    blend_request.link_name = getSolverTipFrame(model_->getJointModelGroup(blend_request.group_name));
+    blend_request.cancellation_token = cancellation_token_;
+    blend_request.deadline = deadline_;
 
-  pilz::TrajectoryBlendRequest blend_request;
+    if (!blender_->blend(blend_request, blend_response))
+    {
+      if (blend_response.error_code.val == moveit_msgs::MoveItErrorCodes::PREEMPTED)
+      {
+        throw PlanningCancelledException("Blending cancelled");
+      }
+      if (blend_response.error_code.val == moveit_msgs::MoveItErrorCodes::TIMED_OUT)
+      {
+        throw PlanningTimedOutException("Allowed planning time exceeded during blending");
+      }
+      throw BlendingFailedException("Blending failed");
+    }
+  }
 
-  blend_request.first_trajectory = traj_tail_;
-  blend_request.second_trajectory = other;
-  blend_request.blend_radius = blend_radius;
-  blend_request.group_name = traj_tail_->getGroupName();
-  blend_request.link_name = getSolverTipFrame(model_->getJointModelGroup(blend_request.group_name));
+  std::lock_guard<std::mutex> lock(used_blends_mutex_);
+  used_blends_[key] = BlendCacheEntry {first, second, blend_radius, blend_response};
+}
 
-  pilz::TrajectoryBlendResponse blend_response;
-  if (!blender_->blend(blend_request, blend_response))
+void PlanComponentsBuilder::blend(const robot_trajectory::RobotTrajectoryPtr& other,
+                                  const double blend_radius)
+{
+  if (!blender_)
   {
-    throw BlendingFailedException("Blending failed");
+    throw NoBlenderSetException("No blender set");
   }
 
+  pilz::TrajectoryBlendResponse blend_response;
+  blend(traj_tail_, other, blend_radius, blend_response);
+
   // Append the new trajectory elements
   appendWithStrictTimeIncrease(*(traj_cont_.back()),*blend_response.first_trajectory);
   traj_cont_.back()->append(*blend_response.blend_trajectory, 0.0);
@@ -90,6 +131,17 @@ void PlanComponentsBuilder::append(const robot_trajectory::RobotTrajectoryPtr& o
     throw NoRobotModelSetException("No robot model set");
   }
 
+  if (parallel_blending_)
+  {
+    segments_.emplace_back(other, blend_radius);
+    if (!blender_ && isBlended(segments_.size()-1))
+    {
+      segments_.pop_back();
+      throw NoBlenderSetException("No blender set");
+    }
+    return;
+  }
+
   if (!traj_tail_)
   {
     traj_tail_ = other;
@@ -119,4 +171,179 @@ void PlanComponentsBuilder::append(const robot_trajectory::RobotTrajectoryPtr& o
   blend(other, blend_radius);
 }
 
+bool PlanComponentsBuilder::isBlended(const std::size_t index) const
+{
+  return index > 0
+      && segments_.at(index).second > 0.0
+      && segments_.at(index).first->getGroupName() == segments_.at(index-1).first->getGroupName();
+}
+
+void PlanComponentsBuilder::blendConcurrently(std::vector<pilz::TrajectoryBlendResponse>& blend_responses,
+                                              std::vector<char>& blend_success) const
+{
+  std::vector<std::size_t> junctions;
+  for (std::size_t i = 1; i < segments_.size(); ++i)
+  {
+    if (isBlended(i))
+    {
+      junctions.push_back(i);
+    }
+  }
+
+  blend_responses.assign(segments_.size(), pilz::TrajectoryBlendResponse());
+  blend_success.assign(segments_.size(), false);
+
+  std::atomic<std::size_t> next_junction {0};
+  std::exception_ptr error;
+  std::mutex error_mutex;
+  auto worker = [&]()
+  {
+    for (std::size_t j = next_junction++; j < junctions.size(); j = next_junction++)
+    {
+      const std::size_t i {junctions.at(j)};
+      try
+      {
+        blend(segments_.at(i-1).first, segments_.at(i).first, segments_.at(i).second, blend_responses.at(i));
+        blend_success.at(i) = true;
+      }
+      catch (const BlendingFailedException&)
+      {
+        // Failed junctions are blended again while stitching, which reports the error.
+      }
+      catch (...)
+      {
+        // E.g. cancellation or timeout: The remaining junctions are skipped
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!error)
+        {
+          error = std::current_exception();
+        }
+        next_junction = junctions.size();
+      }
+    }
+  };
+
+  const std::size_t num_threads {std::min({max_blending_threads_,
+                                           static_cast<std::size_t>(std::max(1u, std::thread::hardware_concurrency())),
+                                           junctions.size()})};
+  std::vector<std::thread> threads;
+  for (std::size_t t = 1; t < num_threads; ++t)
+  {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (std::thread& thread : threads)
+  {
+    thread.join();
+  }
+
+  if (error)
+  {
+    std::rethrow_exception(error);
+  }
+}
+
+robot_trajectory::RobotTrajectoryPtr PlanComponentsBuilder::joinBlendParts(const robot_trajectory::RobotTrajectory &complete,
+                                                                           robot_trajectory::RobotTrajectory &tail,
+                                                                           robot_trajectory::RobotTrajectory &blend_first)
+{
+  // The tail is the end of the complete trajectory, except for its first waypoints, which might be resampled.
+  const std::size_t offset {complete.getWayPointCount() - tail.getWayPointCount()};
+  std::size_t tail_resampled {0};
+  while (tail_resampled < tail.getWayPointCount() &&
+         &tail.getWayPoint(tail_resampled) != &complete.getWayPoint(offset + tail_resampled))
+  {
+    ++tail_resampled;
+  }
+
+  // The first trajectory of the blend is the beginning of the complete trajectory, except for its last
+  // waypoints, which might be resampled.
+  std::size_t first_shared {0};
+  while (first_shared < blend_first.getWayPointCount() &&
+         &blend_first.getWayPoint(first_shared) == &complete.getWayPoint(first_shared))
+  {
+    ++first_shared;
+  }
+
+  // At least one shared waypoint is needed to join the parts
+  if (first_shared <= offset + tail_resampled)
+  {
+    return nullptr;
+  }
+
+  robot_trajectory::RobotTrajectoryPtr joined {
+    new robot_trajectory::RobotTrajectory(complete.getRobotModel(), complete.getGroupName()) };
+  for (std::size_t i = 0; i < first_shared - offset; ++i)
+  {
+    joined->addSuffixWayPoint(tail.getWayPointPtr(i), tail.getWayPointDurationFromPrevious(i));
+  }
+  for (std::size_t i = first_shared; i < blend_first.getWayPointCount(); ++i)
+  {
+    joined->addSuffixWayPoint(blend_first.getWayPointPtr(i), blend_first.getWayPointDurationFromPrevious(i));
+  }
+  return joined;
+}
+
+std::vector<robot_trajectory::RobotTrajectoryPtr> PlanComponentsBuilder::buildParallel() const
+{
+  std::vector<pilz::TrajectoryBlendResponse> blend_responses;
+  std::vector<char> blend_success;
+  blendConcurrently(blend_responses, blend_success);
+
+  // Stitch the trajectories and blend results together (same rules as append())
+  std::vector<robot_trajectory::RobotTrajectoryPtr> res_vec;
+  robot_trajectory::RobotTrajectoryPtr tail;
+  for (std::size_t i = 0; i < segments_.size(); ++i)
+  {
+    const robot_trajectory::RobotTrajectoryPtr& curr {segments_.at(i).first};
+
+    // Create new trajectory for every group change
+    if (!tail || curr->getGroupName() != tail->getGroupName())
+    {
+      if (tail)
+      {
+        appendWithStrictTimeIncrease(*(res_vec.back()), *tail);
+      }
+      tail = curr;
+      res_vec.emplace_back( new robot_trajectory::RobotTrajectory(model_, curr->getGroupName()) );
+      continue;
+    }
+
+    // No blending
+    if (!isBlended(i))
+    {
+      appendWithStrictTimeIncrease(*(res_vec.back()), *tail);
+      tail = curr;
+      continue;
+    }
+
+    pilz::TrajectoryBlendResponse& blend_response {blend_responses.at(i)};
+    robot_trajectory::RobotTrajectoryPtr first_part;
+    if (blend_success.at(i))
+    {
+      first_part = (tail == segments_.at(i-1).first) ?
+            blend_response.first_trajectory :
+            joinBlendParts(*segments_.at(i-1).first, *tail, *blend_response.first_trajectory);
+    }
+
+    // Fall back to sequential blending, if the concurrent blend cannot be used
+    if (!first_part)
+    {
+      ROS_DEBUG_STREAM("Blending of trajectory [" << i << "] with its predecessor is repeated sequentially.");
+      blend(tail, curr, segments_.at(i).second, blend_response);
+      first_part = blend_response.first_trajectory;
+    }
+
+    appendWithStrictTimeIncrease(*(res_vec.back()), *first_part);
+    res_vec.back()->append(*blend_response.blend_trajectory, 0.0);
+    tail = blend_response.second_trajectory;
+  }
+
+  if (tail)
+  {
+    appendWithStrictTimeIncrease(*(res_vec.back()), *tail);
+  }
+  return res_vec;
+}
+
 } // namespace pilz_trajectory_generation
@@ -30,6 +30,8 @@ bool pilz::PlanningContextLoader::setModel(const moveit::core::RobotModelConstPt
 {
   model_ = model;
   model_set_ = true;
+  // Contexts in use keep the old model, so they must not return to the new pool
+  context_pool_ = std::make_shared<PlanningContextPool>();
   return true;
 }
 
@@ -37,6 +39,18 @@ bool pilz::PlanningContextLoader::setLimits(const pilz::LimitsContainer &limits)
 {
   limits_ = limits;
   limits_set_ = true;
+  // Contexts in use keep the old limits, so they must not return to the new pool
+  context_pool_ = std::make_shared<PlanningContextPool>();
+  return true;
+}
+
+bool pilz::PlanningContextLoader::setSamplingTime(double sampling_time)
+{
+  if(sampling_time <= 0.)
+  {
+    return false;
+  }
+  sampling_time_ = sampling_time;
   return true;
 }
 
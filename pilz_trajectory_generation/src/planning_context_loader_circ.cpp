@@ -36,22 +36,7 @@ bool pilz::PlanningContextLoaderCIRC::loadContext(planning_interface::PlanningCo
                                                  const std::string& name,
                                                  const std::string& group) const
 {
-  if(limits_set_ && model_set_) {
-    planning_context.reset(new PlanningContextCIRC(name, group, model_, limits_));
-    return true;
-  }
-  else
-  {
-    if(!limits_set_)
-    {
-      ROS_ERROR_STREAM("Limits are not defined. Cannot load planning context. Call setLimits loadContext");
-    }
-    if(!model_set_)
-    {
-      ROS_ERROR_STREAM("Robot model was not set");
-    }
-    return false;
-  }
+  return PlanningContextLoader::loadContext<PlanningContextCIRC>(planning_context, name, group);
 }
 
 PLUGINLIB_EXPORT_CLASS(pilz::PlanningContextLoaderCIRC, pilz::PlanningContextLoader)
@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2018 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pilz_trajectory_generation/planning_core.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#include <kdl/velocityprofile_trap.hpp>
+
+#include "pilz_trajectory_generation/path_circle_generator.h"
+#include "pilz_trajectory_generation/velocity_profile_atrap.h"
+
+namespace pilz {
+
+//! Joints moving less than this are considered to be at the goal.
+static constexpr double MIN_MOVEMENT {0.001};
+
+std::vector<double> sampleTimes(const double duration, const double sampling_time)
+{
+  const double epsilon = 10e-06; // avoid adding the last time sample twice
+  std::vector<double> time_samples;
+  for(double t_sample=0.0; t_sample < duration - epsilon; t_sample+=sampling_time)
+  {
+    time_samples.push_back(t_sample);
+  }
+  time_samples.push_back(duration);
+  return time_samples;
+}
+
+void sampleCartesianTrajectory(const CartesianPath& path,
+                               const KDL::VelocityProfile& velocity_profile,
+                               const double sampling_time,
+                               CartesianSamples& samples)
+{
+  samples.time_samples = sampleTimes(velocity_profile.Duration(), sampling_time);
+  std::vector<double> path_params(samples.time_samples.size());
+  std::transform(samples.time_samples.begin(), samples.time_samples.end(), path_params.begin(),
+                 [&velocity_profile](const double t){ return velocity_profile.Pos(t); });
+
+  // evaluate all poses at once
+  path.getPoses(path_params, samples.poses);
+}
+
+std::unique_ptr<KDL::VelocityProfile> cartesianTrapVelocityProfile(const CartesianLimit& limit,
+                                                                   const double velocity_scaling_factor,
+                                                                   const double acceleration_scaling_factor,
+                                                                   const double path_length)
+{
+  std::unique_ptr<KDL::VelocityProfile> vp_trans(
+        new KDL::VelocityProfile_Trap(
+          velocity_scaling_factor*limit.getMaxTranslationalVelocity(),
+          acceleration_scaling_factor*limit.getMaxTranslationalAcceleration()));
+
+  if(path_length > std::numeric_limits<double>::epsilon()) // avoid division by zero
+  {
+    vp_trans->SetProfile(0, path_length);
+  }
+  else
+  {
+    vp_trans->SetProfile(0, std::numeric_limits<double>::epsilon());
+  }
+  return vp_trans;
+}
+
+std::unique_ptr<CartesianPath> createLINPath(const Eigen::Isometry3d& start_pose,
+                                             const Eigen::Isometry3d& goal_pose,
+                                             const CartesianLimit& limit)
+{
+  const double eqradius {limit.getMaxTranslationalVelocity()/limit.getMaxRotationalVelocity()};
+  return std::unique_ptr<CartesianPath>(new CartesianPathLine(start_pose, goal_pose, eqradius));
+}
+
+std::unique_ptr<CartesianPath> createCIRCPath(const Eigen::Isometry3d& start_pose,
+                                              const Eigen::Isometry3d& goal_pose,
+                                              const Eigen::Vector3d& path_point,
+                                              const bool path_point_is_center,
+                                              const CartesianLimit& limit)
+{
+  // pass the ratio of translational by rotational velocity as equivalent radius
+  // to get a trajectory with rotational speed, if no (or very little) translational distance
+  // The CartesianPath implementation chooses the motion with the longer duration (translation vs. rotation)
+  // and uses eqradius as scaling factor between the distances.
+  const double eqradius {limit.getMaxTranslationalVelocity()/limit.getMaxRotationalVelocity()};
+
+  if(path_point_is_center)
+  {
+    return PathCircleGenerator::circleFromCenter(start_pose, goal_pose, path_point, eqradius);
+  }
+  return PathCircleGenerator::circleFromInterim(start_pose, goal_pose, path_point, eqradius);
+}
+
+void planCartesianTrajectory(const CartesianPath& path,
+                             const CartesianLimit& limit,
+                             const double velocity_scaling_factor,
+                             const double acceleration_scaling_factor,
+                             const double sampling_time,
+                             CartesianSamples& samples)
+{
+  const std::unique_ptr<KDL::VelocityProfile> velocity_profile {
+    cartesianTrapVelocityProfile(limit, velocity_scaling_factor, acceleration_scaling_factor, path.getLength())};
+  sampleCartesianTrajectory(path, *velocity_profile, sampling_time, samples);
+}
+
+bool planPTPTrajectory(const std::map<std::string, double>& start_positions,
+                       const std::map<std::string, double>& goal_positions,
+                       const pilz_extensions::JointLimit& limit,
+                       const double velocity_scaling_factor,
+                       const double acceleration_scaling_factor,
+                       const double sampling_time,
+                       JointSpaceTrajectory& trajectory)
+{
+  // initialize joint names
+  trajectory.joint_names.clear();
+  trajectory.samples.clear();
+  for(const auto& item : goal_positions)
+  {
+    trajectory.joint_names.push_back(item.first);
+  }
+
+  // check if goal already reached
+  bool goal_reached = true;
+  for(auto const& goal: goal_positions)
+  {
+    if(std::fabs(start_positions.at(goal.first) - goal.second) >= MIN_MOVEMENT )
+    {
+      goal_reached = false;
+      break;
+    }
+  }
+  if(goal_reached)
+  {
+    JointTrajectorySample sample;
+    sample.time_from_start = sampling_time;
+    for(const std::string & joint_name : trajectory.joint_names)
+    {
+      sample.positions.push_back(start_positions.at(joint_name));
+      sample.velocities.push_back(0);
+      sample.accelerations.push_back(0);
+    }
+    trajectory.samples.push_back(sample);
+    return false;
+  }
+
+  // compute the fastest trajectory and choose the slowest joint as leading axis
+  std::string leading_axis = trajectory.joint_names.front();
+  double max_duration = -1.0;
+
+  std::map<std::string, VelocityProfile_ATrap> velocity_profile;
+  for(const auto& joint_name : trajectory.joint_names)
+  {
+    // create vecocity profile if necessary
+    velocity_profile.insert(std::make_pair(
+                              joint_name,
+                              VelocityProfile_ATrap(
+                                velocity_scaling_factor * limit.max_velocity,
+                                acceleration_scaling_factor * limit.max_acceleration,
+                                acceleration_scaling_factor * limit.max_deceleration)));
+
+    velocity_profile.at(joint_name).SetProfile(start_positions.at(joint_name), goal_positions.at(joint_name));
+    if(velocity_profile.at(joint_name).Duration() > max_duration)
+    {
+      max_duration = velocity_profile.at(joint_name).Duration();
+      leading_axis = joint_name;
+    }
+  }
+
+  // Full Synchronization
+  // This should only work if all axes have same max_vel, max_acc, max_dec values
+  // reset the velocity profile for other joints
+  double acc_time = velocity_profile.at(leading_axis).FirstPhaseDuration();
+  double const_time = velocity_profile.at(leading_axis).SecondPhaseDuration();
+  double dec_time = velocity_profile.at(leading_axis).ThirdPhaseDuration();
+
+  for(const auto& joint_name : trajectory.joint_names)
+  {
+    if(joint_name != leading_axis)
+    {
+      // make full synchronization
+      // causes the program to terminate if acc_time<=0 or dec_time<=0 (should be prevented by goal_reached block above)
+      // by using the most strict limit, the following should always return true
+      if (!velocity_profile.at(joint_name).setProfileAllDurations(start_positions.at(joint_name),
+                                                                  goal_positions.at(joint_name),
+                                                                  acc_time,const_time,dec_time))
+        // LCOV_EXCL_START
+      {
+        std::stringstream error_str;
+        error_str << "Can not synchronize velocity profile of axis " << joint_name
+                  << " with leading axis " << leading_axis;
+        throw std::runtime_error(error_str.str());
+      }
+      // LCOV_EXCL_STOP
+    }
+  }
+
+  // first generate the time samples
+  const std::vector<double> time_samples {sampleTimes(max_duration, sampling_time)};
+
+  // construct joint trajectory samples
+  trajectory.samples.reserve(time_samples.size());
+  for(double time_stamp : time_samples)
+  {
+    JointTrajectorySample sample;
+    sample.time_from_start = time_stamp;
+    for(const std::string & joint_name : trajectory.joint_names)
+    {
+      sample.positions.push_back(velocity_profile.at(joint_name).Pos(time_stamp));
+      sample.velocities.push_back(velocity_profile.at(joint_name).Vel(time_stamp));
+      sample.accelerations.push_back(velocity_profile.at(joint_name).Acc(time_stamp));
+    }
+    trajectory.samples.push_back(sample);
+  }
+
+  // Set last sample exactly to the goal, so that the end state does not depend on
+  // numerical deviations of the velocity profile
+  for(std::size_t i = 0; i < trajectory.joint_names.size(); ++i)
+  {
+    trajectory.samples.back().positions.at(i) = goal_positions.at(trajectory.joint_names.at(i));
+  }
+
+  // Set last sample velocity and acceleration to zero
+  std::fill(trajectory.samples.back().velocities.begin(), trajectory.samples.back().velocities.end(), 0.0);
+  std::fill(trajectory.samples.back().accelerations.begin(), trajectory.samples.back().accelerations.end(), 0.0);
+  return true;
+}
+
+JointLimitViolation checkSampleJointLimits(const std::map<std::string, double>& position_last,
+                                           const std::map<std::string, double>& velocity_last,
+                                           const std::map<std::string, double>& position_current,
+                                           const double duration_last,
+                                           const double duration_current,
+                                           const JointLimitsContainer& joint_limits,
+                                           std::string& violating_joint,
+                                           double& violating_value)
+{
+  const double epsilon = 10e-6;
+  if(duration_current <= epsilon)
+  {
+    return JointLimitViolation::SAMPLE_DURATION_TOO_SMALL;
+  }
+
+  for(const auto& pos : position_current)
+  {
+    const double velocity_current {(pos.second - position_last.at(pos.first))/duration_current};
+
+    if(!joint_limits.verifyVelocityLimit(pos.first, velocity_current))
+    {
+      violating_joint = pos.first;
+      violating_value = velocity_current;
+      return JointLimitViolation::VELOCITY;
+    }
+
+    const double acceleration_current {(velocity_current - velocity_last.at(pos.first))
+                                       /(duration_last + duration_current)*2};
+    // acceleration case
+    if(std::fabs(velocity_last.at(pos.first))<=std::fabs(velocity_current))
+    {
+      if(joint_limits.getLimit(pos.first).has_acceleration_limits &&
+         std::fabs(acceleration_current)>std::fabs(joint_limits.getLimit(pos.first).max_acceleration))
+      {
+        violating_joint = pos.first;
+        violating_value = acceleration_current;
+        return JointLimitViolation::ACCELERATION;
+      }
+    }
+    // deceleration case
+    else
+    {
+      if(joint_limits.getLimit(pos.first).has_deceleration_limits &&
+         std::fabs(acceleration_current)>std::fabs(joint_limits.getLimit(pos.first).max_deceleration))
+      {
+        violating_joint = pos.first;
+        violating_value = acceleration_current;
+        return JointLimitViolation::DECELERATION;
+      }
+    }
+  }
+
+  return JointLimitViolation::NONE;
+}
+
+} // namespace pilz
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2018 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pilz_trajectory_generation/sequence_cache.h"
+
+#include <cmath>
+#include <memory>
+
+namespace pilz_trajectory_generation
+{
+
+SequenceCache::SequenceCache(const std::size_t capacity, const double start_position_tolerance)
+  : capacity_(capacity)
+  , start_position_tolerance_(start_position_tolerance)
+{
+}
+
+bool SequenceCache::lookup(const std::string& key,
+                           const std::vector<double>& start_positions,
+                           TrajCont& trajs)
+{
+  auto it {index_.find(key)};
+  if (it == index_.end() || !isWithinTolerance(it->second->start_positions, start_positions))
+  {
+    ++statistics_.misses;
+    return false;
+  }
+
+  // Mark entry as most recently used
+  entries_.splice(entries_.begin(), entries_, it->second);
+  trajs = copyTrajectories(it->second->trajs);
+  ++statistics_.hits;
+  return true;
+}
+
+void SequenceCache::insert(const std::string& key,
+                           const std::vector<double>& start_positions,
+                           const TrajCont& trajs)
+{
+  if (capacity_ == 0)
+  {
+    return;
+  }
+
+  auto it {index_.find(key)};
+  if (it != index_.end())
+  {
+    entries_.erase(it->second);
+    index_.erase(it);
+  }
+
+  while (entries_.size() >= capacity_)
+  {
+    index_.erase(entries_.back().key);
+    entries_.pop_back();
+  }
+
+  entries_.push_front(Entry {key, start_positions, copyTrajectories(trajs)});
+  index_.emplace(key, entries_.begin());
+}
+
+SequenceCache::TrajCont SequenceCache::copyTrajectories(const TrajCont& trajs)
+{
+  TrajCont copies;
+  copies.reserve(trajs.size());
+  for (const robot_trajectory::RobotTrajectoryPtr& traj : trajs)
+  {
+    if (!traj)
+    {
+      copies.push_back(nullptr);
+      continue;
+    }
+
+    // The copy constructor of the trajectory shares the waypoints
+    robot_trajectory::RobotTrajectoryPtr copy {
+      std::make_shared<robot_trajectory::RobotTrajectory>(traj->getRobotModel(), traj->getGroupName())};
+    for (std::size_t i = 0; i < traj->getWayPointCount(); ++i)
+    {
+      copy->addSuffixWayPoint(std::make_shared<robot_state::RobotState>(traj->getWayPoint(i)),
+                              traj->getWayPointDurationFromPrevious(i));
+    }
+    copies.push_back(copy);
+  }
+  return copies;
+}
+
+bool SequenceCache::isWithinTolerance(const std::vector<double>& positions_A,
+                                      const std::vector<double>& positions_B) const
+{
+  if (positions_A.size() != positions_B.size())
+  {
+    return false;
+  }
+
+  for (std::size_t i = 0; i < positions_A.size(); ++i)
+  {
+    if (std::fabs(positions_A.at(i) - positions_B.at(i)) > start_position_tolerance_)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+}
@@ -20,23 +20,34 @@
 #include <algorithm>
 #include <math.h>
 
-bool pilz::TrajectoryBlenderTransitionWindow::blend(const pilz::TrajectoryBlendRequest& req,
+bool pilz::TrajectoryBlenderTransitionWindow::blend(const pilz::TrajectoryBlendRequest& original_req,
                                          pilz::TrajectoryBlendResponse& res)
 {
   ROS_INFO("Start trajectory blending using transition window.");
 
   double sampling_time = 0.;
-  if(!validateRequest(req, sampling_time, res.error_code))
+  if(!validateRequest(original_req, sampling_time, res.error_code))
   {
     ROS_ERROR("Trajectory blend request is not valid.");
     return false;
   }
 
+  // bring the trajectories onto a common sampling time inside of the blend window
+  pilz::TrajectoryBlendRequest req;
+  if(!resampleBlendWindows(original_req, sampling_time, req))
+  {
+    ROS_ERROR("Blend radius to large.");
+    res.error_code.val = moveit_msgs::MoveItErrorCodes::INVALID_MOTION_PLAN;
+    return false;
+  }
+
   // search for intersection points of the two trajectories with the blending sphere
   // intersection points belongs to blend trajectory after blending
+  // the poses of the target link inside the sphere are evaluated once during the search
+  pilz::LinkPoses first_poses, second_poses;
   std::size_t first_intersection_index;
   std::size_t second_intersection_index;
-  if(!searchIntersectionPoints(req, first_intersection_index, second_intersection_index))
+  if(!searchIntersectionPoints(req, first_poses, second_poses, first_intersection_index, second_intersection_index))
   {
     ROS_ERROR("Blend radius to large.");
     res.error_code.val = moveit_msgs::MoveItErrorCodes::INVALID_MOTION_PLAN;
@@ -50,6 +61,8 @@ bool pilz::TrajectoryBlenderTransitionWindow::blend(const pilz::TrajectoryBlendR
   // blend the trajectories in Cartesian space
   pilz::CartesianTrajectory blend_trajectory_cartesian;
   blendTrajectoryCartesian(req,
+                           first_poses,
+                           second_poses,
                            first_intersection_index,
                            second_intersection_index,
                            blend_align_index,
@@ -77,7 +90,9 @@ bool pilz::TrajectoryBlenderTransitionWindow::blend(const pilz::TrajectoryBlendR
                               initial_joint_velocity,
                               blend_joint_trajectory,
                               error_code,
-                              true))
+                              true,
+                              req.cancellation_token,
+                              req.deadline))
   {
     // LCOV_EXCL_START
     ROS_INFO("Failed to generate joint trajectory for blending trajectory.");
@@ -97,26 +112,33 @@ bool pilz::TrajectoryBlenderTransitionWindow::blend(const pilz::TrajectoryBlendR
                                                                                req.first_trajectory->getGroup()));
 
   // set the three trajectories after blending in response
+  // the retained waypoints are shared with the request trajectories instead of being copied
   // erase the points [first_intersection_index, back()] from the first trajectory
   for(size_t i = 0; i < first_intersection_index; ++i)
   {
-    res.first_trajectory->insertWayPoint(i, req.first_trajectory->getWayPoint(i),
-                                         req.first_trajectory->getWayPointDurationFromPrevious(i));
+    res.first_trajectory->addSuffixWayPoint(req.first_trajectory->getWayPointPtr(i),
+                                            req.first_trajectory->getWayPointDurationFromPrevious(i));
   }
 
   // append the blend trajectory
   res.blend_trajectory->setRobotTrajectoryMsg(req.first_trajectory->getFirstWayPoint(), blend_joint_trajectory);
-  // copy the points [second_intersection_index, len] from the second trajectory
-  for(size_t i = second_intersection_index+1; i < req.second_trajectory->getWayPointCount(); ++i)
+  // share the points after the second intersection point from the original second trajectory, so that
+  // a resampled blend window is not passed on and the remainder keeps the sampling time of the command
+  const double intersection_time {req.second_trajectory->getWayPointDurationFromStart(second_intersection_index)};
+  const robot_trajectory::RobotTrajectory& second = *original_req.second_trajectory;
+  double time {0.};
+  double previous_time {intersection_time};
+  for(size_t i = 0; i < second.getWayPointCount(); ++i)
   {
-    res.second_trajectory->insertWayPoint(i-(second_intersection_index+1),
-                                          req.second_trajectory->getWayPoint(i),
-                                          req.second_trajectory->getWayPointDurationFromPrevious(i));
+    time += second.getWayPointDurationFromPrevious(i);
+    if(time > intersection_time + epsilon)
+    {
+      // the first duration is the time from the end of the blend trajectory
+      res.second_trajectory->addSuffixWayPoint(second.getWayPointPtr(i), time - previous_time);
+      previous_time = time;
+    }
   }
 
-  // adjust the time from start
-  res.second_trajectory->setWayPointDurationFromPrevious(0, sampling_time);
-
   res.error_code.val = moveit_msgs::MoveItErrorCodes::SUCCESS;
   return true;
 }
@@ -164,17 +186,36 @@ bool pilz::TrajectoryBlenderTransitionWindow::validateRequest(const pilz::Trajec
     return false;
   }
 
-  // same uniform sampling time
-  if (!pilz::determineAndCheckSamplingTime(req.first_trajectory,
-                                           req.second_trajectory,
-                                           epsilon,
-                                           sampling_time))
+  // uniform sampling time of each trajectory, the blending uses the finer one
+  double first_sampling_time {0.};
+  double second_sampling_time {0.};
+  if (!pilz::determineSamplingTime(req.first_trajectory, epsilon, first_sampling_time) ||
+      !pilz::determineSamplingTime(req.second_trajectory, epsilon, second_sampling_time))
   {
+    error_code.val = moveit_msgs::MoveItErrorCodes::INVALID_MOTION_PLAN;
+    return false;
+  }
 
+  if (first_sampling_time <= 0. && second_sampling_time <= 0.)
+  {
+    ROS_ERROR_STREAM("Both trajectories do not have enough points to determine sampling time.");
     error_code.val = moveit_msgs::MoveItErrorCodes::INVALID_MOTION_PLAN;
     return false;
   }
 
+  if (first_sampling_time <= 0.)
+  {
+    sampling_time = second_sampling_time;
+  }
+  else if (second_sampling_time <= 0.)
+  {
+    sampling_time = first_sampling_time;
+  }
+  else
+  {
+    sampling_time = std::min(first_sampling_time, second_sampling_time);
+  }
+
   //end position of the first trajectory and start position of second trajectory must have zero velocities/accelerations
   if(!pilz::isRobotStateStationary(req.first_trajectory->getLastWayPoint(), req.group_name, epsilon) ||
      !pilz::isRobotStateStationary(req.second_trajectory->getFirstWayPoint(), req.group_name, epsilon) )
@@ -187,7 +228,102 @@ bool pilz::TrajectoryBlenderTransitionWindow::validateRequest(const pilz::Trajec
   return true;
 }
 
+bool pilz::TrajectoryBlenderTransitionWindow::resampleBlendWindows(const pilz::TrajectoryBlendRequest &req,
+                                                                   double sampling_time,
+                                                                   pilz::TrajectoryBlendRequest &resampled_req) const
+{
+  resampled_req = req;
+
+  const robot_trajectory::RobotTrajectory& first = *req.first_trajectory;
+  const robot_trajectory::RobotTrajectory& second = *req.second_trajectory;
+  Eigen::Vector3d circ_center = blendSphereCenter(req);
+
+  pilz::LinkPoses poses;
+  std::size_t interse_index;
+  std::vector<double> times;
+  std::vector<robot_state::RobotStatePtr> states;
+
+  // resample the first trajectory from the last waypoint outside of the blend sphere to the end
+  if(first.getWayPointCount() > 2 && first.getWayPointDurationFromPrevious(1) - sampling_time > epsilon)
+  {
+    if(!searchIntersectionPoint(first, req.link_name, circ_center, req.blend_radius, true, poses, interse_index))
+    {
+      return false;
+    }
+
+    std::size_t window_begin = interse_index - 1;
+    double begin_time = first.getWayPointDurationFromStart(window_begin);
+    double end_time = first.getWayPointDurationFromStart(first.getWayPointCount()-1);
+
+    times.clear();
+    for(std::size_t i = 1; begin_time + i*sampling_time < end_time - epsilon; ++i)
+    {
+      times.push_back(begin_time + i*sampling_time);
+    }
+    times.push_back(end_time);
+    sampleTrajectory(first, req.group_name, times, states);
+
+    resampled_req.first_trajectory = std::make_shared<robot_trajectory::RobotTrajectory>(first.getRobotModel(),
+                                                                                        first.getGroup());
+    for(std::size_t i = 0; i <= window_begin; ++i)
+    {
+      resampled_req.first_trajectory->addSuffixWayPoint(req.first_trajectory->getWayPointPtr(i),
+                                                        first.getWayPointDurationFromPrevious(i));
+    }
+    double previous_time = begin_time;
+    for(std::size_t i = 0; i < times.size(); ++i)
+    {
+      resampled_req.first_trajectory->addSuffixWayPoint(states[i], times[i] - previous_time);
+      previous_time = times[i];
+    }
+    ROS_DEBUG_STREAM("Resampled " << first.getWayPointCount() - window_begin - 1
+                     << " waypoints of the first trajectory to " << times.size() << " waypoints.");
+  }
+
+  // resample the second trajectory from its start to the waypoint after the first waypoint outside of the
+  // blend sphere, so that the intersection point and its successor lie on the sampling time as well
+  if(second.getWayPointCount() > 2 && second.getWayPointDurationFromPrevious(1) - sampling_time > epsilon)
+  {
+    if(!searchIntersectionPoint(second, req.link_name, circ_center, req.blend_radius, false, poses, interse_index))
+    {
+      return false;
+    }
+
+    std::size_t window_end = std::min(interse_index + 1, second.getWayPointCount() - 1);
+    double begin_time = second.getWayPointDurationFromPrevious(0);
+    double end_time = second.getWayPointDurationFromStart(window_end);
+
+    times.clear();
+    for(std::size_t i = 0; begin_time + i*sampling_time < end_time - epsilon; ++i)
+    {
+      times.push_back(begin_time + i*sampling_time);
+    }
+    times.push_back(end_time);
+    sampleTrajectory(second, req.group_name, times, states);
+
+    resampled_req.second_trajectory = std::make_shared<robot_trajectory::RobotTrajectory>(second.getRobotModel(),
+                                                                                         second.getGroup());
+    double previous_time = 0.;
+    for(std::size_t i = 0; i < times.size(); ++i)
+    {
+      resampled_req.second_trajectory->addSuffixWayPoint(states[i], times[i] - previous_time);
+      previous_time = times[i];
+    }
+    for(std::size_t i = window_end + 1; i < second.getWayPointCount(); ++i)
+    {
+      resampled_req.second_trajectory->addSuffixWayPoint(req.second_trajectory->getWayPointPtr(i),
+                                                         second.getWayPointDurationFromPrevious(i));
+    }
+    ROS_DEBUG_STREAM("Resampled " << window_end + 1 << " waypoints of the second trajectory to "
+                     << times.size() << " waypoints.");
+  }
+
+  return true;
+}
+
 void pilz::TrajectoryBlenderTransitionWindow::blendTrajectoryCartesian(const pilz::TrajectoryBlendRequest &req,
+                                                            const pilz::LinkPoses& first_poses,
+                                                            const pilz::LinkPoses& second_poses,
                                                             const std::size_t first_interse_index,
                                                             const std::size_t second_interse_index,
                                                             const std::size_t blend_align_index,
@@ -199,58 +335,62 @@ void pilz::TrajectoryBlenderTransitionWindow::blendTrajectoryCartesian(const pil
   trajectory.link_name = req.link_name;
 
   // Pose on first trajectory
-  Eigen::Isometry3d blend_sample_pose1
-      = req.first_trajectory->getWayPoint(first_interse_index).getFrameTransform(req.link_name);
+  std::size_t first_index = first_interse_index;
 
   // Pose on second trajectory
-  Eigen::Isometry3d blend_sample_pose2
-      = req.second_trajectory->getWayPoint(second_interse_index).getFrameTransform(req.link_name);
+  std::size_t second_index = 0;
 
   // blend the trajectory
   double blend_sample_num = second_interse_index + blend_align_index - first_interse_index +1 ;
+  trajectory.points.reserve(trajectory.points.size() + static_cast<std::size_t>(blend_sample_num));
   pilz::CartesianTrajectoryPoint waypoint;
-  geometry_msgs::Pose waypoint_pose;
-  blend_sample_pose2 = req.second_trajectory->getFirstWayPoint().getFrameTransform(req.link_name);
 
   // Pose on blending trajectory
-  Eigen::Isometry3d  blend_sample_pose;
+  Eigen::Isometry3d blend_sample_pose {Eigen::Isometry3d::Identity()};
   for(std::size_t i = 0; i < blend_sample_num; ++i)
   {
     // if the first trajectory does not reach the last sample, update
-    if((first_interse_index+i) < req.first_trajectory->getWayPointCount())
+    if((first_interse_index+i) < first_poses.translations.size())
     {
-      blend_sample_pose1 = req.first_trajectory->getWayPoint(first_interse_index+i).getFrameTransform(req.link_name);
+      first_index = first_interse_index+i;
     }
 
     // if after the alignment, the second trajectory starts, update
     if((first_interse_index+i) > blend_align_index)
     {
-      blend_sample_pose2
-         = req.second_trajectory->getWayPoint(first_interse_index+i-blend_align_index).getFrameTransform(req.link_name);
+      second_index = first_interse_index+i-blend_align_index;
     }
 
     double s = (i+1)/blend_sample_num;
     double alpha = 6*std::pow(s,5) - 15*std::pow(s,4) + 10*std::pow(s,3);
 
     // blend the translation
-    blend_sample_pose.translation() = blend_sample_pose1.translation()
-        + alpha*(blend_sample_pose2.translation() - blend_sample_pose1.translation());
+    const Eigen::Vector3d& translation1 = first_poses.translations[first_index];
+    const Eigen::Vector3d& translation2 = second_poses.translations[second_index];
+    blend_sample_pose.translation() = translation1 + alpha*(translation2 - translation1);
 
     // blend the orientation
-    Eigen::Quaterniond start_quat(blend_sample_pose1.rotation());
-    Eigen::Quaterniond end_quat(blend_sample_pose2.rotation());
-    blend_sample_pose.linear() = start_quat.slerp(alpha, end_quat).toRotationMatrix();
+    blend_sample_pose.linear() = first_poses.orientations[first_index].slerp(
+          alpha, second_poses.orientations[second_index]).toRotationMatrix();
 
     // push to the trajectory
-    tf::poseEigenToMsg(blend_sample_pose, waypoint_pose);
-    waypoint.pose = waypoint_pose;
+    tf::poseEigenToMsg(blend_sample_pose, waypoint.pose);
     waypoint.time_from_start = ros::Duration((i+1.0)*sampling_time);
     trajectory.points.push_back(waypoint);
 
   }
 }
 
+Eigen::Vector3d pilz::TrajectoryBlenderTransitionWindow::blendSphereCenter(const pilz::TrajectoryBlendRequest &req) const
+{
+  robot_state::RobotState last_waypoint {req.first_trajectory->getLastWayPoint()};
+  last_waypoint.update();
+  return last_waypoint.getFrameTransform(req.link_name).translation();
+}
+
 bool pilz::TrajectoryBlenderTransitionWindow::searchIntersectionPoints(const pilz::TrajectoryBlendRequest &req,
+                                                            pilz::LinkPoses& first_poses,
+                                                            pilz::LinkPoses& second_poses,
                                                             std::size_t &first_interse_index,
                                                             std::size_t &second_interse_index) const
 {
@@ -258,19 +398,19 @@ bool pilz::TrajectoryBlenderTransitionWindow::searchIntersectionPoints(const pil
 
   // compute the position of the center of the blend sphere
   // (last point of the first trajectory, first point of the second trajectory)
-  Eigen::Isometry3d circ_pose = req.first_trajectory->getLastWayPoint().getFrameTransform(req.link_name);
+  Eigen::Vector3d circ_center = blendSphereCenter(req);
 
   // Searh for intersection points according to distance
-  if(!linearSearchIntersectionPoint(req.link_name, circ_pose.translation(), req.blend_radius,
-                                    req.first_trajectory, true, first_interse_index))
+  if(!searchIntersectionPoint(*req.first_trajectory, req.link_name, circ_center, req.blend_radius,
+                              true, first_poses, first_interse_index))
   {
     ROS_ERROR_STREAM("Intersection point of first trajectory not found.");
     return false;
   }
   ROS_INFO_STREAM("Intersection point of first trajectory found, index: " << first_interse_index);
 
-  if(!linearSearchIntersectionPoint(req.link_name, circ_pose.translation(), req.blend_radius,
-                                    req.second_trajectory, false, second_interse_index))
+  if(!searchIntersectionPoint(*req.second_trajectory, req.link_name, circ_center, req.blend_radius,
+                              false, second_poses, second_interse_index))
   {
     ROS_ERROR_STREAM("Intersection point of second trajectory not found.");
     return false;
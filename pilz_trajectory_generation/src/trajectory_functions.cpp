@@ -17,8 +17,35 @@
 
 #include "pilz_trajectory_generation/trajectory_functions.h"
 
+#include <algorithm>
+
 #include <moveit/planning_scene/planning_scene.h>
 
+//! Timeout of each IK call if no deadline is given (same as the default of computePoseIK()).
+static constexpr double DEFAULT_IK_TIMEOUT {0.1};
+
+/**
+ * @brief Distributes the time left until the deadline evenly over the remaining IK calls.
+ * @param timeout: timeout of the next IK call
+ * @return false if the deadline is exceeded
+ */
+static bool determineIKTimeout(const ros::Time& deadline, const std::size_t num_remaining_calls, double& timeout)
+{
+  timeout = DEFAULT_IK_TIMEOUT;
+  if(deadline.isZero())
+  {
+    return true;
+  }
+
+  const double remaining_time {(deadline - ros::Time::now()).toSec()};
+  if(remaining_time <= 0.)
+  {
+    return false;
+  }
+  timeout = std::min(timeout, remaining_time / static_cast<double>(num_remaining_calls));
+  return true;
+}
+
 bool pilz::computePoseIK(const moveit::core::RobotModelConstPtr &robot_model,
                          const std::string &group_name,
                          const std::string &link_name,
@@ -103,6 +130,30 @@ bool pilz::computePoseIK(const moveit::core::RobotModelConstPtr &robot_model,
                        timeout);
 }
 
+bool pilz::computePTPGoalIK(const moveit::core::RobotModelConstPtr &robot_model,
+                            const std::string &group_name,
+                            const moveit_msgs::Constraints &goal,
+                            const std::map<std::string, double> &seed,
+                            std::map<std::string, double> &solution)
+{
+  const moveit_msgs::PositionConstraint& position_constraint {goal.position_constraints.at(0)};
+  geometry_msgs::Pose pose;
+  pose.position = position_constraint.constraint_region.primitive_poses.at(0).position;
+  pose.position.x -= position_constraint.target_point_offset.x;
+  pose.position.y -= position_constraint.target_point_offset.y;
+  pose.position.z -= position_constraint.target_point_offset.z;
+  pose.orientation = goal.orientation_constraints.at(0).orientation;
+  normalizeQuaternion(pose.orientation);
+
+  return computePoseIK(robot_model,
+                       group_name,
+                       position_constraint.link_name,
+                       pose,
+                       robot_model->getModelFrame(),
+                       seed,
+                       solution);
+}
+
 bool pilz::computeLinkFK(const moveit::core::RobotModelConstPtr &robot_model,
                          const std::string &link_name,
                          const std::map<std::string, double> &joint_state,
@@ -135,88 +186,61 @@ bool pilz::verifySampleJointLimits(const std::map<std::string, double> &position
                                    double duration_current,
                                    const pilz::JointLimitsContainer& joint_limits)
 {
-  const double epsilon = 10e-6;
-  if(duration_current <= epsilon)
+  std::string joint_name;
+  double value {0.};
+  switch(pilz::checkSampleJointLimits(position_last, velocity_last, position_current, duration_last, duration_current,
+                                      joint_limits, joint_name, value))
   {
+  case JointLimitViolation::NONE:
+    return true;
+  case JointLimitViolation::SAMPLE_DURATION_TOO_SMALL:
     ROS_ERROR("Sample duration too small, cannot compute the velocity");
     return false;
+  case JointLimitViolation::VELOCITY:
+    ROS_ERROR_STREAM("Joint velocity limit of " << joint_name << " violated. Set the velocity scaling factor lower!"
+                     << " Actual joint velocity is " << value
+                     << ", while the limit is " << joint_limits.getLimit(joint_name).max_velocity
+                     << ". ");
+    return false;
+  case JointLimitViolation::ACCELERATION:
+    ROS_ERROR_STREAM("Joint acceleration limit of " << joint_name
+                     << " violated. Set the acceleration scaling factor lower!"
+                     << " Actual joint acceleration is " << value
+                     << ", while the limit is " << joint_limits.getLimit(joint_name).max_acceleration
+                     << ". ");
+    return false;
+  case JointLimitViolation::DECELERATION:
+    ROS_ERROR_STREAM("Joint deceleration limit of " << joint_name
+                     << " violated. Set the acceleration scaling factor lower!"
+                     << " Actual joint deceleration is " << value
+                     << ", while the limit is " << joint_limits.getLimit(joint_name).max_deceleration
+                     << ". ");
+    return false;
   }
-
-  double velocity_current, acceleration_current;
-
-  for(auto pos : position_current)
-  {
-    velocity_current = (pos.second - position_last.at(pos.first))/duration_current;
-
-    if(!joint_limits.verifyVelocityLimit(pos.first, velocity_current))
-    {
-      ROS_ERROR_STREAM("Joint velocity limit of " << pos.first << " violated. Set the velocity scaling factor lower!"
-                       << " Actual joint velocity is " << velocity_current
-                       << ", while the limit is " << joint_limits.getLimit(pos.first).max_velocity
-                       << ". ");
-      return false;
-    }
-
-    acceleration_current = (velocity_current - velocity_last.at(pos.first))/(duration_last + duration_current)*2;
-    // acceleration case
-    if(fabs(velocity_last.at(pos.first))<=fabs(velocity_current))
-    {
-      if(joint_limits.getLimit(pos.first).has_acceleration_limits &&
-         fabs(acceleration_current)>fabs(joint_limits.getLimit(pos.first).max_acceleration))
-      {
-        ROS_ERROR_STREAM("Joint acceleration limit of " << pos.first
-                         << " violated. Set the acceleration scaling factor lower!"
-                         << " Actual joint acceleration is " << acceleration_current
-                         << ", while the limit is " << joint_limits.getLimit(pos.first).max_acceleration
-                         << ". ");
-        return false;
-      }
-    }
-    // deceleration case
-    else
-    {
-      if(joint_limits.getLimit(pos.first).has_deceleration_limits &&
-         fabs(acceleration_current)>fabs(joint_limits.getLimit(pos.first).max_deceleration))
-      {
-        ROS_ERROR_STREAM("Joint deceleration limit of " << pos.first
-                         << " violated. Set the acceleration scaling factor lower!"
-                         << " Actual joint deceleration is " << acceleration_current
-                         << ", while the limit is " << joint_limits.getLimit(pos.first).max_deceleration
-                         << ". ");
-        return false;
-      }
-    }
-  }
-
-  return true;
+  return false; // LCOV_EXCL_LINE
 }
 
-bool pilz::generateJointTrajectory(const moveit::core::RobotModelConstPtr &robot_model,
-                                   const pilz::JointLimitsContainer& joint_limits,
-                                   const KDL::Trajectory &trajectory,
-                                   const std::string &group_name,
-                                   const std::string &link_name,
-                                   const std::map<std::string, double> &initial_joint_position,
-                                   const double &sampling_time,
-                                   trajectory_msgs::JointTrajectory &joint_trajectory,
-                                   moveit_msgs::MoveItErrorCodes &error_code,
-                                   bool check_self_collision)
+/**
+ * @brief Computes the joint trajectory from the Cartesian poses at the given time samples
+ * (see pilz::generateJointTrajectory()).
+ */
+static bool generateJointTrajectoryFromPoses(const moveit::core::RobotModelConstPtr &robot_model,
+                                             const pilz::JointLimitsContainer& joint_limits,
+                                             const std::vector<double>& time_samples,
+                                             const pilz::PoseBuffer& poses,
+                                             const std::string &group_name,
+                                             const std::string &link_name,
+                                             const std::map<std::string, double> &initial_joint_position,
+                                             const double &sampling_time,
+                                             trajectory_msgs::JointTrajectory &joint_trajectory,
+                                             moveit_msgs::MoveItErrorCodes &error_code,
+                                             bool check_self_collision,
+                                             const pilz::CancellationToken* cancellation_token,
+                                             const ros::Time& deadline)
 {
-  ROS_DEBUG("Generate joint trajectory from a Cartesian trajectory.");
-
   ros::Time generation_begin = ros::Time::now();
 
-  // generate the time samples
-  const double epsilon = 10e-06; // avoid adding the last time sample twice
-  std::vector<double> time_samples;
-  for(double t_sample=0.0; t_sample < trajectory.Duration() - epsilon; t_sample+=sampling_time)
-  {
-    time_samples.push_back(t_sample);
-  }
-  time_samples.push_back(trajectory.Duration());
-
-  // sample the trajectory and solve the inverse kinematics
-  Eigen::Isometry3d pose_sample;
+  // solve the inverse kinematics for the sampled poses
   std::map<std::string, double> ik_solution_last, ik_solution, joint_velocity_last;
   ik_solution_last = initial_joint_position;
   for(const auto& item: ik_solution_last)
@@ -226,16 +250,32 @@ bool pilz::generateJointTrajectory(const moveit::core::RobotModelConstPtr &robot
 
   for(std::vector<double>::const_iterator time_iter=time_samples.begin();  time_iter!=time_samples.end(); ++time_iter )
   {
-    tf::transformKDLToEigen(trajectory.Pos(*time_iter), pose_sample);
+    if(pilz::isCancelled(cancellation_token))
+    {
+      ROS_INFO("Generation of joint trajectory cancelled.");
+      error_code.val = moveit_msgs::MoveItErrorCodes::PREEMPTED;
+      joint_trajectory.points.clear();
+      return false;
+    }
 
-    if(!computePoseIK(robot_model,
-                      group_name,
-                      link_name,
-                      pose_sample,
-                      robot_model->getModelFrame(),
-                      ik_solution_last,
-                      ik_solution,
-                      check_self_collision))
+    double ik_timeout {DEFAULT_IK_TIMEOUT};
+    if(!determineIKTimeout(deadline, static_cast<std::size_t>(time_samples.end() - time_iter), ik_timeout))
+    {
+      ROS_ERROR("Deadline exceeded while generating the joint trajectory.");
+      error_code.val = moveit_msgs::MoveItErrorCodes::TIMED_OUT;
+      joint_trajectory.points.clear();
+      return false;
+    }
+
+    if(!pilz::computePoseIK(robot_model,
+                            group_name,
+                            link_name,
+                            poses[static_cast<std::size_t>(time_iter - time_samples.begin())],
+                            robot_model->getModelFrame(),
+                            ik_solution_last,
+                            ik_solution,
+                            check_self_collision,
+                            ik_timeout))
     {
       ROS_ERROR("Failed to compute inverse kinematics solution for sampled Cartesian pose.");
       error_code.val = moveit_msgs::MoveItErrorCodes::NO_IK_SOLUTION;
@@ -256,12 +296,12 @@ bool pilz::generateJointTrajectory(const moveit::core::RobotModelConstPtr &robot
     }
 
     // skip the first sample with zero time from start for limits checking
-    if(time_iter!=time_samples.begin() && !verifySampleJointLimits(ik_solution_last,
-                                                                   joint_velocity_last,
-                                                                   ik_solution,
-                                                                   sampling_time,
-                                                                   duration_current_sample,
-                                                                   joint_limits))
+    if(time_iter!=time_samples.begin() && !pilz::verifySampleJointLimits(ik_solution_last,
+                                                                         joint_velocity_last,
+                                                                         ik_solution,
+                                                                         sampling_time,
+                                                                         duration_current_sample,
+                                                                         joint_limits))
     {
       ROS_ERROR_STREAM("Inverse kinematics solution at " << *time_iter
                        << "s violates the joint velocity/acceleration/deceleration limits.");
@@ -315,6 +355,58 @@ bool pilz::generateJointTrajectory(const moveit::core::RobotModelConstPtr &robot
   return true;
 }
 
+bool pilz::generateJointTrajectory(const moveit::core::RobotModelConstPtr &robot_model,
+                                   const pilz::JointLimitsContainer& joint_limits,
+                                   const KDL::Trajectory &trajectory,
+                                   const std::string &group_name,
+                                   const std::string &link_name,
+                                   const std::map<std::string, double> &initial_joint_position,
+                                   const double &sampling_time,
+                                   trajectory_msgs::JointTrajectory &joint_trajectory,
+                                   moveit_msgs::MoveItErrorCodes &error_code,
+                                   bool check_self_collision,
+                                   const pilz::CancellationToken* cancellation_token,
+                                   const ros::Time& deadline)
+{
+  ROS_DEBUG("Generate joint trajectory from a Cartesian trajectory.");
+
+  const std::vector<double> time_samples {pilz::sampleTimes(trajectory.Duration(), sampling_time)};
+  PoseBuffer poses(time_samples.size());
+  for(std::size_t i = 0; i < time_samples.size(); ++i)
+  {
+    tf::transformKDLToEigen(trajectory.Pos(time_samples[i]), poses[i]);
+  }
+
+  return generateJointTrajectoryFromPoses(robot_model, joint_limits, time_samples, poses, group_name, link_name,
+                                          initial_joint_position, sampling_time, joint_trajectory, error_code,
+                                          check_self_collision, cancellation_token, deadline);
+}
+
+bool pilz::generateJointTrajectory(const moveit::core::RobotModelConstPtr &robot_model,
+                                   const pilz::JointLimitsContainer& joint_limits,
+                                   const pilz::CartesianPath &path,
+                                   const KDL::VelocityProfile &velocity_profile,
+                                   const std::string &group_name,
+                                   const std::string &link_name,
+                                   const std::map<std::string, double> &initial_joint_position,
+                                   const double &sampling_time,
+                                   trajectory_msgs::JointTrajectory &joint_trajectory,
+                                   moveit_msgs::MoveItErrorCodes &error_code,
+                                   bool check_self_collision,
+                                   const pilz::CancellationToken* cancellation_token,
+                                   const ros::Time& deadline)
+{
+  ROS_DEBUG("Generate joint trajectory from a Cartesian path.");
+
+  CartesianSamples samples;
+  sampleCartesianTrajectory(path, velocity_profile, sampling_time, samples);
+
+  return generateJointTrajectoryFromPoses(robot_model, joint_limits, samples.time_samples, samples.poses,
+                                          group_name, link_name,
+                                          initial_joint_position, sampling_time, joint_trajectory, error_code,
+                                          check_self_collision, cancellation_token, deadline);
+}
+
 bool pilz::generateJointTrajectory(const moveit::core::RobotModelConstPtr &robot_model,
                                    const pilz::JointLimitsContainer &joint_limits,
                                    const pilz::CartesianTrajectory &trajectory,
@@ -324,7 +416,9 @@ bool pilz::generateJointTrajectory(const moveit::core::RobotModelConstPtr &robot
                                    const std::map<std::string, double> &initial_joint_velocity,
                                    trajectory_msgs::JointTrajectory &joint_trajectory,
                                    moveit_msgs::MoveItErrorCodes &error_code,
-                                   bool check_self_collision)
+                                   bool check_self_collision,
+                                   const pilz::CancellationToken* cancellation_token,
+                                   const ros::Time& deadline)
 {
   ROS_DEBUG("Generate joint trajectory from a Cartesian trajectory.");
 
@@ -342,6 +436,23 @@ bool pilz::generateJointTrajectory(const moveit::core::RobotModelConstPtr &robot
   std::map<std::string, double> ik_solution;
   for(size_t i=0; i<trajectory.points.size(); ++i)
   {
+    if(pilz::isCancelled(cancellation_token))
+    {
+      ROS_INFO("Generation of joint trajectory cancelled.");
+      error_code.val = moveit_msgs::MoveItErrorCodes::PREEMPTED;
+      joint_trajectory.points.clear();
+      return false;
+    }
+
+    double ik_timeout {DEFAULT_IK_TIMEOUT};
+    if(!determineIKTimeout(deadline, trajectory.points.size() - i, ik_timeout))
+    {
+      ROS_ERROR("Deadline exceeded while generating the joint trajectory.");
+      error_code.val = moveit_msgs::MoveItErrorCodes::TIMED_OUT;
+      joint_trajectory.points.clear();
+      return false;
+    }
+
     // compute inverse kinematics
     if(!computePoseIK(robot_model,
                       group_name,
@@ -350,7 +461,8 @@ bool pilz::generateJointTrajectory(const moveit::core::RobotModelConstPtr &robot
                       robot_model->getModelFrame(),
                       ik_solution_last,
                       ik_solution,
-                      check_self_collision))
+                      check_self_collision,
+                      ik_timeout))
     {
       ROS_ERROR("Failed to compute inverse kinematics solution for sampled Cartesian pose.");
       error_code.val = moveit_msgs::MoveItErrorCodes::NO_IK_SOLUTION;
@@ -417,55 +529,118 @@ bool pilz::generateJointTrajectory(const moveit::core::RobotModelConstPtr &robot
   return true;
 }
 
-
-bool pilz::determineAndCheckSamplingTime(const robot_trajectory::RobotTrajectoryPtr& first_trajectory,
-                                         const robot_trajectory::RobotTrajectoryPtr& second_trajectory,
-                                         double epsilon,
-                                         double& sampling_time)
+bool pilz::determineSamplingTime(const robot_trajectory::RobotTrajectoryPtr& trajectory,
+                                 double epsilon,
+                                 double& sampling_time)
 {
   // The last sample is ignored because it is allowed to violate the sampling time.
-  std::size_t n1 = first_trajectory->getWayPointCount() - 1;
-  std::size_t n2 = second_trajectory->getWayPointCount() - 1;
-  if ( (n1 < 2) && (n2 < 2) )
+  std::size_t n = trajectory->getWayPointCount() - 1;
+  if (n < 2)
   {
-    ROS_ERROR_STREAM("Both trajectories do not have enough points to determine sampling time.");
-    return false;
+    sampling_time = 0.;
+    return true;
   }
 
-  if (n1 >= 2)
-  {
-    sampling_time = first_trajectory->getWayPointDurationFromPrevious(1);
-  }
-  else
+  sampling_time = trajectory->getWayPointDurationFromPrevious(1);
+  for(std::size_t i = 2; i < n; ++i)
   {
-    sampling_time = second_trajectory->getWayPointDurationFromPrevious(1);
+    if ( fabs(sampling_time - trajectory->getWayPointDurationFromPrevious(i)) > epsilon )
+    {
+      ROS_ERROR_STREAM("Trajectory violates sampline time " << sampling_time << " between points "
+                       << (i-1) << "and " << i << " (indices).");
+      return false;
+    }
   }
 
-  for(std::size_t i = 1; i < std::max(n1, n2); ++i)
+  return true;
+}
+
+/**
+ * @brief Sets the joint positions, velocities and accelerations of the planning group to the quintic Hermite
+ * interpolation between the specified waypoints, which matches the positions, velocities and accelerations of both.
+ * @param duration Time between the two waypoints.
+ * @param s Normalized time [0, 1] between the two waypoints.
+ */
+static void interpolateQuinticHermite(const robot_state::RobotState& before,
+                                      const robot_state::RobotState& after,
+                                      const std::string& group_name,
+                                      const double duration,
+                                      const double s,
+                                      robot_state::RobotState& state)
+{
+  Eigen::VectorXd p0, v0, a0, p1, v1, a1;
+  before.copyJointGroupPositions(group_name, p0);
+  before.copyJointGroupVelocities(group_name, v0);
+  before.copyJointGroupAccelerations(group_name, a0);
+  after.copyJointGroupPositions(group_name, p1);
+  after.copyJointGroupVelocities(group_name, v1);
+  after.copyJointGroupAccelerations(group_name, a1);
+
+  const double s2 {s*s};
+  const double s3 {s2*s};
+  const double s4 {s3*s};
+  const double s5 {s4*s};
+  const double h {duration};
+
+  // basis functions of the positions and their derivatives with respect to s
+  const double h_p0 {1. - 10.*s3 + 15.*s4 - 6.*s5};
+  const double h_v0 {s - 6.*s3 + 8.*s4 - 3.*s5};
+  const double h_a0 {0.5*s2 - 1.5*s3 + 1.5*s4 - 0.5*s5};
+  const double h_a1 {0.5*s3 - s4 + 0.5*s5};
+  const double h_v1 {-4.*s3 + 7.*s4 - 3.*s5};
+  const double h_p1 {10.*s3 - 15.*s4 + 6.*s5};
+
+  const double dh_p0 {-30.*s2 + 60.*s3 - 30.*s4};
+  const double dh_v0 {1. - 18.*s2 + 32.*s3 - 15.*s4};
+  const double dh_a0 {s - 4.5*s2 + 6.*s3 - 2.5*s4};
+  const double dh_a1 {1.5*s2 - 4.*s3 + 2.5*s4};
+  const double dh_v1 {-12.*s2 + 28.*s3 - 15.*s4};
+
+  const double ddh_p0 {-60.*s + 180.*s2 - 120.*s3};
+  const double ddh_v0 {-36.*s + 96.*s2 - 60.*s3};
+  const double ddh_a0 {1. - 9.*s + 18.*s2 - 10.*s3};
+  const double ddh_a1 {3.*s - 12.*s2 + 10.*s3};
+  const double ddh_v1 {-24.*s + 84.*s2 - 60.*s3};
+
+  // the basis functions of p0 and p1 sum up to one, therefore their derivatives are opposite
+  state.setJointGroupPositions(group_name, h_p0*p0 + h_p1*p1 + h*(h_v0*v0 + h_v1*v1) + h*h*(h_a0*a0 + h_a1*a1));
+  state.setJointGroupVelocities(group_name, dh_p0*(p0 - p1)/h + dh_v0*v0 + dh_v1*v1 + h*(dh_a0*a0 + dh_a1*a1));
+  state.setJointGroupAccelerations(group_name, ddh_p0*(p0 - p1)/(h*h) + (ddh_v0*v0 + ddh_v1*v1)/h
+                                   + ddh_a0*a0 + ddh_a1*a1);
+}
+
+void pilz::sampleTrajectory(const robot_trajectory::RobotTrajectory& traj,
+                            const std::string& group_name,
+                            const std::vector<double>& times,
+                            std::vector<robot_state::RobotStatePtr>& states)
+{
+  states.clear();
+  states.reserve(times.size());
+
+  // index of the first waypoint which is not earlier than the current sample time
+  std::size_t index {0};
+  double time_before {traj.getWayPointDurationFromPrevious(0)};
+  double time_after {time_before};
+
+  for(const double& time : times)
   {
-    if (i < n1)
+    while( (index+1 < traj.getWayPointCount()) && (time_after < time) )
     {
-      if ( fabs(sampling_time - first_trajectory->getWayPointDurationFromPrevious(i)) > epsilon )
-      {
-        ROS_ERROR_STREAM("First trajectory violates sampline time " << sampling_time
-                         << " between points "
-                         << (i-1) << "and " << i << " (indices).");
-        return false;
-      }
+      ++index;
+      time_before = time_after;
+      time_after += traj.getWayPointDurationFromPrevious(index);
     }
 
-    if (i < n2)
+    robot_state::RobotStatePtr state = std::make_shared<robot_state::RobotState>(traj.getWayPoint(index));
+    if( (index > 0) && (time < time_after) )
     {
-      if ( fabs(sampling_time - second_trajectory->getWayPointDurationFromPrevious(i)) > epsilon )
-      {
-        ROS_ERROR_STREAM("Second trajectory violates sampline time " << sampling_time << " between points "
-                         << (i-1) << "and " << i << " (indices).");
-        return false;
-      }
+      const double duration {time_after - time_before};
+      interpolateQuinticHermite(traj.getWayPoint(index-1), traj.getWayPoint(index), group_name, duration,
+                                (time - time_before)/duration, *state);
+      state->update();
     }
+    states.push_back(state);
   }
-
-  return true;
 }
 
 bool pilz::isRobotStateEqual(const moveit::core::RobotState &state1,
@@ -532,43 +707,52 @@ bool pilz::isRobotStateStationary(const moveit::core::RobotState &state,
   return true;
 }
 
-bool pilz::linearSearchIntersectionPoint(const std::string &link_name,
-                                         const Eigen::Vector3d &center_position,
-                                         const double &r,
-                                         const robot_trajectory::RobotTrajectoryPtr &traj,
-                                         bool inverseOrder,
-                                         std::size_t &index)
+bool pilz::searchIntersectionPoint(const robot_trajectory::RobotTrajectory &traj,
+                                   const std::string &link_name,
+                                   const Eigen::Vector3d &center_position,
+                                   const double &r,
+                                   bool inverseOrder,
+                                   pilz::LinkPoses &poses,
+                                   std::size_t &index)
 {
   ROS_DEBUG("Start linear search for intersection point.");
 
-  const size_t waypoint_num = traj->getWayPointCount();
-
-  if(inverseOrder)
+  const size_t waypoint_num = traj.getWayPointCount();
+  poses.translations.resize(waypoint_num);
+  poses.orientations.resize(waypoint_num);
+  if(waypoint_num < 2)
   {
-    for(size_t i = waypoint_num-1; i>0; --i)
-    {
-      if(intersectionFound(center_position,
-                           traj->getWayPointPtr(i)->getFrameTransform(link_name).translation(),
-                           traj->getWayPointPtr(i-1)->getFrameTransform(link_name).translation(),
-                           r))
-      {
-        index = i;
-        return true;
-      }
-    }
+    return false;
   }
-  else
+
+  // The search starts at the sphere center and walks outwards, therefore only the
+  // waypoints inside of the sphere (plus the first one outside) are evaluated.
+  auto waypoint_index = [waypoint_num, inverseOrder](size_t step)
   {
-    for(size_t i = 0; i < waypoint_num-1; ++i)
+    return inverseOrder ? waypoint_num-1-step : step;
+  };
+  // The waypoints might be shared with trajectories which are blended concurrently and their transforms
+  // might not be up to date, therefore the poses are computed on a separate state.
+  robot_state::RobotState state {traj.getWayPoint(0)};
+  auto evaluate_pose = [&traj, &link_name, &poses, &state](size_t i)
+  {
+    state.setVariablePositions(traj.getWayPoint(i).getVariablePositions());
+    state.update();
+    const Eigen::Isometry3d& pose = state.getFrameTransform(link_name);
+    poses.translations[i] = pose.translation();
+    poses.orientations[i] = Eigen::Quaterniond(pose.rotation());
+  };
+
+  evaluate_pose(waypoint_index(0));
+  for(size_t step = 0; step < waypoint_num-1; ++step)
+  {
+    const size_t current = waypoint_index(step);
+    const size_t next = waypoint_index(step+1);
+    evaluate_pose(next);
+    if(intersectionFound(center_position, poses.translations[current], poses.translations[next], r))
     {
-      if(intersectionFound(center_position,
-                           traj->getWayPointPtr(i)->getFrameTransform(link_name).translation(),
-                           traj->getWayPointPtr(i+1)->getFrameTransform(link_name).translation(),
-                           r))
-      {
-        index = i;
-        return true;
-      }
+      index = current;
+      return true;
     }
   }
 
@@ -22,9 +22,9 @@
 #include <moveit/robot_state/conversions.h>
 #include <eigen_conversions/eigen_msg.h>
 #include <eigen_conversions/eigen_kdl.h>
-#include <kdl/velocityprofile_trap.hpp>
 
 #include "pilz_trajectory_generation/limits_container.h"
+#include "pilz_trajectory_generation/planning_core.h"
 
 namespace pilz
 {
@@ -241,22 +241,12 @@ void TrajectoryGenerator::setFailureResponse(const ros::Time &planning_start,
 std::unique_ptr<KDL::VelocityProfile> TrajectoryGenerator::cartesianTrapVelocityProfile(
     const double& max_velocity_scaling_factor,
     const double& max_acceleration_scaling_factor,
-    const std::unique_ptr<KDL::Path> &path) const
+    const double path_length) const
 {
-  std::unique_ptr<KDL::VelocityProfile> vp_trans(
-        new KDL::VelocityProfile_Trap(
-          max_velocity_scaling_factor*planner_limits_.getCartesianLimits().getMaxTranslationalVelocity(),
-          max_acceleration_scaling_factor*planner_limits_.getCartesianLimits().getMaxTranslationalAcceleration()));
-
-  if(path->PathLength() > std::numeric_limits<double>::epsilon()) // avoid division by zero
-  {
-    vp_trans->SetProfile(0, path->PathLength());
-  }
-  else
-  {
-    vp_trans->SetProfile(0, std::numeric_limits<double>::epsilon());
-  }
-  return vp_trans;
+  return pilz::cartesianTrapVelocityProfile(planner_limits_.getCartesianLimits(),
+                                            max_velocity_scaling_factor,
+                                            max_acceleration_scaling_factor,
+                                            path_length);
 }
 
 bool TrajectoryGenerator::generate(const planning_interface::MotionPlanRequest& req,
@@ -265,6 +255,7 @@ bool TrajectoryGenerator::generate(const planning_interface::MotionPlanRequest&
 {
   ROS_INFO_STREAM("Generating " << req.planner_id << " trajectory...");
   ros::Time planning_begin = ros::Time::now();
+  deadline_ = req.allowed_planning_time > 0. ? planning_begin + ros::Duration(req.allowed_planning_time) : ros::Time();
 
   try
   {
@@ -303,6 +294,22 @@ bool TrajectoryGenerator::generate(const planning_interface::MotionPlanRequest&
     return false;
   }
 
+  if(isCancelled(cancellation_token_))
+  {
+    ROS_INFO("Generation of trajectory cancelled.");
+    res.error_code_.val = moveit_msgs::MoveItErrorCodes::PREEMPTED;
+    setFailureResponse(planning_begin, res);
+    return false;
+  }
+
+  if(!deadline_.isZero() && ros::Time::now() >= deadline_)
+  {
+    ROS_ERROR("Allowed planning time exceeded before the trajectory is planned.");
+    res.error_code_.val = moveit_msgs::MoveItErrorCodes::TIMED_OUT;
+    setFailureResponse(planning_begin, res);
+    return false;
+  }
+
   trajectory_msgs::JointTrajectory joint_trajectory;
   try
   {
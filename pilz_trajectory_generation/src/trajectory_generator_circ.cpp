@@ -17,6 +17,7 @@
 
 #include "pilz_trajectory_generation/trajectory_generator_circ.h"
 #include "pilz_trajectory_generation/path_circle_generator.h"
+#include "pilz_trajectory_generation/planning_core.h"
 
 #include <cassert>
 #include <sstream>
@@ -24,12 +25,7 @@
 #include <ros/ros.h>
 #include <eigen_conversions/eigen_msg.h>
 #include <moveit/robot_state/conversions.h>
-#include <eigen_conversions/eigen_kdl.h>
-#include <kdl_conversions/kdl_msg.h>
 #include <kdl/utilities/error.h>
-#include <kdl/utilities/utility.h>
-#include <kdl/trajectory_segment.hpp>
-#include <kdl/rotational_interpolation_sa.hpp>
 
 namespace pilz
 {
@@ -176,59 +172,40 @@ void TrajectoryGeneratorCIRC::plan(const planning_interface::MotionPlanRequest &
                                    const double& sampling_time,
                                    trajectory_msgs::JointTrajectory& joint_trajectory)
 {
-  std::unique_ptr<KDL::Path> cart_path(setPathCIRC(plan_info));
-  std::unique_ptr<KDL::VelocityProfile> vel_profile(cartesianTrapVelocityProfile(req.max_velocity_scaling_factor, req.max_acceleration_scaling_factor, cart_path));
-
-  // combine path and velocity profile into Cartesian trajectory
-  // with the third parameter set to false, KDL::Trajectory_Segment does not take
-  // the ownship of Path and Velocity Profile
-  KDL::Trajectory_Segment cart_trajectory(cart_path.get(), vel_profile.get(), false);
+  std::unique_ptr<CartesianPath> cart_path(setPathCIRC(plan_info));
+  std::unique_ptr<KDL::VelocityProfile> vel_profile(cartesianTrapVelocityProfile(req.max_velocity_scaling_factor,
+                                                                                 req.max_acceleration_scaling_factor,
+                                                                                 cart_path->getLength()));
 
   moveit_msgs::MoveItErrorCodes error_code;
   // sample the Cartesian trajectory and compute joint trajectory using inverse kinematics
   if(!generateJointTrajectory(robot_model_,
                               planner_limits_.getJointLimitContainer(),
-                              cart_trajectory,
+                              *cart_path,
+                              *vel_profile,
                               plan_info.group_name,
                               plan_info.link_name,
                               plan_info.start_joint_position,
                               sampling_time,
                               joint_trajectory,
-                              error_code))
+                              error_code,
+                              false,
+                              cancellation_token_,
+                              deadline_))
   {
     throw CircTrajectoryConversionFailure("Failed to generate valid joint trajectory from the Cartesian path",
                                           error_code.val);
   }
 }
 
-std::unique_ptr<KDL::Path> TrajectoryGeneratorCIRC::setPathCIRC(const MotionPlanInfo &info) const
+std::unique_ptr<CartesianPath> TrajectoryGeneratorCIRC::setPathCIRC(const MotionPlanInfo &info) const
 {
   ROS_DEBUG("Set Cartesian path for CIRC command.");
 
-  KDL::Frame start_pose, goal_pose;
-  tf::transformEigenToKDL(info.start_pose, start_pose);
-  tf::transformEigenToKDL(info.goal_pose, goal_pose);
-
-  KDL::Vector path_point;
-  tf::vectorEigenToKDL(info.circ_path_point.second, path_point);
-
-  // pass the ratio of translational by rotational velocity as equivalent radius
-  // to get a trajectory with rotational speed, if no (or very little) translational distance
-  // The KDL::Path implementation chooses the motion with the longer duration (translation vs. rotation)
-  // and uses eqradius as scaling factor between the distances.
-  double eqradius = planner_limits_.getCartesianLimits().getMaxTranslationalVelocity()/
-      planner_limits_.getCartesianLimits().getMaxRotationalVelocity();
-
   try
   {
-    if(info.circ_path_point.first == "center")
-    {
-      return PathCircleGenerator::circleFromCenter(start_pose, goal_pose, path_point, eqradius);
-    }
-    else //if (info.circ_path_point.first == "interim")
-    {
-      return PathCircleGenerator::circleFromInterim(start_pose, goal_pose, path_point, eqradius);
-    }
+    return createCIRCPath(info.start_pose, info.goal_pose, info.circ_path_point.second,
+                          info.circ_path_point.first == "center", planner_limits_.getCartesianLimits());
   }
   catch(KDL::Error_MotionPlanning_Circle_No_Plane &e)
   {
@@ -23,13 +23,12 @@
 #include <sstream>
 
 #include <eigen_conversions/eigen_msg.h>
-#include <eigen_conversions/eigen_kdl.h>
 
 #include <moveit/robot_state/conversions.h>
 
-#include <kdl/path_line.hpp>
 #include <kdl/utilities/error.h>
-#include <kdl/trajectory_segment.hpp>
+
+#include "pilz_trajectory_generation/planning_core.h"
 
 namespace pilz {
 
@@ -135,27 +134,28 @@ void TrajectoryGeneratorLIN::plan(const planning_interface::MotionPlanRequest &r
                                   trajectory_msgs::JointTrajectory& joint_trajectory)
 {
   // create Cartesian path for lin
-  std::unique_ptr<KDL::Path> path( setPathLIN(plan_info.start_pose, plan_info.goal_pose) );
+  std::unique_ptr<CartesianPath> path(setPathLIN(plan_info.start_pose, plan_info.goal_pose));
 
   // create velocity profile
-  std::unique_ptr<KDL::VelocityProfile> vp(cartesianTrapVelocityProfile(req.max_velocity_scaling_factor, req.max_acceleration_scaling_factor, path));
-
-  // combine path and velocity profile into Cartesian trajectory
-  // with the third parameter set to false, KDL::Trajectory_Segment does not take
-  // the ownship of Path and Velocity Profile
-  KDL::Trajectory_Segment cart_trajectory(path.get(), vp.get(), false);
+  std::unique_ptr<KDL::VelocityProfile> vp(cartesianTrapVelocityProfile(req.max_velocity_scaling_factor,
+                                                                        req.max_acceleration_scaling_factor,
+                                                                        path->getLength()));
 
   moveit_msgs::MoveItErrorCodes error_code;
   // sample the Cartesian trajectory and compute joint trajectory using inverse kinematics
   if(!generateJointTrajectory(robot_model_,
                               planner_limits_.getJointLimitContainer(),
-                              cart_trajectory,
+                              *path,
+                              *vp,
                               plan_info.group_name,
                               plan_info.link_name,
                               plan_info.start_joint_position,
                               sampling_time,
                               joint_trajectory,
-                              error_code))
+                              error_code,
+                              false,
+                              cancellation_token_,
+                              deadline_))
   {
     std::ostringstream os;
     os << "Failed to generate valid joint trajectory from the Cartesian path";
@@ -163,24 +163,11 @@ void TrajectoryGeneratorLIN::plan(const planning_interface::MotionPlanRequest &r
   }
 }
 
-std::unique_ptr<KDL::Path> TrajectoryGeneratorLIN::setPathLIN(const Eigen::Affine3d& start_pose,
-                                                              const Eigen::Affine3d& goal_pose) const
+std::unique_ptr<CartesianPath> TrajectoryGeneratorLIN::setPathLIN(const Eigen::Isometry3d& start_pose,
+                                                                  const Eigen::Isometry3d& goal_pose) const
 {
   ROS_DEBUG("Set Cartesian path for LIN command.");
-
-  KDL::Frame kdl_start_pose, kdl_goal_pose;
-  tf::transformEigenToKDL(start_pose, kdl_start_pose);
-  tf::transformEigenToKDL(goal_pose, kdl_goal_pose);
-  double eqradius = planner_limits_.getCartesianLimits().getMaxTranslationalVelocity()/
-      planner_limits_.getCartesianLimits().getMaxRotationalVelocity();
-  KDL::RotationalInterpolation* rot_interpo = new KDL::RotationalInterpolation_SingleAxis();
-
-  return std::unique_ptr<KDL::Path>(new KDL::Path_Line(kdl_start_pose,
-                                                       kdl_goal_pose,
-                                                       rot_interpo,
-                                                       eqradius,
-                                                       true));
-
+  return createLINPath(start_pose, goal_pose, planner_limits_.getCartesianLimits());
 }
 
 } // namespace pilz
@@ -0,0 +1,367 @@
+/*
+ * Copyright (c) 2018 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pilz_trajectory_generation/trajectory_generator_spline.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+#include <ros/ros.h>
+#include <eigen_conversions/eigen_msg.h>
+#include <moveit/robot_state/conversions.h>
+
+namespace pilz {
+
+/**
+ * @brief Returns a copy of the limits without velocity, acceleration and deceleration limits.
+ */
+static JointLimitsContainer withoutDynamicLimits(const JointLimitsContainer& joint_limits)
+{
+  JointLimitsContainer position_limits;
+  for(const auto& limit : joint_limits)
+  {
+    pilz_extensions::JointLimit position_limit {limit.second};
+    position_limit.has_velocity_limits = false;
+    position_limit.has_acceleration_limits = false;
+    position_limit.has_deceleration_limits = false;
+    position_limits.addLimit(limit.first, position_limit);
+  }
+  return position_limits;
+}
+
+TrajectoryGeneratorSPLINE::TrajectoryGeneratorSPLINE(const moveit::core::RobotModelConstPtr &robot_model,
+                                                     const LimitsContainer &planner_limits)
+  :TrajectoryGenerator::TrajectoryGenerator(robot_model, planner_limits)
+{
+  if(!planner_limits_.hasFullCartesianLimits())
+  {
+    ROS_ERROR("Cartesian limits not set for SPLINE trajectory generator.");
+    throw TrajectoryGeneratorInvalidLimitsException("Cartesian limits are not fully set for SPLINE trajectory generator.");
+  }
+}
+
+void TrajectoryGeneratorSPLINE::cmdSpecificRequestValidation(const planning_interface::MotionPlanRequest &req) const
+{
+  const auto& position_constraints {req.path_constraints.position_constraints};
+  const auto& orientation_constraints {req.path_constraints.orientation_constraints};
+
+  if(position_constraints.size() != orientation_constraints.size())
+  {
+    std::ostringstream os;
+    os << "Each waypoint of a SPLINE needs a position and an orientation constraint (number of position constraints: "
+       << position_constraints.size() << " | number of orientation constraints: "
+       << orientation_constraints.size() << ")";
+    throw WaypointOrientationMissing(os.str());
+  }
+
+  for(std::size_t i = 0; i < position_constraints.size(); ++i)
+  {
+    if(position_constraints.at(i).constraint_region.primitive_poses.size() != 1)
+    {
+      std::ostringstream os;
+      os << "Position constraint of waypoint " << i << " needs exactly one primitive pose";
+      throw NoWaypointPrimitivePose(os.str());
+    }
+
+    if(position_constraints.at(i).link_name != orientation_constraints.at(i).link_name)
+    {
+      std::ostringstream os;
+      os << "Position and orientation constraint of waypoint " << i << " refer to different links";
+      throw WaypointLinkNameMismatch(os.str());
+    }
+  }
+}
+
+void TrajectoryGeneratorSPLINE::extractMotionPlanInfo(const planning_interface::MotionPlanRequest &req,
+                                                      TrajectoryGenerator::MotionPlanInfo &info) const
+{
+  ROS_DEBUG("Extract necessary information from motion plan request.");
+
+  info.group_name = req.group_name;
+  std::string frame_id {robot_model_->getModelFrame()};
+
+  // goal given in joint space
+  if(!req.goal_constraints.front().joint_constraints.empty())
+  {
+    // the waypoints determine the link, otherwise the tip frame of the group is used
+    if(!req.path_constraints.position_constraints.empty() &&
+       !req.path_constraints.position_constraints.front().link_name.empty())
+    {
+      info.link_name = req.path_constraints.position_constraints.front().link_name;
+    }
+    else
+    {
+      info.link_name = robot_model_->getJointModelGroup(req.group_name)->getSolverInstance()->getTipFrame();
+    }
+
+    if(req.goal_constraints.front().joint_constraints.size() !=
+       robot_model_->getJointModelGroup(req.group_name)->getActiveJointModelNames().size())
+    {
+      std::ostringstream os;
+      os << "Number of joints in goal does not match number of joints of group (Number joints goal: "
+         << req.goal_constraints.front().joint_constraints.size() << " | Number of joints of group: "
+         << robot_model_->getJointModelGroup(req.group_name)->getActiveJointModelNames().size() << ")";
+      throw SplineJointNumberMismatch(os.str());
+    }
+
+    for(const auto &joint_item : req.goal_constraints.front().joint_constraints)
+    {
+      info.goal_joint_position[joint_item.joint_name] = joint_item.position;
+    }
+
+    if(!computeLinkFK(robot_model_, info.link_name, info.goal_joint_position, info.goal_pose))
+    {
+      std::ostringstream os;
+      os << "Unknown link name of SPLINE waypoints: " << info.link_name;
+      throw WaypointLinkNameMismatch(os.str());
+    }
+  }
+  // goal given in Cartesian space
+  else
+  {
+    info.link_name = req.goal_constraints.front().position_constraints.front().link_name;
+    if(req.goal_constraints.front().position_constraints.front().header.frame_id.empty() ||
+       req.goal_constraints.front().orientation_constraints.front().header.frame_id.empty())
+    {
+      ROS_WARN("Frame id is not set in position/orientation constraints of goal. Use model frame as default");
+      frame_id = robot_model_->getModelFrame();
+    }
+    else
+    {
+      frame_id = req.goal_constraints.front().position_constraints.front().header.frame_id;
+    }
+    geometry_msgs::Pose goal_pose_msg;
+    goal_pose_msg.position = req.goal_constraints.front().position_constraints.front()
+        .constraint_region.primitive_poses.front().position;
+    goal_pose_msg.orientation = req.goal_constraints.front().orientation_constraints.front().orientation;
+    normalizeQuaternion(goal_pose_msg.orientation);
+    tf::poseMsgToEigen(goal_pose_msg, info.goal_pose);
+  }
+
+  // waypoints
+  for(std::size_t i = 0; i < req.path_constraints.position_constraints.size(); ++i)
+  {
+    const moveit_msgs::PositionConstraint& position_constraint {req.path_constraints.position_constraints.at(i)};
+    if(!position_constraint.link_name.empty() && position_constraint.link_name != info.link_name)
+    {
+      std::ostringstream os;
+      os << "Link of waypoint " << i << " (" << position_constraint.link_name
+         << ") does not match the link of the goal (" << info.link_name << ")";
+      throw WaypointLinkNameMismatch(os.str());
+    }
+
+    geometry_msgs::Pose waypoint_msg;
+    waypoint_msg.position = position_constraint.constraint_region.primitive_poses.front().position;
+    waypoint_msg.orientation = req.path_constraints.orientation_constraints.at(i).orientation;
+    normalizeQuaternion(waypoint_msg.orientation);
+    Eigen::Isometry3d waypoint;
+    tf::poseMsgToEigen(waypoint_msg, waypoint);
+    info.waypoints.push_back(waypoint);
+  }
+
+  assert(req.start_state.joint_state.name.size() == req.start_state.joint_state.position.size());
+  for(const auto& joint_name : robot_model_->getJointModelGroup(req.group_name)->getActiveJointModelNames())
+  {
+    auto it {std::find(req.start_state.joint_state.name.cbegin(), req.start_state.joint_state.name.cend(), joint_name)};
+    if (it == req.start_state.joint_state.name.cend())
+    {
+      std::ostringstream os;
+      os << "Could not find joint \"" << joint_name << "\" of group \"" << req.group_name << "\" in start state of request";
+      throw SplineJointMissingInStartState(os.str());
+    }
+    size_t index = it - req.start_state.joint_state.name.cbegin();
+    info.start_joint_position[joint_name] = req.start_state.joint_state.position[index];
+  }
+
+  // Ignored return value because at this point the function should always return 'true'.
+  computeLinkFK(robot_model_, info.link_name, info.start_joint_position, info.start_pose);
+
+  //check goal pose ik before Cartesian motion plan starts
+  std::map<std::string, double> ik_solution;
+  if(!computePoseIK(robot_model_,
+                    info.group_name,
+                    info.link_name,
+                    info.goal_pose,
+                    frame_id,
+                    info.start_joint_position,
+                    ik_solution))
+  {
+    std::ostringstream os;
+    os << "Failed to compute inverse kinematics for link: " << info.link_name << " of goal pose";
+    throw SplineInverseForGoalIncalculable(os.str());
+  }
+}
+
+void TrajectoryGeneratorSPLINE::plan(const planning_interface::MotionPlanRequest &req,
+                                     const MotionPlanInfo& plan_info,
+                                     const double& sampling_time,
+                                     trajectory_msgs::JointTrajectory& joint_trajectory)
+{
+  std::unique_ptr<CartesianPathSpline> path(setPathSPLINE(plan_info));
+
+  // limit the velocity, so that the centripetal acceleration does not exceed the Cartesian acceleration limit
+  const CartesianLimit& cartesian_limits {planner_limits_.getCartesianLimits()};
+  double velocity_scaling_factor {req.max_velocity_scaling_factor};
+  if(path->getMaxCurvature() > 0.)
+  {
+    const double max_curve_velocity {std::sqrt(req.max_acceleration_scaling_factor
+                                               * cartesian_limits.getMaxTranslationalAcceleration()
+                                               / path->getMaxCurvature())};
+    velocity_scaling_factor = std::min(velocity_scaling_factor,
+                                       max_curve_velocity / cartesian_limits.getMaxTranslationalVelocity());
+  }
+
+  std::unique_ptr<KDL::VelocityProfile> vp(cartesianTrapVelocityProfile(velocity_scaling_factor,
+                                                                        req.max_acceleration_scaling_factor,
+                                                                        path->getLength()));
+
+  // The joint limits are not checked during the first sampling, instead the required slow down is determined.
+  sampleJointTrajectory(plan_info, *path, *vp, withoutDynamicLimits(planner_limits_.getJointLimitContainer()),
+                        sampling_time, joint_trajectory);
+
+  const double joint_limits_scaling {computeJointLimitsScaling(joint_trajectory,
+                                                               planner_limits_.getJointLimitContainer(),
+                                                               sampling_time)};
+  if(joint_limits_scaling <= 1.)
+  {
+    return;
+  }
+
+  // Scaling the velocity by 1/k and the acceleration by 1/k^2 stretches the trajectory uniformly by k.
+  const double time_scaling {joint_limits_scaling * JOINT_LIMITS_SCALING_MARGIN};
+  ROS_DEBUG_STREAM("Slow down SPLINE trajectory by factor " << time_scaling << " to meet the joint limits.");
+  vp = cartesianTrapVelocityProfile(velocity_scaling_factor / time_scaling,
+                                    req.max_acceleration_scaling_factor / (time_scaling * time_scaling),
+                                    path->getLength());
+  sampleJointTrajectory(plan_info, *path, *vp, planner_limits_.getJointLimitContainer(),
+                        sampling_time, joint_trajectory);
+}
+
+std::unique_ptr<CartesianPathSpline> TrajectoryGeneratorSPLINE::setPathSPLINE(const MotionPlanInfo& info) const
+{
+  ROS_DEBUG("Set Cartesian path for SPLINE command.");
+
+  PoseBuffer poses;
+  poses.reserve(info.waypoints.size() + 2);
+  poses.push_back(info.start_pose);
+  poses.insert(poses.end(), info.waypoints.begin(), info.waypoints.end());
+  poses.push_back(info.goal_pose);
+
+  double eqradius = planner_limits_.getCartesianLimits().getMaxTranslationalVelocity()/
+      planner_limits_.getCartesianLimits().getMaxRotationalVelocity();
+
+  try
+  {
+    return std::unique_ptr<CartesianPathSpline>(new CartesianPathSpline(poses, eqradius, MIN_WAYPOINT_DISTANCE));
+  }
+  catch(const std::invalid_argument& e)
+  {
+    std::ostringstream os;
+    os << "Failed to create path object for spline. " << e.what();
+    throw WaypointsTooClose(os.str());
+  }
+}
+
+void TrajectoryGeneratorSPLINE::sampleJointTrajectory(const MotionPlanInfo& plan_info,
+                                                      const CartesianPath& path,
+                                                      const KDL::VelocityProfile& velocity_profile,
+                                                      const JointLimitsContainer& joint_limits,
+                                                      const double& sampling_time,
+                                                      trajectory_msgs::JointTrajectory& joint_trajectory) const
+{
+  joint_trajectory.points.clear();
+
+  moveit_msgs::MoveItErrorCodes error_code;
+  // sample the Cartesian trajectory and compute joint trajectory using inverse kinematics
+  if(!generateJointTrajectory(robot_model_,
+                              joint_limits,
+                              path,
+                              velocity_profile,
+                              plan_info.group_name,
+                              plan_info.link_name,
+                              plan_info.start_joint_position,
+                              sampling_time,
+                              joint_trajectory,
+                              error_code,
+                              false,
+                              cancellation_token_,
+                              deadline_))
+  {
+    throw SplineTrajectoryConversionFailure("Failed to generate valid joint trajectory from the Cartesian path",
+                                            error_code.val);
+  }
+}
+
+double TrajectoryGeneratorSPLINE::computeJointLimitsScaling(const trajectory_msgs::JointTrajectory& joint_trajectory,
+                                                            const JointLimitsContainer& joint_limits,
+                                                            const double& sampling_time)
+{
+  // The velocities and accelerations are computed like in verifySampleJointLimits().
+  double max_velocity_ratio {0.};
+  double max_acceleration_ratio {0.};
+  for(std::size_t j = 0; j < joint_trajectory.joint_names.size(); ++j)
+  {
+    const std::string& joint_name {joint_trajectory.joint_names.at(j)};
+    if(!joint_limits.hasLimit(joint_name))
+    {
+      continue;
+    }
+    const pilz_extensions::JointLimit limit {joint_limits.getLimit(joint_name)};
+
+    double velocity_last {0.};
+    for(std::size_t i = 1; i < joint_trajectory.points.size(); ++i)
+    {
+      const double duration {(joint_trajectory.points.at(i).time_from_start
+                               - joint_trajectory.points.at(i - 1).time_from_start).toSec()};
+      if(duration <= 0.)
+      {
+        continue;
+      }
+
+      const double velocity {(joint_trajectory.points.at(i).positions.at(j)
+                              - joint_trajectory.points.at(i - 1).positions.at(j)) / duration};
+      const double acceleration {(velocity - velocity_last) / (sampling_time + duration) * 2};
+
+      if(limit.has_velocity_limits && limit.max_velocity > 0.)
+      {
+        max_velocity_ratio = std::max(max_velocity_ratio, std::fabs(velocity) / limit.max_velocity);
+      }
+      if(std::fabs(velocity_last) <= std::fabs(velocity))
+      {
+        if(limit.has_acceleration_limits && limit.max_acceleration > 0.)
+        {
+          max_acceleration_ratio = std::max(max_acceleration_ratio,
+                                            std::fabs(acceleration) / limit.max_acceleration);
+        }
+      }
+      else if(limit.has_deceleration_limits && limit.max_deceleration < 0.)
+      {
+        max_acceleration_ratio = std::max(max_acceleration_ratio,
+                                          std::fabs(acceleration) / std::fabs(limit.max_deceleration));
+      }
+
+      velocity_last = velocity;
+    }
+  }
+
+  return std::max({1., max_velocity_ratio, std::sqrt(max_acceleration_ratio)});
+}
+
+} // namespace pilz
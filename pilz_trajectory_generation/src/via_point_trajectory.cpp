@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2018 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pilz_trajectory_generation/via_point_trajectory.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+#include <Eigen/Core>
+#include <ros/console.h>
+
+#include "pilz_trajectory_generation/planning_core.h"
+
+namespace pilz
+{
+
+//! Minimal duration of a segment (reached if the waypoints of the segment are equal).
+static constexpr double MIN_SEGMENT_DURATION {1e-3};
+//! Maximal number of iterations which adjust the durations of the individual segments.
+static constexpr std::size_t MAX_DURATION_ITERATIONS {100};
+//! Tolerance of the limit ratio of a segment, which ends the iteration.
+static constexpr double LIMIT_RATIO_TOLERANCE {1e-6};
+
+namespace
+{
+
+/**
+ * @return The real roots of a*t^2 + b*t + c within the open interval (0, 1).
+ */
+std::vector<double> unitIntervalRoots(const double a, const double b, const double c)
+{
+  std::vector<double> roots;
+  if (std::fabs(a) < std::numeric_limits<double>::epsilon())
+  {
+    if (std::fabs(b) >= std::numeric_limits<double>::epsilon())
+    {
+      roots.push_back(-c / b);
+    }
+  }
+  else
+  {
+    const double discriminant {b*b - 4.*a*c};
+    if (discriminant >= 0.)
+    {
+      roots.push_back((-b + std::sqrt(discriminant)) / (2.*a));
+      roots.push_back((-b - std::sqrt(discriminant)) / (2.*a));
+    }
+  }
+  roots.erase(std::remove_if(roots.begin(), roots.end(), [](const double t) { return t <= 0. || t >= 1.; }),
+              roots.end());
+  return roots;
+}
+
+/**
+ * @brief Quintic polynomial of one joint in a segment, given by the positions and velocities at the
+ * boundaries of the segment and zero accelerations at both boundaries (quintic Hermite form).
+ *
+ * Since all segments start and end with zero acceleration, the acceleration is continuous at the
+ * via points and zero at start and goal.
+ *
+ * The functions take the normalized time t = [0, 1], the position is
+ * p(t) = start_position + w0*t + c3*t^3 + c4*t^4 + c5*t^5 with w0 = duration*start_velocity.
+ */
+struct QuinticSegment
+{
+  QuinticSegment(const double start_position, const double end_position,
+                 const double start_velocity, const double end_velocity, const double duration)
+    : start_position(start_position)
+    , duration(duration)
+    , w0(duration*start_velocity)
+  {
+    const double distance {end_position - start_position};
+    const double w1 {duration*end_velocity};
+    c3 = 10.*distance - 6.*w0 - 4.*w1;
+    c4 = -15.*distance + 8.*w0 + 7.*w1;
+    c5 = 6.*distance - 3.*w0 - 3.*w1;
+  }
+
+  double position(const double t) const
+  {
+    return start_position + t*(w0 + t*t*(c3 + t*(c4 + t*c5)));
+  }
+
+  double velocity(const double t) const
+  {
+    return (w0 + t*t*(3.*c3 + t*(4.*c4 + t*5.*c5))) / duration;
+  }
+
+  double acceleration(const double t) const
+  {
+    return t*(6.*c3 + t*(12.*c4 + t*20.*c5)) / (duration*duration);
+  }
+
+  double maxAbsVelocity() const
+  {
+    double max_velocity {std::max(std::fabs(velocity(0.)), std::fabs(velocity(1.)))};
+    // The velocity is extremal where the acceleration t*(6*c3 + 12*c4*t + 20*c5*t^2) crosses zero
+    for (const double t : unitIntervalRoots(20.*c5, 12.*c4, 6.*c3))
+    {
+      max_velocity = std::max(max_velocity, std::fabs(velocity(t)));
+    }
+    return max_velocity;
+  }
+
+  double maxAbsAcceleration() const
+  {
+    // The acceleration is zero at the boundaries and extremal where the jerk crosses zero
+    double max_acceleration {0.};
+    for (const double t : unitIntervalRoots(60.*c5, 24.*c4, 6.*c3))
+    {
+      max_acceleration = std::max(max_acceleration, std::fabs(acceleration(t)));
+    }
+    return max_acceleration;
+  }
+
+  double start_position;
+  double duration;
+  double w0;
+  double c3;
+  double c4;
+  double c5;
+};
+
+}
+
+/**
+ * @brief Sets the velocities at the via points (the velocities at start and goal stay zero).
+ */
+static void computeViaVelocities(const std::vector<Eigen::VectorXd>& positions,
+                                 const std::vector<double>& durations,
+                                 std::vector<Eigen::VectorXd>& velocities)
+{
+  for (std::size_t i = 1; i + 1 < positions.size(); ++i)
+  {
+    for (Eigen::Index j = 0; j < positions.at(i).size(); ++j)
+    {
+      const double velocity_before {(positions.at(i)(j) - positions.at(i-1)(j)) / durations.at(i-1)};
+      const double velocity_after {(positions.at(i+1)(j) - positions.at(i)(j)) / durations.at(i)};
+      // The harmonic mean avoids overshooting the waypoints
+      velocities.at(i)(j) = (velocity_before * velocity_after > 0.) ?
+            2. * velocity_before * velocity_after / (velocity_before + velocity_after) : 0.;
+    }
+  }
+}
+
+/**
+ * @return The factor by which the duration of the specified segment has to be scaled to meet the limits.
+ */
+static double computeLimitRatio(const std::vector<Eigen::VectorXd>& positions,
+                                const std::vector<Eigen::VectorXd>& velocities,
+                                const std::vector<double>& durations,
+                                const std::size_t segment,
+                                const double max_velocity,
+                                const double max_acceleration)
+{
+  double ratio {0.};
+  for (Eigen::Index j = 0; j < positions.at(segment).size(); ++j)
+  {
+    const QuinticSegment quintic {positions.at(segment)(j), positions.at(segment+1)(j),
+                                  velocities.at(segment)(j), velocities.at(segment+1)(j), durations.at(segment)};
+    ratio = std::max(ratio, quintic.maxAbsVelocity() / max_velocity);
+    ratio = std::max(ratio, std::sqrt(quintic.maxAbsAcceleration() / max_acceleration));
+  }
+  return ratio;
+}
+
+bool generateViaPointTrajectory(const JointLimitsContainer& joint_limits,
+                                const std::string& group_name,
+                                const std::vector<robot_state::RobotStateConstPtr>& waypoints,
+                                const std::vector<ViaPointScaling>& scaling,
+                                const double sampling_time,
+                                robot_trajectory::RobotTrajectory& trajectory)
+{
+  if (waypoints.size() < 2 || scaling.size() + 1 != waypoints.size() || sampling_time <= 0.)
+  {
+    ROS_ERROR("Invalid waypoints, scaling factors or sampling time for via point trajectory.");
+    return false;
+  }
+
+  const moveit::core::JointModelGroup* group {waypoints.front()->getJointModelGroup(group_name)};
+  if (!group)
+  {
+    ROS_ERROR_STREAM("Unknown planning group: " << group_name);
+    return false;
+  }
+
+  pilz_extensions::JointLimit common_limit;
+  try
+  {
+    common_limit = joint_limits.getCommonLimit(group->getActiveJointModelNames());
+  }
+  catch (const std::out_of_range&)
+  {
+    ROS_ERROR_STREAM("Missing joint limits for the joints of planning group " << group_name);
+    return false;
+  }
+  if (!common_limit.has_velocity_limits || !common_limit.has_acceleration_limits)
+  {
+    ROS_ERROR_STREAM("Missing velocity or acceleration limits for planning group " << group_name);
+    return false;
+  }
+  const double common_max_acceleration {common_limit.has_deceleration_limits ?
+          std::min(common_limit.max_acceleration, -common_limit.max_deceleration) :
+          common_limit.max_acceleration};
+
+  const std::size_t num_segments {scaling.size()};
+  std::vector<Eigen::VectorXd> positions(waypoints.size());
+  for (std::size_t i = 0; i < waypoints.size(); ++i)
+  {
+    waypoints.at(i)->copyJointGroupPositions(group, positions.at(i));
+  }
+  const Eigen::Index num_joints {positions.front().size()};
+
+  // Start with the durations needed at maximal velocity
+  std::vector<double> max_velocities(num_segments);
+  std::vector<double> max_accelerations(num_segments);
+  std::vector<double> durations(num_segments);
+  for (std::size_t i = 0; i < num_segments; ++i)
+  {
+    max_velocities.at(i) = common_limit.max_velocity * scaling.at(i).velocity;
+    max_accelerations.at(i) = common_max_acceleration * scaling.at(i).acceleration;
+    const double max_distance {num_joints > 0 ? (positions.at(i+1) - positions.at(i)).cwiseAbs().maxCoeff() : 0.};
+    durations.at(i) = std::max(MIN_SEGMENT_DURATION, max_distance / max_velocities.at(i));
+  }
+
+  // Stretch each segment violating the limits
+  std::vector<Eigen::VectorXd> velocities(waypoints.size(), Eigen::VectorXd::Zero(num_joints));
+  for (std::size_t iteration = 0; iteration < MAX_DURATION_ITERATIONS; ++iteration)
+  {
+    computeViaVelocities(positions, durations, velocities);
+    bool within_limits {true};
+    for (std::size_t i = 0; i < num_segments; ++i)
+    {
+      const double ratio {computeLimitRatio(positions, velocities, durations, i,
+                                            max_velocities.at(i), max_accelerations.at(i))};
+      if (ratio > 1. + LIMIT_RATIO_TOLERANCE)
+      {
+        durations.at(i) *= ratio;
+        within_limits = false;
+      }
+    }
+    if (within_limits)
+    {
+      break;
+    }
+  }
+
+  // Stretching all segments by the same factor scales all velocities by its inverse and all
+  // accelerations by its inverse square, which guarantees the limits if the iteration did not converge.
+  computeViaVelocities(positions, durations, velocities);
+  double max_ratio {0.};
+  for (std::size_t i = 0; i < num_segments; ++i)
+  {
+    max_ratio = std::max(max_ratio, computeLimitRatio(positions, velocities, durations, i,
+                                                      max_velocities.at(i), max_accelerations.at(i)));
+  }
+  if (max_ratio > 1.)
+  {
+    for (double& duration : durations)
+    {
+      duration *= max_ratio;
+    }
+    computeViaVelocities(positions, durations, velocities);
+  }
+
+  // Sample the trajectory
+  const double total_duration {std::accumulate(durations.cbegin(), durations.cend(), 0.)};
+  const std::vector<double> time_samples {sampleTimes(total_duration, sampling_time)};
+
+  robot_state::RobotState state {*waypoints.front()};
+  Eigen::VectorXd position(num_joints), velocity(num_joints), acceleration(num_joints);
+  std::size_t segment {0};
+  double segment_start {0.};
+  for (std::size_t k = 0; k < time_samples.size(); ++k)
+  {
+    const double time {time_samples.at(k)};
+    while (segment + 1 < num_segments && time > segment_start + durations.at(segment))
+    {
+      segment_start += durations.at(segment);
+      ++segment;
+    }
+    const double t {std::min(1., std::max(0., (time - segment_start) / durations.at(segment)))};
+
+    for (Eigen::Index j = 0; j < num_joints; ++j)
+    {
+      const QuinticSegment quintic {positions.at(segment)(j), positions.at(segment+1)(j),
+                                    velocities.at(segment)(j), velocities.at(segment+1)(j), durations.at(segment)};
+      position(j) = quintic.position(t);
+      velocity(j) = quintic.velocity(t);
+      acceleration(j) = quintic.acceleration(t);
+    }
+    // First and last point have zero velocity and acceleration (exactly, without rounding errors)
+    if (k == 0 || k + 1 == time_samples.size())
+    {
+      velocity.setZero();
+      acceleration.setZero();
+    }
+
+    state.setJointGroupPositions(group, position);
+    state.setJointGroupVelocities(group, velocity);
+    state.setJointGroupAccelerations(group, acceleration);
+    state.update();
+    trajectory.addSuffixWayPoint(state, k == 0 ? 0. : time - time_samples.at(k-1));
+  }
+
+  return true;
+}
+
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2018 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include <moveit/planning_pipeline/planning_pipeline.h>
+#include <moveit/planning_scene/planning_scene.h>
+#include <moveit/robot_model_loader/robot_model_loader.h>
+#include <moveit/robot_model/robot_model.h>
+#include <ros/ros.h>
+
+#include <pilz_industrial_motion_testutils/xml_testdata_loader.h>
+#include <pilz_industrial_motion_testutils/ptp.h>
+
+#include "pilz_msgs/MotionSequenceRequest.h"
+#include "pilz_trajectory_generation/command_list_manager.h"
+
+const std::string ROBOT_DESCRIPTION_STR {"robot_description"};
+const std::string TEST_DATA_FILE_NAME("testdata_file_name");
+
+using Clock = std::chrono::steady_clock;
+
+using namespace pilz_trajectory_generation;
+using namespace pilz_industrial_motion_testutils;
+
+/**
+ * @brief Measures the time needed to process large sequences with the command list manager.
+ *
+ * The sequences consist of alternating PTP commands. The planning results of identical requests
+ * are reused within a sequence, so that the processing of the sequence items dominates the solving time.
+ * The results are printed and recorded as properties of the test result.
+ */
+class CommandListManagerBenchmark : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    ASSERT_FALSE(robot_model_ == nullptr) << "There is no robot model!";
+
+    std::string test_data_file_name;
+    ASSERT_TRUE(ph_.getParam(TEST_DATA_FILE_NAME, test_data_file_name));
+    data_loader_.reset(new XmlTestdataLoader{test_data_file_name, robot_model_});
+
+    scene_ = std::make_shared<planning_scene::PlanningScene>(robot_model_);
+    pipeline_ = std::make_shared<planning_pipeline::PlanningPipeline>(robot_model_, ph_);
+  }
+
+  /**
+   * @brief Creates a sequence of alternating PTP commands without blending.
+   */
+  pilz_msgs::MotionSequenceRequest createRequest(const std::size_t num_items) const
+  {
+    const PtpJoint ptp_1 {data_loader_->getPtpJoint("Ptp1")};
+    const PtpJoint ptp_2 {data_loader_->getPtpJoint("Ptp2")};
+
+    pilz_msgs::MotionSequenceRequest req;
+    req.items.resize(num_items);
+    for (std::size_t i = 0; i < num_items; ++i)
+    {
+      req.items.at(i).req = (i % 2 == 0) ? ptp_1.toRequest() : ptp_2.toRequest();
+      if (i > 0)
+      {
+        // Only the first request is allowed to have a start state.
+        req.items.at(i).req.start_state = moveit_msgs::RobotState();
+      }
+      req.items.at(i).blend_radius = 0.;
+    }
+    return req;
+  }
+
+  /**
+   * @brief Solves the sequence with a new manager and reports the solving time.
+   */
+  void solve(const std::size_t num_items)
+  {
+    const pilz_msgs::MotionSequenceRequest req {createRequest(num_items)};
+    CommandListManager manager(ph_, robot_model_);
+
+    const Clock::time_point start {Clock::now()};
+    const RobotTrajCont res_vec {manager.solve(scene_, pipeline_, req)};
+    const double milliseconds {std::chrono::duration<double, std::milli>(Clock::now() - start).count()};
+    EXPECT_EQ(1u, res_vec.size());
+
+    const std::string key {"solving_time_" + std::to_string(num_items) + "_ms"};
+    ROS_INFO_STREAM(key << ": " << milliseconds << " ms");
+    RecordProperty(key, std::to_string(milliseconds));
+  }
+
+protected:
+  ros::NodeHandle ph_ {"~"};
+  robot_model::RobotModelConstPtr robot_model_ {
+    robot_model_loader::RobotModelLoader(ROBOT_DESCRIPTION_STR).getModel()};
+  planning_scene::PlanningScenePtr scene_;
+  planning_pipeline::PlanningPipelinePtr pipeline_;
+  std::unique_ptr<TestdataLoader> data_loader_;
+};
+
+/**
+ * @brief Measures the solving time of sequences with 1000 and 10000 commands
+ * (the solving time should grow roughly linear with the number of commands).
+ */
+TEST_F(CommandListManagerBenchmark, LargeSequences)
+{
+  solve(1000);
+  solve(10000);
+}
+
+int main(int argc, char **argv)
+{
+  ros::init(argc, argv, "benchmark_command_list_manager");
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2018 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <moveit/planning_interface/planning_interface.h>
+#include <moveit/robot_model_loader/robot_model_loader.h>
+#include <moveit/robot_model/robot_model.h>
+#include <pluginlib/class_loader.h>
+#include <ros/ros.h>
+
+const std::string PARAM_MODEL_NO_GRIPPER_NAME {"robot_description"};
+const std::string PARAM_MODEL_WITH_GRIPPER_NAME {"robot_description_pg70"};
+const std::string PLANNING_GROUP {"manipulator"};
+
+static constexpr std::size_t NUM_INITIALIZATIONS {20};
+
+using Clock = std::chrono::steady_clock;
+
+static double toMilliseconds(const Clock::duration& duration)
+{
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+/**
+ * @brief Measures the time needed to initialize the command planner (as done on a restart of the move_group)
+ * and the time of the first planning context requests, which load the context loaders.
+ *
+ * The results are printed and recorded as properties of the test result.
+ */
+class CommandPlannerStartupBenchmark : public testing::TestWithParam<std::string>
+{
+protected:
+  void SetUp() override
+  {
+    ASSERT_TRUE(ph_.getParam("planning_plugin", planner_plugin_name_)) << "Could not find planner plugin name";
+    ASSERT_FALSE(robot_model_ == nullptr) << "There is no robot model!";
+    planner_plugin_loader_.reset(new pluginlib::ClassLoader<planning_interface::PlannerManager>(
+                                   "moveit_core", "planning_interface::PlannerManager"));
+  }
+
+  void TearDown() override
+  {
+    planner_plugin_loader_->unloadLibraryForClass(planner_plugin_name_);
+  }
+
+  /**
+   * @brief Creates and initializes a planner instance, returns the duration of the initialization.
+   */
+  Clock::duration createPlannerInstance(planning_interface::PlannerManagerPtr& planner_instance)
+  {
+    planner_instance.reset(planner_plugin_loader_->createUnmanagedInstance(planner_plugin_name_));
+    const Clock::time_point start {Clock::now()};
+    const bool initialized {planner_instance->initialize(robot_model_, ph_.getNamespace())};
+    const Clock::duration duration {Clock::now() - start};
+    EXPECT_TRUE(initialized) << "Initialzing the planner instance failed.";
+    return duration;
+  }
+
+  void report(const std::string& key, const double milliseconds)
+  {
+    ROS_INFO_STREAM("[" << GetParam() << "] " << key << ": " << milliseconds << " ms");
+    RecordProperty(key, std::to_string(milliseconds));
+  }
+
+protected:
+  ros::NodeHandle ph_ {"~"};
+  robot_model::RobotModelConstPtr robot_model_ {robot_model_loader::RobotModelLoader(GetParam()).getModel()};
+
+  std::string planner_plugin_name_;
+  std::unique_ptr<pluginlib::ClassLoader<planning_interface::PlannerManager> > planner_plugin_loader_;
+};
+
+// Instantiate the benchmark for robot model with and without gripper
+INSTANTIATE_TEST_CASE_P(InstantiationName, CommandPlannerStartupBenchmark, ::testing::Values(
+                          PARAM_MODEL_NO_GRIPPER_NAME,
+                          PARAM_MODEL_WITH_GRIPPER_NAME
+                          ));
+
+/**
+ * @brief Measures the initialization of the first and of further planner instances.
+ */
+TEST_P(CommandPlannerStartupBenchmark, Initialize)
+{
+  planning_interface::PlannerManagerPtr planner_instance;
+  report("first_initialize_ms", toMilliseconds(createPlannerInstance(planner_instance)));
+
+  Clock::duration total {Clock::duration::zero()};
+  for(std::size_t i = 0; i < NUM_INITIALIZATIONS; ++i)
+  {
+    total += createPlannerInstance(planner_instance);
+  }
+  report("mean_initialize_ms", toMilliseconds(total) / NUM_INITIALIZATIONS);
+}
+
+/**
+ * @brief Measures the first and the second planning context request of each command.
+ */
+TEST_P(CommandPlannerStartupBenchmark, FirstPlanningContextRequests)
+{
+  planning_interface::PlannerManagerPtr planner_instance;
+  createPlannerInstance(planner_instance);
+
+  std::vector<std::string> algs;
+  planner_instance->getPlanningAlgorithms(algs);
+  for(const auto& alg : algs)
+  {
+    moveit_msgs::MotionPlanRequest req;
+    req.planner_id = alg;
+    req.group_name = PLANNING_GROUP;
+    moveit_msgs::MoveItErrorCodes error_code;
+
+    for(const std::string& request : {"first", "second"})
+    {
+      const Clock::time_point start {Clock::now()};
+      planning_interface::PlanningContextPtr context {planner_instance->getPlanningContext(nullptr, req, error_code)};
+      const Clock::duration duration {Clock::now() - start};
+      EXPECT_NE(nullptr, context) << alg;
+      report(request + "_context_" + alg + "_ms", toMilliseconds(duration));
+    }
+  }
+}
+
+int main(int argc, char **argv)
+{
+  ros::init(argc, argv, "benchmark_command_planner_startup");
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2018 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <moveit/robot_model_loader/robot_model_loader.h>
+#include <ros/ros.h>
+#include <rosbag/bag.h>
+#include <rosbag/view.h>
+
+#include "pilz_trajectory_generation/batch_planner.h"
+
+using namespace pilz_trajectory_generation;
+
+const std::string PARAM_SEQUENCES {"sequences"};
+const std::string TEST_BAG_FILE {"/tmp/integrationtest_batch_planner.bag"};
+
+class IntegrationTestBatchPlanner : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    ASSERT_TRUE(robot_model_) << "There is no robot model!";
+    ASSERT_TRUE(ph_.getParam(PARAM_SEQUENCES, sequences_param_)) << "There are no sequences!";
+  }
+
+  void TearDown() override
+  {
+    std::remove(TEST_BAG_FILE.c_str());
+  }
+
+protected:
+  ros::NodeHandle ph_ {"~"};
+  robot_model::RobotModelConstPtr robot_model_ {
+    robot_model_loader::RobotModelLoader("robot_description").getModel()};
+  XmlRpc::XmlRpcValue sequences_param_;
+};
+
+/**
+ * @brief Checks that the sequences of the YAML file are converted into sequence requests.
+ */
+TEST_F(IntegrationTestBatchPlanner, ReadSequences)
+{
+  const auto sequences {BatchPlanner::readSequences(sequences_param_, robot_model_)};
+  ASSERT_EQ(static_cast<std::size_t>(sequences_param_.size()), sequences.size());
+
+  for(const auto& sequence : sequences)
+  {
+    ASSERT_FALSE(sequence.items.empty());
+    EXPECT_FALSE(sequence.items.front().req.start_state.joint_state.name.empty());
+    EXPECT_EQ(0., sequence.items.back().blend_radius);
+    for(const auto& item : sequence.items)
+    {
+      EXPECT_EQ(1u, item.req.goal_constraints.size());
+    }
+  }
+
+  const auto& circ_req {sequences.at(1).items.at(1).req};
+  EXPECT_EQ("CIRC", circ_req.planner_id);
+  EXPECT_EQ("interim", circ_req.path_constraints.name);
+  ASSERT_EQ(1u, circ_req.path_constraints.position_constraints.size());
+  EXPECT_EQ("prbt_tcp", circ_req.path_constraints.position_constraints.front().link_name);
+
+  const auto& spline_req {sequences.at(2).items.front().req};
+  EXPECT_EQ("SPLINE", spline_req.planner_id);
+  EXPECT_EQ(1u, spline_req.path_constraints.position_constraints.size());
+  EXPECT_EQ(1u, spline_req.path_constraints.orientation_constraints.size());
+}
+
+/**
+ * @brief Checks that invalid sequence descriptions are rejected.
+ */
+TEST_F(IntegrationTestBatchPlanner, ReadInvalidSequences)
+{
+  XmlRpc::XmlRpcValue item;
+  item["planner_id"] = "PTP";
+  item["group_name"] = "manipulator";
+  XmlRpc::XmlRpcValue sequences;
+  sequences[0][0] = item;
+
+  // no goal
+  EXPECT_THROW(BatchPlanner::readSequences(sequences, robot_model_), InvalidSequenceDescription);
+
+  // wrong number of joints
+  sequences[0][0]["joints"][0] = 0.;
+  EXPECT_THROW(BatchPlanner::readSequences(sequences, robot_model_), InvalidSequenceDescription);
+
+  // pose without link
+  item["pose"] = sequences_param_[1][2]["pose"];
+  sequences[0][0] = item;
+  EXPECT_THROW(BatchPlanner::readSequences(sequences, robot_model_), InvalidSequenceDescription);
+
+  // unknown group
+  item["link_name"] = "prbt_tcp";
+  item["group_name"] = "unknown_group";
+  sequences[0][0] = item;
+  EXPECT_THROW(BatchPlanner::readSequences(sequences, robot_model_), InvalidSequenceDescription);
+}
+
+/**
+ * @brief Checks that the sequences are planned successfully in parallel and that the results
+ * equal the results of the planning with one thread.
+ */
+TEST_F(IntegrationTestBatchPlanner, PlanSequences)
+{
+  const auto sequences {BatchPlanner::readSequences(sequences_param_, robot_model_)};
+
+  BatchPlanner parallel_planner(ph_, robot_model_, 3);
+  const auto responses {parallel_planner.plan(sequences)};
+  ASSERT_EQ(sequences.size(), responses.size());
+
+  BatchPlanner sequential_planner(ph_, robot_model_, 1);
+  const auto sequential_responses {sequential_planner.plan(sequences)};
+  ASSERT_EQ(sequences.size(), sequential_responses.size());
+
+  for(std::size_t i = 0; i < responses.size(); ++i)
+  {
+    EXPECT_EQ(moveit_msgs::MoveItErrorCodes::SUCCESS, responses.at(i).error_code.val) << "Sequence " << i;
+    EXPECT_FALSE(responses.at(i).planned_trajectory.empty());
+    EXPECT_EQ(responses.at(i).trajectory_start.size(), responses.at(i).planned_trajectory.size());
+    EXPECT_GT(BatchPlanner::getCycleTime(responses.at(i)), 0.);
+    EXPECT_GT(responses.at(i).planning_time, 0.);
+    EXPECT_DOUBLE_EQ(BatchPlanner::getCycleTime(sequential_responses.at(i)),
+                     BatchPlanner::getCycleTime(responses.at(i)));
+  }
+}
+
+/**
+ * @brief Checks that a failing sequence does not affect the other sequences.
+ */
+TEST_F(IntegrationTestBatchPlanner, PlanInvalidSequence)
+{
+  auto sequences {BatchPlanner::readSequences(sequences_param_, robot_model_)};
+  sequences.front().items.back().blend_radius = 0.1;
+
+  BatchPlanner planner(ph_, robot_model_, 2);
+  const auto responses {planner.plan(sequences)};
+  ASSERT_EQ(sequences.size(), responses.size());
+  EXPECT_EQ(moveit_msgs::MoveItErrorCodes::INVALID_MOTION_PLAN, responses.front().error_code.val);
+  EXPECT_TRUE(responses.front().planned_trajectory.empty());
+  for(std::size_t i = 1; i < responses.size(); ++i)
+  {
+    EXPECT_EQ(moveit_msgs::MoveItErrorCodes::SUCCESS, responses.at(i).error_code.val) << "Sequence " << i;
+  }
+}
+
+/**
+ * @brief Checks the writing of the statistics and the reading and writing of bag files.
+ */
+TEST_F(IntegrationTestBatchPlanner, WriteAndReadResults)
+{
+  const auto sequences {BatchPlanner::readSequences(sequences_param_, robot_model_)};
+  BatchPlanner planner(ph_, robot_model_, 2);
+  const auto responses {planner.plan(sequences)};
+
+  std::stringstream statistics;
+  BatchPlanner::writeStatistics(statistics, responses);
+  std::vector<std::string> lines;
+  for(std::string line; std::getline(statistics, line);)
+  {
+    lines.push_back(line);
+  }
+  ASSERT_EQ(responses.size() + 1, lines.size());
+  EXPECT_EQ("sequence,error_code,trajectories,cycle_time,planning_time", lines.front());
+  EXPECT_EQ(0u, lines.at(1).find("0,1,"));
+
+  BatchPlanner::writeResponsesToBag(TEST_BAG_FILE, responses);
+  {
+    rosbag::Bag bag(TEST_BAG_FILE, rosbag::bagmode::Read);
+    rosbag::View view(bag);
+    std::size_t i {0};
+    for(const rosbag::MessageInstance& message : view)
+    {
+      const auto response {message.instantiate<pilz_msgs::MotionSequenceResponse>()};
+      ASSERT_TRUE(response);
+      ASSERT_LT(i, responses.size());
+      EXPECT_EQ(responses.at(i).planned_trajectory.size(), response->planned_trajectory.size());
+      ++i;
+    }
+    EXPECT_EQ(responses.size(), i);
+  }
+
+  {
+    rosbag::Bag bag(TEST_BAG_FILE, rosbag::bagmode::Write);
+    for(std::size_t i = 0; i < sequences.size(); ++i)
+    {
+      bag.write("sequences", ros::Time(1. + static_cast<double>(i)), sequences.at(i));
+    }
+  }
+  const auto read_sequences {BatchPlanner::readSequencesFromBag(TEST_BAG_FILE)};
+  ASSERT_EQ(sequences.size(), read_sequences.size());
+  for(std::size_t i = 0; i < sequences.size(); ++i)
+  {
+    ASSERT_EQ(sequences.at(i).items.size(), read_sequences.at(i).items.size());
+    EXPECT_EQ(sequences.at(i).items.front().req.planner_id, read_sequences.at(i).items.front().req.planner_id);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  ros::init(argc, argv, "integrationtest_batch_planner");
+  ros::NodeHandle nh;
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
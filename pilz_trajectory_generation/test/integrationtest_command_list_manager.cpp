@@ -15,6 +15,8 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <chrono>
+#include <future>
 #include <memory>
 #include <string>
 
@@ -29,16 +31,19 @@
 #include <moveit_msgs/MotionPlanResponse.h>
 #include <moveit_msgs/DisplayTrajectory.h>
 #include <moveit/planning_scene/planning_scene.h>
+#include <moveit/robot_state/conversions.h>
 
 #include <tf2_eigen/tf2_eigen.h>
 
 #include <pilz_industrial_motion_testutils/xml_testdata_loader.h>
 #include <pilz_industrial_motion_testutils/sequence.h>
 #include <pilz_industrial_motion_testutils/lin.h>
+#include <pilz_industrial_motion_testutils/ptp.h>
 #include <pilz_industrial_motion_testutils/gripper.h>
 
 #include "test_utils.h"
 
+#include "pilz_trajectory_generation/cancellation_token.h"
 #include "pilz_trajectory_generation/command_list_manager.h"
 #include "pilz_trajectory_generation/tip_frame_getter.h"
 
@@ -338,6 +343,73 @@ TEST_F(IntegrationTestCommandListManager, blendTwoSegments)
   pub.publish(display_trajectory);
 }
 
+/**
+ * @brief Tests the blending of motion commands with the maximal blend radius.
+ *
+ *  - Test Sequence:
+ *    1. Generate request with two trajectories and request the maximal blend radius.
+ *
+ *  - Expected Results:
+ *    1. blending is successful, result trajectory is not empty and faster than
+ *       the trajectory without blending.
+ */
+TEST_F(IntegrationTestCommandListManager, blendWithMaximalRadius)
+{
+  Sequence seq {data_loader_->getSequence("SimpleSequence")};
+  ASSERT_EQ(seq.size(), 2u);
+  seq.setAllBlendRadiiToZero();
+  RobotTrajCont res_no_blend {manager_->solve(scene_, pipeline_, seq.toRequest())};
+  ASSERT_EQ(res_no_blend.size(), 1u);
+
+  seq.setBlendRadius(0, pilz_msgs::MotionSequenceItem::BLEND_RADIUS_MAX);
+  RobotTrajCont res_vec {manager_->solve(scene_, pipeline_, seq.toRequest())};
+  ASSERT_EQ(res_vec.size(), 1u);
+  EXPECT_GT(res_vec.front()->getWayPointCount(), 0u);
+  EXPECT_TRUE(hasStrictlyIncreasingTime(res_vec.front())) << "Time steps not strictly positively increasing";
+  EXPECT_LT(res_vec.front()->getWayPointDurationFromStart(res_vec.front()->getWayPointCount()-1),
+            res_no_blend.front()->getWayPointDurationFromStart(res_no_blend.front()->getWayPointCount()-1));
+}
+
+/**
+ * @brief Tests the processing of a longer sequence (the solving time is measured by
+ * benchmark_command_list_manager).
+ *
+ *  - Test Sequence:
+ *    1. Solve request with 100 alternating PTP commands.
+ *
+ *  - Expected Results:
+ *    1. One trajectory is returned, which ends at the goal of the last command
+ *       and has strictly increasing time steps.
+ */
+TEST_F(IntegrationTestCommandListManager, TestLargeSequence)
+{
+  const size_t num_items {100};
+  PtpJoint ptp_1 {data_loader_->getPtpJoint("Ptp1")};
+  PtpJoint ptp_2 {data_loader_->getPtpJoint("Ptp2")};
+
+  pilz_msgs::MotionSequenceRequest req;
+  req.items.resize(num_items);
+  for (size_t i = 0; i < num_items; ++i)
+  {
+    req.items.at(i).req = (i % 2 == 0) ? ptp_1.toRequest() : ptp_2.toRequest();
+    if (i > 0)
+    {
+      // Only the first request is allowed to have a start state.
+      req.items.at(i).req.start_state = moveit_msgs::RobotState();
+    }
+    req.items.at(i).blend_radius = 0.;
+  }
+
+  RobotTrajCont res_vec {manager_->solve(scene_, pipeline_, req)};
+  ASSERT_EQ(1u, res_vec.size());
+  EXPECT_TRUE(hasStrictlyIncreasingTime(res_vec.front())) << "Time steps not strictly positively increasing";
+
+  const robot_state::RobotState goal_state {ptp_2.getGoalConfiguration().toRobotState()};
+  const moveit::core::JointModelGroup* group {robot_model_->getJointModelGroup(ptp_2.getPlanningGroup())};
+  EXPECT_LT(res_vec.front()->getLastWayPoint().distance(goal_state, group), 1e-6)
+      << "Trajectory does not end at the goal of the last command";
+}
+
 // ------------------
 // FAILURE cases
 // ------------------
@@ -376,6 +448,91 @@ TEST_F(IntegrationTestCommandListManager, firstGoalNotReachable)
   EXPECT_THROW(manager_->solve(scene_, pipeline_, seq.toRequest()), PlanningPipelineException);
 }
 
+/**
+ * @brief Checks that the allowed planning time of the sequence is honoured.
+ *
+ * Test Sequence:
+ *    1. Generate request with an allowed planning time which cannot be met.
+ *    2. Generate request with a sufficient allowed planning time.
+ *
+ * Expected Results:
+ *    1. Exception with error code TIMED_OUT is thrown.
+ *    2. Generation of trajectory is successful.
+ */
+TEST_F(IntegrationTestCommandListManager, TestAllowedPlanningTime)
+{
+  Sequence seq {data_loader_->getSequence("ComplexSequence")};
+  pilz_msgs::MotionSequenceRequest req {seq.toRequest()};
+
+  req.allowed_planning_time = 1e-6;
+  try
+  {
+    manager_->solve(scene_, pipeline_, req);
+    FAIL() << "Planning did not time out.";
+  }
+  catch (const MoveItErrorCodeException& ex)
+  {
+    EXPECT_EQ(moveit_msgs::MoveItErrorCodes::TIMED_OUT, ex.getErrorCode());
+  }
+
+  req.allowed_planning_time = 1000.;
+  RobotTrajCont res_vec {manager_->solve(scene_, pipeline_, req)};
+  EXPECT_FALSE(res_vec.empty());
+}
+
+/**
+ * @brief Checks that terminate() only stops the planning of its own manager.
+ *
+ * Test Sequence:
+ *    1. Start planning a very slow LIN command with two managers concurrently.
+ *    2. Cancel the token of the first manager and terminate it.
+ *    3. Cancel and terminate the second manager.
+ *
+ * Expected Results:
+ *    1. -
+ *    2. The first manager stops with the error code PREEMPTED, the second one keeps planning.
+ *    3. The second manager stops.
+ */
+TEST_F(IntegrationTestCommandListManager, TestTerminateOnlyOwnPlanning)
+{
+  LinCart lin {data_loader_->getLinCart("lin2")};
+  lin.setVelocityScale(0.0002);
+  lin.setAccelerationScale(0.0002);
+  Sequence seq;
+  seq.add(lin);
+  const pilz_msgs::MotionSequenceRequest req {seq.toRequest()};
+
+  pilz::CancellationToken token, other_token;
+  manager_->setCancellationToken(&token);
+  CommandListManager other_manager(ph_, robot_model_);
+  other_manager.setCancellationToken(&other_token);
+
+  auto solve = [&](CommandListManager& manager) { return manager.solve(scene_, pipeline_, req); };
+  std::future<RobotTrajCont> res {std::async(std::launch::async, solve, std::ref(*manager_))};
+  std::future<RobotTrajCont> other_res {std::async(std::launch::async, solve, std::ref(other_manager))};
+  ros::Duration(1.0).sleep();
+
+  token.cancel();
+  manager_->terminate();
+  ASSERT_EQ(std::future_status::ready, res.wait_for(std::chrono::seconds(10))) << "Planning was not stopped.";
+  try
+  {
+    res.get();
+    FAIL() << "Planning was not stopped.";
+  }
+  catch (const MoveItErrorCodeException& ex)
+  {
+    EXPECT_EQ(moveit_msgs::MoveItErrorCodes::PREEMPTED, ex.getErrorCode());
+  }
+  EXPECT_EQ(std::future_status::timeout, other_res.wait_for(std::chrono::seconds(0)))
+      << "Planning of the other manager was stopped.";
+
+  other_token.cancel();
+  other_manager.terminate();
+  ASSERT_EQ(std::future_status::ready, other_res.wait_for(std::chrono::seconds(10)));
+  EXPECT_THROW(other_res.get(), MoveItErrorCodeException);
+}
+
 /**
  * @brief Checks that exception is thrown if second goal has a start state.
  *
@@ -535,6 +692,278 @@ TEST_F(IntegrationTestCommandListManager, TestExecutionTime)
   EXPECT_GE(trajectory_time_n, trajectory_time_1 * multiplicator * 0.5);
 }
 
+/**
+ * @brief Tests that the parallel blending mode yields the same result as
+ * the sequential blending.
+ *
+ * Test Sequence:
+ *    1. Generate request with multiple blended trajectories.
+ *    2. Solve request with sequential and with parallel blending.
+ *
+ * Expected Results:
+ *    1. -
+ *    2. Both results have the same waypoints and durations.
+ */
+TEST_F(IntegrationTestCommandListManager, TestParallelBlending)
+{
+  Sequence seq {data_loader_->getSequence("ComplexSequence")};
+  ASSERT_GE(seq.size(), 3u);
+  pilz_msgs::MotionSequenceRequest req {seq.toRequest()};
+
+  RobotTrajCont res_seq_vec {manager_->solve(scene_, pipeline_, req)};
+
+  ph_.setParam("parallel_blending", true);
+  CommandListManager parallel_manager(ph_, robot_model_);
+  ph_.deleteParam("parallel_blending");
+  RobotTrajCont res_par_vec {parallel_manager.solve(scene_, pipeline_, req)};
+
+  ASSERT_EQ(res_seq_vec.size(), res_par_vec.size());
+  for (size_t i = 0; i < res_seq_vec.size(); ++i)
+  {
+    ASSERT_EQ(res_seq_vec.at(i)->getWayPointCount(), res_par_vec.at(i)->getWayPointCount());
+    for (size_t j = 0; j < res_seq_vec.at(i)->getWayPointCount(); ++j)
+    {
+      EXPECT_TRUE(pilz::isRobotStateEqual(res_seq_vec.at(i)->getWayPoint(j), res_par_vec.at(i)->getWayPoint(j),
+                                          res_seq_vec.at(i)->getGroupName(), 10e-6));
+      EXPECT_NEAR(res_seq_vec.at(i)->getWayPointDurationFromPrevious(j),
+                  res_par_vec.at(i)->getWayPointDurationFromPrevious(j), 10e-6);
+    }
+  }
+}
+
+/**
+ * @brief Tests that the speculative planning mode yields exactly the same result as
+ * the sequential planning.
+ *
+ * Test Sequence:
+ *    1. Generate request with multiple blended trajectories.
+ *    2. Solve request with sequential and with speculative planning.
+ *
+ * Expected Results:
+ *    1. -
+ *    2. Both results have identical waypoints and durations.
+ */
+TEST_F(IntegrationTestCommandListManager, TestSpeculativePlanning)
+{
+  Sequence seq {data_loader_->getSequence("ComplexSequence")};
+  ASSERT_GE(seq.size(), 3u);
+  pilz_msgs::MotionSequenceRequest req {seq.toRequest()};
+
+  RobotTrajCont res_seq_vec {manager_->solve(scene_, pipeline_, req)};
+
+  ph_.setParam("speculative_planning", true);
+  CommandListManager speculative_manager(ph_, robot_model_);
+  ph_.deleteParam("speculative_planning");
+  RobotTrajCont res_spec_vec {speculative_manager.solve(scene_, pipeline_, req)};
+
+  ASSERT_EQ(res_seq_vec.size(), res_spec_vec.size());
+  for (size_t i = 0; i < res_seq_vec.size(); ++i)
+  {
+    ASSERT_EQ(res_seq_vec.at(i)->getWayPointCount(), res_spec_vec.at(i)->getWayPointCount());
+    for (size_t j = 0; j < res_seq_vec.at(i)->getWayPointCount(); ++j)
+    {
+      EXPECT_TRUE(pilz::isRobotStateEqual(res_seq_vec.at(i)->getWayPoint(j), res_spec_vec.at(i)->getWayPoint(j),
+                                          res_seq_vec.at(i)->getGroupName(), 0.));
+      EXPECT_EQ(res_seq_vec.at(i)->getWayPointDurationFromPrevious(j),
+                res_spec_vec.at(i)->getWayPointDurationFromPrevious(j));
+    }
+  }
+}
+
+/**
+ * @brief Tests that consecutive blended PTP commands are merged into one trajectory
+ * if the parameter "merge_ptp_sequences" is set.
+ *
+ * Test Sequence:
+ *    1. Generate request with two blended PTP commands.
+ *    2. Solve request with and without merging.
+ *
+ * Expected Results:
+ *    1. -
+ *    2. Both results consist of one trajectory with the same start and goal.
+ *       All time steps of the merged trajectory are strictly positive.
+ */
+TEST_F(IntegrationTestCommandListManager, TestMergePtpSequence)
+{
+  Sequence seq {data_loader_->getSequence("PtpPtpSequence")};
+  ASSERT_GE(seq.size(), 2u);
+  ASSERT_GT(seq.getBlendRadius(0), 0.);
+  pilz_msgs::MotionSequenceRequest req {seq.toRequest()};
+
+  RobotTrajCont res_blend_vec {manager_->solve(scene_, pipeline_, req)};
+
+  ph_.setParam("merge_ptp_sequences", true);
+  CommandListManager merging_manager(ph_, robot_model_);
+  ph_.deleteParam("merge_ptp_sequences");
+  RobotTrajCont res_merge_vec {merging_manager.solve(scene_, pipeline_, req)};
+
+  ASSERT_EQ(1u, res_blend_vec.size());
+  ASSERT_EQ(1u, res_merge_vec.size());
+  EXPECT_TRUE(hasStrictlyIncreasingTime(res_merge_vec.front()));
+
+  const std::string& group_name {res_blend_vec.front()->getGroupName()};
+  Eigen::VectorXd blend_positions, merge_positions;
+  res_blend_vec.front()->getFirstWayPoint().copyJointGroupPositions(group_name, blend_positions);
+  res_merge_vec.front()->getFirstWayPoint().copyJointGroupPositions(group_name, merge_positions);
+  EXPECT_NEAR(0., (blend_positions - merge_positions).norm(), 10e-6);
+  res_blend_vec.front()->getLastWayPoint().copyJointGroupPositions(group_name, blend_positions);
+  res_merge_vec.front()->getLastWayPoint().copyJointGroupPositions(group_name, merge_positions);
+  EXPECT_NEAR(0., (blend_positions - merge_positions).norm(), 10e-6);
+}
+
+/**
+ * @brief Tests that the final trajectories of a repeated sequence are taken
+ * from the sequence cache.
+ *
+ * Test Sequence:
+ *    1. Enable the sequence cache and solve request.
+ *    2. Solve the same request again and modify the result.
+ *    3. Solve the same request again.
+ *    4. Solve request with a changed start state.
+ *
+ * Expected Results:
+ *    1. Cache miss.
+ *    2. Cache hit, copies of the trajectories are returned.
+ *    3. Cache hit, the modification of the previous result does not affect the cache.
+ *    4. Cache miss.
+ */
+TEST_F(IntegrationTestCommandListManager, TestSequenceCache)
+{
+  Sequence seq {data_loader_->getSequence("ComplexSequence")};
+  pilz_msgs::MotionSequenceRequest req {seq.toRequest()};
+
+  ph_.setParam("sequence_cache_size", 2);
+  CommandListManager manager(ph_, robot_model_);
+  ph_.deleteParam("sequence_cache_size");
+
+  RobotTrajCont res1_vec {manager.solve(scene_, pipeline_, req)};
+  EXPECT_EQ(0u, manager.getSequenceCacheStatistics().hits);
+  EXPECT_EQ(1u, manager.getSequenceCacheStatistics().misses);
+
+  RobotTrajCont res2_vec {manager.solve(scene_, pipeline_, req)};
+  EXPECT_EQ(1u, manager.getSequenceCacheStatistics().hits);
+  ASSERT_EQ(res1_vec.size(), res2_vec.size());
+  for (size_t i = 0; i < res1_vec.size(); ++i)
+  {
+    EXPECT_NE(res1_vec.at(i), res2_vec.at(i));
+    ASSERT_EQ(res1_vec.at(i)->getWayPointCount(), res2_vec.at(i)->getWayPointCount());
+    EXPECT_NE(&res1_vec.at(i)->getLastWayPoint(), &res2_vec.at(i)->getLastWayPoint());
+    EXPECT_TRUE(res1_vec.at(i)->getLastWayPoint().distance(res2_vec.at(i)->getLastWayPoint()) < 1e-10);
+  }
+
+  const double expected_position {res1_vec.front()->getFirstWayPoint().getVariablePosition(0)};
+  res2_vec.front()->getFirstWayPointPtr()->setVariablePosition(0, expected_position + 1.);
+  RobotTrajCont res3_vec {manager.solve(scene_, pipeline_, req)};
+  EXPECT_EQ(2u, manager.getSequenceCacheStatistics().hits);
+  EXPECT_DOUBLE_EQ(expected_position, res3_vec.front()->getFirstWayPoint().getVariablePosition(0));
+
+  ASSERT_FALSE(req.items.front().req.start_state.joint_state.position.empty());
+  req.items.front().req.start_state.joint_state.position.front() += 0.01;
+  manager.solve(scene_, pipeline_, req);
+  EXPECT_EQ(2u, manager.getSequenceCacheStatistics().hits);
+  EXPECT_EQ(2u, manager.getSequenceCacheStatistics().misses);
+}
+
+/**
+ * @brief Tests that unchanged sequence items are not planned again, if enabled.
+ *
+ * Test Sequence:
+ *    1. Enable the reuse of sequence items and solve request with multiple trajectories.
+ *    2. Change the last item of the request and solve it again.
+ *
+ * Expected Results:
+ *    1. -
+ *    2. The result starts with the same (shared) waypoints, the last item
+ *       is planned again, so the result differs at the end.
+ */
+TEST_F(IntegrationTestCommandListManager, TestResultCaching)
+{
+  Sequence seq {data_loader_->getSequence("ComplexSequence")};
+  ASSERT_GE(seq.size(), 3u);
+  seq.setAllBlendRadiiToZero();
+  pilz_msgs::MotionSequenceRequest req {seq.toRequest()};
+
+  ph_.setParam("reuse_sequence_items", true);
+  CommandListManager manager(ph_, robot_model_);
+  ph_.deleteParam("reuse_sequence_items");
+
+  RobotTrajCont res1_vec {manager.solve(scene_, pipeline_, req)};
+  ASSERT_EQ(res1_vec.size(), 1u);
+
+  req.items.back().req.max_velocity_scaling_factor *= 0.5;
+  RobotTrajCont res2_vec {manager.solve(scene_, pipeline_, req)};
+  ASSERT_EQ(res2_vec.size(), 1u);
+
+  EXPECT_EQ(res1_vec.front()->getWayPointPtr(1), res2_vec.front()->getWayPointPtr(1));
+  EXPECT_NE(res1_vec.front()->getLastWayPointPtr(), res2_vec.front()->getLastWayPointPtr());
+  EXPECT_GT(res2_vec.front()->getWayPointCount(), res1_vec.front()->getWayPointCount());
+}
+
+/**
+ * @brief Tests that the sequence items are planned again by default.
+ *
+ * Test Sequence:
+ *    1. Solve request with multiple trajectories twice.
+ *
+ * Expected Results:
+ *    1. The results are equal, but do not share their waypoints.
+ */
+TEST_F(IntegrationTestCommandListManager, TestNoResultCachingByDefault)
+{
+  Sequence seq {data_loader_->getSequence("ComplexSequence")};
+  seq.setAllBlendRadiiToZero();
+  pilz_msgs::MotionSequenceRequest req {seq.toRequest()};
+
+  RobotTrajCont res1_vec {manager_->solve(scene_, pipeline_, req)};
+  RobotTrajCont res2_vec {manager_->solve(scene_, pipeline_, req)};
+  ASSERT_EQ(res1_vec.size(), 1u);
+  ASSERT_EQ(res2_vec.size(), 1u);
+
+  EXPECT_NE(res1_vec.front()->getWayPointPtr(1), res2_vec.front()->getWayPointPtr(1));
+  EXPECT_EQ(res1_vec.front()->getWayPointCount(), res2_vec.front()->getWayPointCount());
+}
+
+/**
+ * @brief Tests that an item without start state is planned again, if the current state
+ * of the planning scene changed.
+ *
+ * Test Sequence:
+ *    1. Enable the reuse of sequence items, solve request whose first item has no start state.
+ *    2. Change the current state of the planning scene and solve the request again.
+ *
+ * Expected Results:
+ *    1. The result starts at the current state.
+ *    2. The result starts at the changed current state.
+ */
+TEST_F(IntegrationTestCommandListManager, TestResultCachingCurrentStateChange)
+{
+  Sequence seq {data_loader_->getSequence("ComplexSequence")};
+  seq.erase(1, seq.size());
+  pilz_msgs::MotionSequenceRequest req {seq.toRequest()};
+
+  robot_state::RobotState current_state(robot_model_);
+  current_state.setToDefaultValues();
+  moveit::core::robotStateMsgToRobotState(req.items.front().req.start_state, current_state);
+  scene_->setCurrentState(current_state);
+  req.items.front().req.start_state = moveit_msgs::RobotState();
+
+  ph_.setParam("reuse_sequence_items", true);
+  CommandListManager manager(ph_, robot_model_);
+  ph_.deleteParam("reuse_sequence_items");
+
+  RobotTrajCont res1_vec {manager.solve(scene_, pipeline_, req)};
+  ASSERT_EQ(res1_vec.size(), 1u);
+
+  const std::string joint_name {res1_vec.front()->getGroup()->getActiveJointModelNames().front()};
+  current_state.setVariablePosition(joint_name, current_state.getVariablePosition(joint_name) + 0.01);
+  scene_->setCurrentState(current_state);
+
+  RobotTrajCont res2_vec {manager.solve(scene_, pipeline_, req)};
+  ASSERT_EQ(res2_vec.size(), 1u);
+  EXPECT_NEAR(current_state.getVariablePosition(joint_name),
+              res2_vec.front()->getFirstWayPoint().getVariablePosition(joint_name), 1e-6);
+}
+
 /**
  * @brief Tests if it possible to send requests which contain more than
  * one group.
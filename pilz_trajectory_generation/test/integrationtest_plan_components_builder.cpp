@@ -17,6 +17,8 @@
 
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -76,6 +78,12 @@ TEST_F(IntegrationTestPlanComponentBuilder, TestExceptionErrorCodeMapping)
 
   std::shared_ptr<BlendingFailedException> bf_ex {new BlendingFailedException("")};
   EXPECT_EQ(bf_ex->getErrorCode(), moveit_msgs::MoveItErrorCodes::FAILURE);
+
+  std::shared_ptr<PlanningCancelledException> pc_ex {new PlanningCancelledException("")};
+  EXPECT_EQ(pc_ex->getErrorCode(), moveit_msgs::MoveItErrorCodes::PREEMPTED);
+
+  std::shared_ptr<PlanningTimedOutException> pto_ex {new PlanningTimedOutException("")};
+  EXPECT_EQ(pto_ex->getErrorCode(), moveit_msgs::MoveItErrorCodes::TIMED_OUT);
 }
 
 /**
@@ -105,6 +113,68 @@ TEST_F(IntegrationTestPlanComponentBuilder, TestNoBlenderSet)
   EXPECT_THROW(builder.append(traj, 1.0), NoBlenderSetException);
 }
 
+/**
+ * @brief Blender which fails every blend with the specified error code.
+ */
+class FailingBlender : public TrajectoryBlender
+{
+public:
+  FailingBlender(const int32_t error_code)
+    : TrajectoryBlender(pilz::LimitsContainer())
+    , error_code_(error_code)
+  {
+  }
+
+  bool blend(const pilz::TrajectoryBlendRequest& /*req*/, pilz::TrajectoryBlendResponse& res) override
+  {
+    res.error_code.val = error_code_;
+    return false;
+  }
+
+private:
+  const int32_t error_code_;
+};
+
+/**
+ * @brief Checks that a cancelled or timed out blend in parallel blending mode
+ * is not treated as failed blend, but stops the build.
+ *
+ * Test Sequence:
+ *    1. Build three blended trajectories with a blender which reports PREEMPTED.
+ *    2. Build three blended trajectories with a blender which reports TIMED_OUT.
+ *
+ * Expected Results:
+ *    1. build() throws a PlanningCancelledException.
+ *    2. build() throws a PlanningTimedOutException.
+ */
+TEST_F(IntegrationTestPlanComponentBuilder, TestParallelBlendingRethrowsCancellation)
+{
+  const std::vector<std::pair<int32_t, bool> > cases {
+    {moveit_msgs::MoveItErrorCodes::PREEMPTED, true}, {moveit_msgs::MoveItErrorCodes::TIMED_OUT, false}};
+  for (const auto& test_case : cases)
+  {
+    PlanComponentsBuilder builder;
+    builder.setModel(robot_model_);
+    builder.setBlender(std::unique_ptr<TrajectoryBlender>(new FailingBlender(test_case.first)));
+    builder.setParallelBlending(true);
+    builder.setMaxBlendingThreads(2);
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+      builder.append(std::make_shared<robot_trajectory::RobotTrajectory>(robot_model_, planning_group_),
+                     i > 0 ? 0.1 : 0.);
+    }
+
+    if (test_case.second)
+    {
+      EXPECT_THROW(builder.build(), PlanningCancelledException);
+    }
+    else
+    {
+      EXPECT_THROW(builder.build(), PlanningTimedOutException);
+    }
+  }
+}
+
 int main(int argc, char **argv)
 {
   ros::init(argc, argv, "integrationtest_plan_components_builder");
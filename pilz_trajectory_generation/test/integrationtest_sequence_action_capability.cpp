@@ -57,6 +57,7 @@ const std::string GOAL_SUCCEEDED_EVENT = "GOAL_SUCCEEDED";
 const std::string SERVER_IDLE_EVENT = "SERVER_IDLE";
 
 const std::string TEST_DATA_FILE_NAME("testdata_file_name");
+const std::string SEQUENCE_LOOKAHEAD("/move_group/sequence_lookahead");
 const std::string GROUP_NAME("group_name");
 
 using namespace pilz_industrial_motion_testutils;
@@ -408,6 +409,41 @@ TEST_F(IntegrationTestSequenceAction, TestCancellingOfGoal)
   EXPECT_EQ(res->error_code.val, moveit_msgs::MoveItErrorCodes::PREEMPTED) << "Error code should be preempted.";
 }
 
+/**
+ * @brief Tests that a goal can be cancelled while a command is planned.
+ *
+ * Test Sequence:
+ *    1. Send goal for planning only, containing a LIN command whose planning takes long
+ *       (very small velocity and acceleration scaling).
+ *    2. Cancel goal while the command is planned.
+ *
+ * Expected Results:
+ *    1. Goal is sent to the action server.
+ *    2. Goal is cancelled. The planning of the command stops before the result time out.
+ */
+TEST_F(IntegrationTestSequenceAction, TestCancellingOfGoalDuringPlanning)
+{
+  LinCart lin {data_loader_->getLinCart("lin2")};
+  lin.setVelocityScale(0.0002);
+  lin.setAccelerationScale(0.0002);
+  Sequence seq;
+  seq.add(lin);
+
+  pilz_msgs::MoveGroupSequenceGoal seq_goal;
+  seq_goal.planning_options.plan_only = true;
+  seq_goal.request = seq.toRequest();
+
+  ac_.sendGoal(seq_goal);
+  ros::Duration(TIME_BEFORE_CANCEL_GOAL).sleep();
+
+  ac_.cancelGoal();
+  ASSERT_TRUE(ac_.waitForResult(ros::Duration(WAIT_FOR_RESULT_TIME_OUT))) << "Planning was not stopped.";
+
+  pilz_msgs::MoveGroupSequenceResultConstPtr res = ac_.getResult();
+  EXPECT_EQ(res->error_code.val, moveit_msgs::MoveItErrorCodes::PREEMPTED) << "Error code should be preempted.";
+  EXPECT_TRUE(res->planned_trajectory.empty());
+}
+
 /**
  * @brief Tests the "only planning" flag.
  *
@@ -628,6 +664,107 @@ TEST_F(IntegrationTestSequenceAction, TestComplexSequenceWithBlending)
   EXPECT_FALSE(res->trajectory_start.empty()) << "No start states returned";
 }
 
+/**
+ * @brief Tests the streamed execution of a sequence, consisting of
+ * multiple segments.
+ *
+ * Test Sequence:
+ *    1. Activate the streamed execution, create sequence goal without
+ *       blending and send it via ActionClient.
+ *    2. Wait for successful completion of command.
+ *
+ * Expected Results:
+ *    1. -
+ *    2. ActionClient reports successful completion of command, the result
+ *       contains one trajectory per segment.
+ */
+TEST_F(IntegrationTestSequenceAction, TestStreamedExecution)
+{
+  Sequence seq {data_loader_->getSequence("ComplexSequence")};
+  seq.setAllBlendRadiiToZero();
+
+  pilz_msgs::MoveGroupSequenceGoal seq_goal;
+  seq_goal.request = seq.toRequest();
+
+  ph_.setParam(SEQUENCE_LOOKAHEAD, 1);
+  ac_.sendGoalAndWait(seq_goal);
+  ph_.deleteParam(SEQUENCE_LOOKAHEAD);
+
+  pilz_msgs::MoveGroupSequenceResultConstPtr res = ac_.getResult();
+  EXPECT_EQ(res->error_code.val, moveit_msgs::MoveItErrorCodes::SUCCESS);
+  EXPECT_EQ(seq.size(), res->planned_trajectory.size());
+  EXPECT_EQ(seq.size(), res->trajectory_start.size());
+}
+
+/**
+ * @brief Tests the streamed execution of a sequence containing an invalid
+ * command.
+ *
+ * Test Sequence:
+ *    1. Activate the streamed execution, create sequence goal without
+ *       blending, containing an invalid command, and send it via ActionClient.
+ *    2. Evaluate the result.
+ *
+ * Expected Results:
+ *    1. -
+ *    2. Error code indicates an error, the result contains the segments
+ *       executed before the invalid command.
+ */
+TEST_F(IntegrationTestSequenceAction, TestStreamedExecutionInvalidCmd)
+{
+  Sequence seq {data_loader_->getSequence("ComplexSequence")};
+  seq.setAllBlendRadiiToZero();
+  // Erase certain command to invalid command following the command in sequence.
+  seq.erase(3, 4);
+
+  pilz_msgs::MoveGroupSequenceGoal seq_goal;
+  seq_goal.request = seq.toRequest();
+
+  ph_.setParam(SEQUENCE_LOOKAHEAD, 1);
+  ac_.sendGoalAndWait(seq_goal);
+  ph_.deleteParam(SEQUENCE_LOOKAHEAD);
+
+  pilz_msgs::MoveGroupSequenceResultConstPtr res = ac_.getResult();
+  EXPECT_NE(res->error_code.val, moveit_msgs::MoveItErrorCodes::SUCCESS) << "Incorrect error code.";
+  EXPECT_FALSE(res->planned_trajectory.empty());
+  EXPECT_LT(res->planned_trajectory.size(), seq.size());
+}
+
+/**
+ * @brief Tests that the commands planned before an invalid command are
+ * returned if a partial result is requested.
+ *
+ * Test Sequence:
+ *    1. Create sequence goal for planning only, containing an invalid command
+ *       and requesting a partial result, and send it via ActionClient.
+ *    2. Evaluate the result.
+ *
+ * Expected Results:
+ *    1. -
+ *    2. Error code indicates an error, the result contains the trajectories
+ *       of the commands preceding the invalid command.
+ */
+TEST_F(IntegrationTestSequenceAction, TestPartialResult)
+{
+  Sequence seq {data_loader_->getSequence("ComplexSequence")};
+  seq.setAllBlendRadiiToZero();
+  // Erase certain command to invalid command following the command in sequence.
+  seq.erase(3, 4);
+
+  pilz_msgs::MoveGroupSequenceGoal seq_goal;
+  seq_goal.request = seq.toRequest();
+  seq_goal.planning_options.plan_only = true;
+  seq_goal.return_partial_result = true;
+
+  ac_.sendGoalAndWait(seq_goal);
+
+  pilz_msgs::MoveGroupSequenceResultConstPtr res = ac_.getResult();
+  EXPECT_NE(res->error_code.val, moveit_msgs::MoveItErrorCodes::SUCCESS) << "Incorrect error code.";
+  EXPECT_FALSE(res->planned_trajectory.empty());
+  EXPECT_LT(res->planned_trajectory.size(), seq.size());
+  EXPECT_EQ(res->planned_trajectory.size(), res->trajectory_start.size());
+}
+
 int main(int argc, char **argv)
 {
   ros::init(argc, argv, "integrationtest_sequence_action_capability");
@@ -36,6 +36,7 @@
 #include <pilz_industrial_motion_testutils/sequence.h>
 
 #include "pilz_msgs/GetMotionSequence.h"
+#include "pilz_msgs/GetMotionSequenceBatch.h"
 #include "pilz_msgs/MotionSequenceRequest.h"
 #include "pilz_trajectory_generation/capability_names.h"
 
@@ -388,6 +389,52 @@ TEST_F(IntegrationTestSequenceService, TestComplexSequenceWithBlending)
   EXPECT_GT(srv.response.planned_trajectory.front().joint_trajectory.points.size(), 0u) << "Trajectory should contain points.";
 }
 
+/**
+ * @brief Tests the planning of a batch of independent sequences.
+ *
+ * Test Sequence:
+ *    1. Generate batch request with valid sequences and an invalid sequence
+ *       (negative blend radius) + call batch service.
+ *    2. Evaluate the result.
+ *
+ * Expected Results:
+ *    1. Response is received.
+ *    2. One response per sequence in the order of the requests, only the
+ *       invalid sequence fails.
+ */
+TEST_F(IntegrationTestSequenceService, TestBatchPlanning)
+{
+  Sequence seq {data_loader_->getSequence("ComplexSequence")};
+  pilz_msgs::MotionSequenceRequest valid_req {seq.toRequest()};
+  seq.setBlendRadius(0, -1.0);
+  pilz_msgs::MotionSequenceRequest invalid_req {seq.toRequest()};
+
+  pilz_msgs::GetMotionSequenceBatch srv;
+  srv.request.sequences = {valid_req, invalid_req, valid_req, valid_req};
+
+  ASSERT_TRUE(ros::service::waitForService(pilz_trajectory_generation::SEQUENCE_BATCH_SERVICE_NAME, ros::Duration(10)));
+  ros::NodeHandle nh;
+  ros::ServiceClient batch_client {
+    nh.serviceClient<pilz_msgs::GetMotionSequenceBatch>(pilz_trajectory_generation::SEQUENCE_BATCH_SERVICE_NAME)};
+  ASSERT_TRUE(batch_client.call(srv));
+
+  ASSERT_EQ(srv.request.sequences.size(), srv.response.responses.size());
+  for (size_t i = 0; i < srv.response.responses.size(); ++i)
+  {
+    const pilz_msgs::MotionSequenceResponse& res {srv.response.responses.at(i)};
+    if (i == 1)
+    {
+      EXPECT_EQ(moveit_msgs::MoveItErrorCodes::INVALID_MOTION_PLAN, res.error_code.val);
+      EXPECT_TRUE(res.planned_trajectory.empty());
+      continue;
+    }
+    EXPECT_EQ(moveit_msgs::MoveItErrorCodes::SUCCESS, res.error_code.val) << "Incorrect error code.";
+    ASSERT_EQ(res.planned_trajectory.size(), 1u);
+    EXPECT_EQ(res.planned_trajectory.front().joint_trajectory.points.size(),
+              srv.response.responses.front().planned_trajectory.front().joint_trajectory.points.size());
+  }
+}
+
 int main(int argc, char **argv)
 {
   ros::init(argc, argv, "integrationtest_sequence_service_capability");
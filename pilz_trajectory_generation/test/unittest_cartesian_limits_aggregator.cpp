@@ -18,9 +18,11 @@
 #include <gtest/gtest.h>
 
 #include <ros/ros.h>
+#include <moveit/robot_model_loader/robot_model_loader.h>
 
 #include "pilz_trajectory_generation/cartesian_limit.h"
 #include "pilz_trajectory_generation/cartesian_limits_aggregator.h"
+#include "pilz_trajectory_generation/limits_aggregator.h"
 
 /**
  * @brief Unittest of the CartesianLimitsAggregator class
@@ -65,6 +67,30 @@ TEST_F(CartesianLimitsAggregator, AllValues)
   EXPECT_EQ(limit.getMaxRotationalVelocity(), 4);
 }
 
+/**
+ * @brief Check that the shared limits of the LimitsAggregator only change on a reload
+ * after the limits on the parameter server changed
+ */
+TEST_F(CartesianLimitsAggregator, ReloadSharedLimits)
+{
+  ros::NodeHandle nh("~/shared");
+  robot_model_loader::RobotModelLoader model_loader("robot_description");
+  const moveit::core::RobotModelConstPtr model {model_loader.getModel()};
+  ASSERT_TRUE(model) << "There is no robot model!";
+
+  nh.setParam("cartesian_limits/max_trans_vel", 1.);
+  EXPECT_EQ(1., pilz::LimitsAggregator::getAggregatedLimits(nh, model)->getCartesianLimits().getMaxTranslationalVelocity());
+
+  const pilz::LimitsContainerConstPtr limits {pilz::LimitsAggregator::getAggregatedLimits(nh, model)};
+  nh.setParam("cartesian_limits/max_trans_vel", 2.);
+  EXPECT_EQ(limits.get(), pilz::LimitsAggregator::getAggregatedLimits(nh, model).get());
+
+  const pilz::LimitsContainerConstPtr reloaded_limits {pilz::LimitsAggregator::reloadAggregatedLimits(nh, model)};
+  EXPECT_EQ(2., reloaded_limits->getCartesianLimits().getMaxTranslationalVelocity());
+  EXPECT_EQ(1., limits->getCartesianLimits().getMaxTranslationalVelocity()) << "Limits in use were changed";
+  EXPECT_EQ(reloaded_limits.get(), pilz::LimitsAggregator::getAggregatedLimits(nh, model).get());
+}
+
 
 int main(int argc, char **argv)
 {
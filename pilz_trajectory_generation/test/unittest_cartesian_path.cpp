@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2018 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <eigen_conversions/eigen_kdl.h>
+#include <kdl/path_circle.hpp>
+#include <kdl/path_line.hpp>
+#include <kdl/rotational_interpolation_sa.hpp>
+#include <kdl/utilities/error.h>
+
+#include "pilz_trajectory_generation/cartesian_path.h"
+
+using namespace pilz;
+
+static constexpr double EPSILON {1e-9};
+static constexpr double EQRADIUS {0.5};
+static constexpr std::size_t NUM_SAMPLES {50};
+
+class CartesianPathTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    start_pose_ = Eigen::Translation3d(0.3, -0.2, 0.5)
+        * Eigen::AngleAxisd(0.4, Eigen::Vector3d(1., 2., 3.).normalized());
+    goal_pose_ = Eigen::Translation3d(0.1, 0.4, 0.6)
+        * Eigen::AngleAxisd(-0.9, Eigen::Vector3d(0., 1., -1.).normalized());
+  }
+
+  //! Checks that the poses of the path match the poses of the KDL path at equally spaced samples.
+  void expectEqualPoses(const CartesianPath& path, KDL::Path& kdl_path)
+  {
+    ASSERT_NEAR(kdl_path.PathLength(), path.getLength(), EPSILON);
+
+    std::vector<double> path_params;
+    for(std::size_t i = 0; i <= NUM_SAMPLES; ++i)
+    {
+      path_params.push_back(path.getLength() * static_cast<double>(i) / NUM_SAMPLES);
+    }
+
+    PoseBuffer poses;
+    path.getPoses(path_params, poses);
+    ASSERT_EQ(path_params.size(), poses.size());
+
+    for(std::size_t i = 0; i < path_params.size(); ++i)
+    {
+      Eigen::Isometry3d kdl_pose;
+      tf::transformKDLToEigen(kdl_path.Pos(path_params.at(i)), kdl_pose);
+      EXPECT_TRUE(kdl_pose.isApprox(poses.at(i), EPSILON)) << "Poses differ at path parameter " << path_params.at(i);
+      EXPECT_TRUE(poses.at(i).isApprox(path.getPose(path_params.at(i)), EPSILON));
+    }
+  }
+
+protected:
+  Eigen::Isometry3d start_pose_;
+  Eigen::Isometry3d goal_pose_;
+};
+
+/**
+ * @brief Checks that the line matches KDL::Path_Line with single axis rotational interpolation.
+ */
+TEST_F(CartesianPathTest, LineMatchesKdl)
+{
+  KDL::Frame kdl_start_pose, kdl_goal_pose;
+  tf::transformEigenToKDL(start_pose_, kdl_start_pose);
+  tf::transformEigenToKDL(goal_pose_, kdl_goal_pose);
+  KDL::Path_Line kdl_path(kdl_start_pose, kdl_goal_pose, new KDL::RotationalInterpolation_SingleAxis(), EQRADIUS);
+
+  expectEqualPoses(CartesianPathLine(start_pose_, goal_pose_, EQRADIUS), kdl_path);
+}
+
+/**
+ * @brief Checks that the rotation determines the path length of a line if it is slower than the translation.
+ */
+TEST_F(CartesianPathTest, LineDominatedByRotation)
+{
+  goal_pose_.translation() = start_pose_.translation() + Eigen::Vector3d(0., 0., 0.01);
+
+  KDL::Frame kdl_start_pose, kdl_goal_pose;
+  tf::transformEigenToKDL(start_pose_, kdl_start_pose);
+  tf::transformEigenToKDL(goal_pose_, kdl_goal_pose);
+  KDL::Path_Line kdl_path(kdl_start_pose, kdl_goal_pose, new KDL::RotationalInterpolation_SingleAxis(), EQRADIUS);
+
+  CartesianPathLine path(start_pose_, goal_pose_, EQRADIUS);
+  const double rotation_angle {Eigen::AngleAxisd(start_pose_.linear().transpose() * goal_pose_.linear()).angle()};
+  EXPECT_NEAR(rotation_angle * EQRADIUS, path.getLength(), EPSILON);
+  expectEqualPoses(path, kdl_path);
+}
+
+/**
+ * @brief Checks that a line without motion has length zero and stays at the start pose.
+ */
+TEST_F(CartesianPathTest, LineWithoutMotion)
+{
+  CartesianPathLine path(start_pose_, start_pose_, EQRADIUS);
+  EXPECT_DOUBLE_EQ(0., path.getLength());
+  EXPECT_TRUE(start_pose_.isApprox(path.getPose(0.), EPSILON));
+  EXPECT_TRUE(start_pose_.isApprox(path.getPose(1e-6), EPSILON));
+}
+
+/**
+ * @brief Checks that the circle matches KDL::Path_Circle with single axis rotational interpolation.
+ */
+TEST_F(CartesianPathTest, CircleMatchesKdl)
+{
+  const Eigen::Vector3d center_point {0.2, 0.1, 0.5};
+  const Eigen::Vector3d aux_point {0.1, 0.3, 0.7};
+  const double alpha {2.5};
+
+  KDL::Frame kdl_start_pose, kdl_goal_pose;
+  tf::transformEigenToKDL(start_pose_, kdl_start_pose);
+  tf::transformEigenToKDL(goal_pose_, kdl_goal_pose);
+  KDL::Vector kdl_center_point, kdl_aux_point;
+  tf::vectorEigenToKDL(center_point, kdl_center_point);
+  tf::vectorEigenToKDL(aux_point, kdl_aux_point);
+  KDL::Path_Circle kdl_path(kdl_start_pose, kdl_center_point, kdl_aux_point, kdl_goal_pose.M, alpha,
+                            new KDL::RotationalInterpolation_SingleAxis(), EQRADIUS);
+
+  CartesianPathCircle path(start_pose_, center_point, aux_point, Eigen::Quaterniond(goal_pose_.linear()),
+                           alpha, EQRADIUS, 1e-5);
+  expectEqualPoses(path, kdl_path);
+}
+
+/**
+ * @brief Checks that degenerated circles are rejected.
+ */
+TEST_F(CartesianPathTest, DegeneratedCircles)
+{
+  const Eigen::Quaterniond goal_orientation {goal_pose_.linear()};
+
+  EXPECT_THROW(CartesianPathCircle(start_pose_, start_pose_.translation(), Eigen::Vector3d(1., 1., 1.),
+                                   goal_orientation, 1., EQRADIUS, 1e-5),
+               KDL::Error_MotionPlanning_Circle_ToSmall);
+
+  const Eigen::Vector3d center_point {start_pose_.translation() + Eigen::Vector3d(0.1, 0., 0.)};
+  EXPECT_THROW(CartesianPathCircle(start_pose_, center_point, center_point + Eigen::Vector3d(0.1, 0., 0.),
+                                   goal_orientation, 1., EQRADIUS, 1e-5),
+               KDL::Error_MotionPlanning_Circle_No_Plane);
+}
+
+/**
+ * @brief Checks that the spline passes through all poses in the given order.
+ */
+TEST_F(CartesianPathTest, SplinePassesThroughPoses)
+{
+  PoseBuffer poses;
+  poses.push_back(start_pose_);
+  poses.push_back(Eigen::Translation3d(0.4, 0.1, 0.6) * Eigen::AngleAxisd(0.2, Eigen::Vector3d::UnitZ()));
+  poses.push_back(Eigen::Translation3d(0.2, 0.3, 0.4) * Eigen::AngleAxisd(-0.3, Eigen::Vector3d::UnitY()));
+  poses.push_back(goal_pose_);
+
+  CartesianPathSpline path(poses, EQRADIUS, 1e-5);
+  EXPECT_GT(path.getMaxCurvature(), 0.);
+
+  std::vector<double> path_params;
+  for(std::size_t i = 0; i <= NUM_SAMPLES; ++i)
+  {
+    path_params.push_back(path.getLength() * static_cast<double>(i) / NUM_SAMPLES);
+  }
+  PoseBuffer samples;
+  path.getPoses(path_params, samples);
+  ASSERT_EQ(path_params.size(), samples.size());
+  EXPECT_TRUE(start_pose_.isApprox(samples.front(), EPSILON));
+  EXPECT_TRUE(goal_pose_.isApprox(samples.back(), EPSILON));
+
+  // the path parameter increases monotonically from pose to pose
+  double last_path_param {0.};
+  for(std::size_t i = 1; i + 1 < poses.size(); ++i)
+  {
+    double closest_path_param {0.};
+    double closest_distance {std::numeric_limits<double>::max()};
+    for(std::size_t j = 0; j <= 10 * NUM_SAMPLES; ++j)
+    {
+      const double s {path.getLength() * static_cast<double>(j) / (10 * NUM_SAMPLES)};
+      const double distance {(path.getPose(s).translation() - poses.at(i).translation()).norm()};
+      if(distance < closest_distance)
+      {
+        closest_distance = distance;
+        closest_path_param = s;
+      }
+    }
+    EXPECT_LT(closest_distance, 0.01) << "Spline does not pass through pose " << i;
+    EXPECT_GT(closest_path_param, last_path_param);
+    last_path_param = closest_path_param;
+  }
+}
+
+/**
+ * @brief Checks that a spline through two poses equals the line between them.
+ */
+TEST_F(CartesianPathTest, SplineOfTwoPosesIsLine)
+{
+  PoseBuffer poses;
+  poses.push_back(start_pose_);
+  poses.push_back(goal_pose_);
+
+  CartesianPathSpline path(poses, EQRADIUS, 1e-5);
+  CartesianPathLine line(start_pose_, goal_pose_, EQRADIUS);
+  ASSERT_NEAR(line.getLength(), path.getLength(), EPSILON);
+  EXPECT_NEAR(0., path.getMaxCurvature(), EPSILON);
+
+  for(std::size_t i = 0; i <= NUM_SAMPLES; ++i)
+  {
+    const double s {path.getLength() * static_cast<double>(i) / NUM_SAMPLES};
+    EXPECT_TRUE(line.getPose(s).isApprox(path.getPose(s), 1e-6)) << "Poses differ at path parameter " << s;
+  }
+}
+
+/**
+ * @brief Checks that splines through less than two poses or through too close poses are rejected.
+ */
+TEST_F(CartesianPathTest, DegeneratedSplines)
+{
+  PoseBuffer poses;
+  poses.push_back(start_pose_);
+  EXPECT_THROW(CartesianPathSpline(poses, EQRADIUS, 1e-5), std::invalid_argument);
+
+  poses.push_back(Eigen::Translation3d(1e-6, 0., 0.) * start_pose_);
+  poses.push_back(goal_pose_);
+  EXPECT_THROW(CartesianPathSpline(poses, EQRADIUS, 1e-5), std::invalid_argument);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -18,14 +18,26 @@
 #include <gtest/gtest.h>
 
 #include <iostream>
+#include <thread>
 
 #include <moveit/robot_model_loader/robot_model_loader.h>
 #include <moveit/robot_model/robot_model.h>
 
+#include <moveit/kinematic_constraints/utils.h>
+#include <moveit/planning_scene/planning_scene.h>
+#include <moveit/robot_state/conversions.h>
+
+#include "pilz_trajectory_generation/limits_aggregator.h"
 #include "pilz_trajectory_generation/pilz_command_planner.h"
 
 const std::string PARAM_MODEL_NO_GRIPPER_NAME {"robot_description"};
 const std::string PARAM_MODEL_WITH_GRIPPER_NAME {"robot_description_pg70"};
+const std::string PLANNING_GROUP {"manipulator"};
+const std::string TARGET_LINK {"prbt_tcp"};
+const std::string PARAM_NAMESPACE_LIMITS {"robot_description_planning"};
+
+static constexpr std::size_t NUM_PLANNING_THREADS {6};
+static constexpr std::size_t NUM_REQUESTS_PER_THREAD {10};
 
 class CommandPlannerTest : public testing::TestWithParam<std::string>
 {
@@ -82,6 +94,69 @@ protected:
     planner_plugin_loader_->unloadLibraryForClass(planner_plugin_name_);
   }
 
+  /**
+   * @brief Creates a request from the specified start to the specified goal positions of the planning group.
+   */
+  planning_interface::MotionPlanRequest createRequest(const std::string& planner_id,
+                                                      const std::vector<double>& start_positions,
+                                                      const std::vector<double>& goal_positions) const
+  {
+    const moveit::core::JointModelGroup* group {robot_model_->getJointModelGroup(PLANNING_GROUP)};
+    robot_state::RobotState state(robot_model_);
+    state.setToDefaultValues();
+
+    planning_interface::MotionPlanRequest req;
+    req.planner_id = planner_id;
+    req.group_name = PLANNING_GROUP;
+    req.max_velocity_scaling_factor = 0.5;
+    req.max_acceleration_scaling_factor = 0.5;
+    state.setJointGroupPositions(group, start_positions);
+    moveit::core::robotStateToRobotStateMsg(state, req.start_state, false);
+    state.setJointGroupPositions(group, goal_positions);
+    req.goal_constraints.push_back(kinematic_constraints::constructGoalConstraints(state, group));
+    return req;
+  }
+
+  /**
+   * @brief Creates a CIRC request whose interim point is the position of the target link
+   * at the specified interim positions.
+   */
+  planning_interface::MotionPlanRequest createCircRequest(const std::vector<double>& start_positions,
+                                                          const std::vector<double>& interim_positions,
+                                                          const std::vector<double>& goal_positions) const
+  {
+    planning_interface::MotionPlanRequest req {createRequest("CIRC", start_positions, goal_positions)};
+
+    robot_state::RobotState state(robot_model_);
+    state.setToDefaultValues();
+    state.setJointGroupPositions(PLANNING_GROUP, interim_positions);
+    state.update();
+
+    moveit_msgs::PositionConstraint interim_point;
+    interim_point.link_name = TARGET_LINK;
+    geometry_msgs::Pose interim_pose;
+    const Eigen::Vector3d interim_position {state.getFrameTransform(TARGET_LINK).translation()};
+    interim_pose.position.x = interim_position.x();
+    interim_pose.position.y = interim_position.y();
+    interim_pose.position.z = interim_position.z();
+    interim_point.constraint_region.primitive_poses.push_back(interim_pose);
+    req.path_constraints.name = "interim";
+    req.path_constraints.position_constraints.push_back(interim_point);
+    return req;
+  }
+
+  /**
+   * @brief Solves the specified request with a planning context of the planner.
+   */
+  bool solve(const planning_scene::PlanningSceneConstPtr& scene,
+             const planning_interface::MotionPlanRequest& req,
+             planning_interface::MotionPlanResponse& res) const
+  {
+    moveit_msgs::MoveItErrorCodes error_code;
+    planning_interface::PlanningContextPtr context {planner_instance_->getPlanningContext(scene, req, error_code)};
+    return context && context->solve(res);
+  }
+
 protected:
   // ros stuff
   ros::NodeHandle ph_ {"~"};
@@ -112,7 +187,7 @@ TEST_P(CommandPlannerTest, ObtainLoadedPlanningAlgorithms)
   std::vector<std::string> algs;
 
   planner_instance_->getPlanningAlgorithms(algs);
-  ASSERT_EQ(3u, algs.size()) << "Found more or less planning algorithms as expected! Found:"
+  ASSERT_EQ(4u, algs.size()) << "Found more or less planning algorithms as expected! Found:"
                             << ::testing::PrintToString(algs);
 
 
@@ -126,6 +201,7 @@ TEST_P(CommandPlannerTest, ObtainLoadedPlanningAlgorithms)
   ASSERT_TRUE(algs_set.find("LIN") != algs_set.end());
   ASSERT_TRUE(algs_set.find("PTP") != algs_set.end());
   ASSERT_TRUE(algs_set.find("CIRC") != algs_set.end());
+  ASSERT_TRUE(algs_set.find("SPLINE") != algs_set.end());
 }
 
 
@@ -202,6 +278,43 @@ TEST_P(CommandPlannerTest, CheckPlanningContextRequest)
 
 }
 
+/**
+ * @brief Check that the first requests of a command, which load the context loader, can be issued concurrently
+ */
+TEST_P(CommandPlannerTest, ConcurrentFirstPlanningContextRequests)
+{
+  std::vector<std::string> algs;
+  planner_instance_->getPlanningAlgorithms(algs);
+
+  std::vector<std::size_t> num_failures(NUM_PLANNING_THREADS, 0);
+  std::vector<std::thread> threads;
+  for(std::size_t i = 0; i < NUM_PLANNING_THREADS; ++i)
+  {
+    threads.emplace_back([&, i]()
+    {
+      for(const auto& alg : algs)
+      {
+        moveit_msgs::MotionPlanRequest req;
+        req.planner_id = alg;
+        moveit_msgs::MoveItErrorCodes error_code;
+        if(!planner_instance_->getPlanningContext(nullptr, req, error_code))
+        {
+          ++num_failures.at(i);
+        }
+      }
+    });
+  }
+  for(auto& thread : threads)
+  {
+    thread.join();
+  }
+
+  for(std::size_t i = 0; i < NUM_PLANNING_THREADS; ++i)
+  {
+    EXPECT_EQ(0u, num_failures.at(i)) << "Thread " << i;
+  }
+}
+
 /**
  * @brief Check the description can be obtained and is not empty
  */
@@ -211,6 +324,89 @@ TEST_P(CommandPlannerTest, CheckPlanningContextDescriptionNotEmptyAndStable)
   EXPECT_GT(desc.length(), 0u);
 }
 
+/**
+ * @brief Check that concurrent planning requests (PTP, LIN and CIRC) from several threads
+ * yield the same results as the same requests planned one after the other.
+ */
+TEST_P(CommandPlannerTest, ConcurrentPlanning)
+{
+  planning_scene::PlanningSceneConstPtr scene {new planning_scene::PlanningScene(robot_model_)};
+
+  const std::vector<double> start_positions {0., -0.5, 1.5, 0., 1.0, 0.};
+  std::vector<planning_interface::MotionPlanRequest> requests;
+  for(std::size_t i = 0; i < NUM_PLANNING_THREADS; ++i)
+  {
+    std::vector<double> goal_positions {start_positions};
+    goal_positions.at(0) += 0.1 * static_cast<double>(i + 1);
+    if (i % 3 == 2)
+    {
+      // Circle around the base axis, given by the position of the target link half way
+      std::vector<double> interim_positions {start_positions};
+      interim_positions.at(0) += 0.05 * static_cast<double>(i + 1);
+      requests.push_back(createCircRequest(start_positions, interim_positions, goal_positions));
+    }
+    else
+    {
+      requests.push_back(createRequest(i % 3 ? "LIN" : "PTP", start_positions, goal_positions));
+    }
+  }
+
+  std::vector<planning_interface::MotionPlanResponse> expected_responses(requests.size());
+  for(std::size_t i = 0; i < requests.size(); ++i)
+  {
+    ASSERT_TRUE(solve(scene, requests.at(i), expected_responses.at(i))) << "Request " << i;
+  }
+
+  std::vector<std::size_t> num_failures(requests.size(), 0);
+  std::vector<std::thread> threads;
+  for(std::size_t i = 0; i < requests.size(); ++i)
+  {
+    threads.emplace_back([&, i]()
+    {
+      const robot_trajectory::RobotTrajectory& expected {*expected_responses.at(i).trajectory_};
+      for(std::size_t j = 0; j < NUM_REQUESTS_PER_THREAD; ++j)
+      {
+        planning_interface::MotionPlanResponse res;
+        if (!solve(scene, requests.at(i), res) || res.trajectory_->getWayPointCount() != expected.getWayPointCount()
+            || res.trajectory_->getLastWayPoint().distance(expected.getLastWayPoint()) > 1e-8)
+        {
+          ++num_failures.at(i);
+        }
+      }
+    });
+  }
+  for(auto& thread : threads)
+  {
+    thread.join();
+  }
+
+  for(std::size_t i = 0; i < requests.size(); ++i)
+  {
+    EXPECT_EQ(0u, num_failures.at(i)) << "Request " << i << " (" << requests.at(i).planner_id << ")";
+  }
+}
+
+/**
+ * @brief Checks that the limits reloaded by the planner plugin are shared with the other libraries,
+ * i.e. the limits obtained by this test are the same object as the ones reloaded by the planner.
+ */
+TEST_P(CommandPlannerTest, SharedLimitsReloadedByPlanner)
+{
+  const ros::NodeHandle limits_nh {PARAM_NAMESPACE_LIMITS};
+  const pilz::LimitsContainerConstPtr old_limits {pilz::LimitsAggregator::getAggregatedLimits(limits_nh, robot_model_)};
+  const double max_trans_vel {old_limits->getCartesianLimits().getMaxTranslationalVelocity()};
+
+  // The planner plugin is loaded from its own library and reloads the limits on initialization
+  limits_nh.setParam("cartesian_limits/max_trans_vel", 0.5 * max_trans_vel);
+  createPlannerInstance();
+  limits_nh.setParam("cartesian_limits/max_trans_vel", max_trans_vel);
+
+  const pilz::LimitsContainerConstPtr limits {pilz::LimitsAggregator::getAggregatedLimits(limits_nh, robot_model_)};
+  EXPECT_NE(old_limits.get(), limits.get()) << "The limits reloaded by the planner are not shared";
+  EXPECT_EQ(0.5 * max_trans_vel, limits->getCartesianLimits().getMaxTranslationalVelocity());
+  EXPECT_EQ(limits.get(), pilz::LimitsAggregator::getAggregatedLimits(limits_nh, robot_model_).get());
+}
+
 int main(int argc, char **argv)
 {
   ros::init(argc, argv, "unittest_pilz_command_planner");
@@ -31,6 +31,7 @@
 #include "pilz_trajectory_generation/planning_context_ptp.h"
 #include "pilz_trajectory_generation/planning_context_lin.h"
 #include "pilz_trajectory_generation/planning_context_circ.h"
+#include "pilz_trajectory_generation/planning_context_spline.h"
 
 #include "test_utils.h"
 
@@ -64,9 +65,11 @@ typedef ValueTypeContainer<pilz::PlanningContextLIN, 0> LIN_NO_GRIPPER;
 typedef ValueTypeContainer<pilz::PlanningContextLIN, 1> LIN_WITH_GRIPPER;
 typedef ValueTypeContainer<pilz::PlanningContextCIRC, 0> CIRC_NO_GRIPPER;
 typedef ValueTypeContainer<pilz::PlanningContextCIRC, 1> CIRC_WITH_GRIPPER;
+typedef ValueTypeContainer<pilz::PlanningContextSPLINE, 0> SPLINE_NO_GRIPPER;
+typedef ValueTypeContainer<pilz::PlanningContextSPLINE, 1> SPLINE_WITH_GRIPPER;
 
 typedef ::testing::Types<PTP_NO_GRIPPER, PTP_WITH_GRIPPER, LIN_NO_GRIPPER, LIN_WITH_GRIPPER,
-CIRC_NO_GRIPPER, CIRC_WITH_GRIPPER> PlanningContextTestTypes;
+CIRC_NO_GRIPPER, CIRC_WITH_GRIPPER, SPLINE_NO_GRIPPER, SPLINE_WITH_GRIPPER> PlanningContextTestTypes;
 
 /**
  * type parameterized test fixture
@@ -141,6 +144,26 @@ protected:
           kinematic_constraints::constructGoalConstraints(rstate,
                                                           this->robot_model_->getJointModelGroup(this->planning_group_)));
 
+    // waypoint of the spline
+    if(req.planner_id == "SPLINE")
+    {
+      moveit_msgs::PositionConstraint waypoint_position;
+      waypoint_position.link_name = this->target_link_;
+      geometry_msgs::Pose waypoint_pose;
+      waypoint_pose.position.x = 0.2;
+      waypoint_pose.position.y = 0.2;
+      waypoint_pose.position.z = 0.65;
+      waypoint_pose.orientation.w = 1.0;
+      waypoint_position.constraint_region.primitive_poses.push_back(waypoint_pose);
+      req.path_constraints.position_constraints.push_back(waypoint_position);
+
+      moveit_msgs::OrientationConstraint waypoint_orientation;
+      waypoint_orientation.link_name = this->target_link_;
+      waypoint_orientation.orientation = waypoint_pose.orientation;
+      req.path_constraints.orientation_constraints.push_back(waypoint_orientation);
+      return req;
+    }
+
     // path constraint
     req.path_constraints.name = "center";
     moveit_msgs::PositionConstraint center_point;
@@ -161,7 +184,7 @@ protected:
   robot_model::RobotModelConstPtr robot_model_ {
     robot_model_loader::RobotModelLoader(!T::VALUE ? PARAM_MODEL_NO_GRIPPER_NAME: PARAM_MODEL_WITH_GRIPPER_NAME).getModel()};
 
-  std::unique_ptr<planning_interface::PlanningContext> planning_context_;
+  std::unique_ptr<typename T::Type_> planning_context_;
 
   std::string planning_group_, target_link_;
 };
@@ -245,6 +268,44 @@ TYPED_TEST(PlanningContextTest, SolveOnTerminated)
 
 }
 
+/**
+ * @brief Check that the trajectory is sampled with the sampling time set for the context.
+ */
+TYPED_TEST(PlanningContextTest, SolveWithSamplingTime)
+{
+  const double sampling_time {0.05};
+  planning_interface::MotionPlanResponse res;
+  planning_interface::MotionPlanRequest req  = this->getValidRequest(testutils::demangel(typeid(TypeParam).name()));
+
+  this->planning_context_->setSamplingTime(sampling_time);
+  this->planning_context_->setMotionPlanRequest(req);
+  ASSERT_TRUE(this->planning_context_->solve(res)) << testutils::demangel(typeid(TypeParam).name());
+
+  ASSERT_GT(res.trajectory_->getWayPointCount(), 2u) << testutils::demangel(typeid(TypeParam).name());
+  EXPECT_NEAR(sampling_time, res.trajectory_->getWayPointDurationFromPrevious(1), 1e-6)
+      << testutils::demangel(typeid(TypeParam).name());
+}
+
+/**
+ * @brief Check that a terminated context can be used again after reset (as done by the context loaders).
+ */
+TYPED_TEST(PlanningContextTest, SolveAfterReset)
+{
+  planning_interface::MotionPlanResponse res;
+  planning_interface::MotionPlanRequest req  = this->getValidRequest(testutils::demangel(typeid(TypeParam).name()));
+
+  EXPECT_TRUE(this->planning_context_->terminate()) << testutils::demangel(typeid(TypeParam).name());
+
+  this->planning_context_->reset();
+  EXPECT_EQ(nullptr, this->planning_context_->getPlanningScene()) << testutils::demangel(typeid(TypeParam).name());
+
+  this->planning_context_->setMotionPlanRequest(req);
+  bool result = this->planning_context_->solve(res);
+  EXPECT_TRUE(result) << testutils::demangel(typeid(TypeParam).name());
+  EXPECT_EQ(moveit_msgs::MoveItErrorCodes::SUCCESS, res.error_code_.val)
+      << testutils::demangel(typeid(TypeParam).name());
+}
+
 /**
  * @brief Check if clear can be called. So far only stability is expected.
  */
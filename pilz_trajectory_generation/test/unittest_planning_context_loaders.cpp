@@ -96,7 +96,9 @@ INSTANTIATE_TEST_CASE_P(InstantiationName, PlanningContextLoadersTest, ::testing
                           std::vector<std::string>{"pilz::PlanningContextLoaderLIN", "LIN", PARAM_MODEL_NO_GRIPPER_NAME}, // Test for LIN
                           std::vector<std::string>{"pilz::PlanningContextLoaderLIN", "LIN", PARAM_MODEL_WITH_GRIPPER_NAME}, // Test for LIN
                           std::vector<std::string>{"pilz::PlanningContextLoaderCIRC", "CIRC", PARAM_MODEL_NO_GRIPPER_NAME}, // Test for CIRC
-                          std::vector<std::string>{"pilz::PlanningContextLoaderCIRC", "CIRC", PARAM_MODEL_WITH_GRIPPER_NAME} // Test for CIRC
+                          std::vector<std::string>{"pilz::PlanningContextLoaderCIRC", "CIRC", PARAM_MODEL_WITH_GRIPPER_NAME}, // Test for CIRC
+                          std::vector<std::string>{"pilz::PlanningContextLoaderSPLINE", "SPLINE", PARAM_MODEL_NO_GRIPPER_NAME}, // Test for SPLINE
+                          std::vector<std::string>{"pilz::PlanningContextLoaderSPLINE", "SPLINE", PARAM_MODEL_WITH_GRIPPER_NAME} // Test for SPLINE
                           ));
 
 /**
@@ -145,6 +147,79 @@ TEST_P(PlanningContextLoadersTest, LoadContext)
   EXPECT_EQ(true, res) << "Context could not be loaded!";
 }
 
+/**
+ * @brief Check that released contexts are reused for the same name and group
+ */
+TEST_P(PlanningContextLoadersTest, ReuseReleasedContext)
+{
+  pilz::JointLimitsContainer joint_limits = testutils::createFakeLimits(robot_model_->getVariableNames());
+  pilz::LimitsContainer limits;
+  limits.setJointLimits(joint_limits);
+  pilz::CartesianLimit cart_limits;
+  cart_limits.setMaxRotationalVelocity(1*M_PI);
+  cart_limits.setMaxTranslationalAcceleration(2);
+  cart_limits.setMaxTranslationalDeceleration(2);
+  cart_limits.setMaxTranslationalVelocity(1);
+  limits.setCartesianLimits(cart_limits);
+
+  planning_context_loader_->setLimits(limits);
+  planning_context_loader_->setModel(robot_model_);
+
+  planning_interface::PlanningContextPtr first_context, second_context;
+  ASSERT_TRUE(planning_context_loader_->loadContext(first_context, "test", "test"));
+  ASSERT_TRUE(planning_context_loader_->loadContext(second_context, "test", "test"));
+  EXPECT_NE(first_context.get(), second_context.get()) << "Context in use was handed out twice";
+
+  const planning_interface::PlanningContext* released_context {first_context.get()};
+  first_context.reset();
+  ASSERT_TRUE(planning_context_loader_->loadContext(first_context, "test", "test"));
+  EXPECT_EQ(released_context, first_context.get()) << "Released context was not reused";
+
+  planning_interface::PlanningContextPtr other_group_context;
+  second_context.reset();
+  ASSERT_TRUE(planning_context_loader_->loadContext(other_group_context, "test", "other_group"));
+  EXPECT_EQ("other_group", other_group_context->getGroupName());
+}
+
+/**
+ * @brief Checks that a context which is in use while the limits change is not reused afterwards,
+ * because it still holds the old limits.
+ */
+TEST_P(PlanningContextLoadersTest, NoReuseAfterLimitsChange)
+{
+  pilz::JointLimitsContainer joint_limits = testutils::createFakeLimits(robot_model_->getVariableNames());
+  pilz::LimitsContainer limits;
+  limits.setJointLimits(joint_limits);
+  pilz::CartesianLimit cart_limits;
+  cart_limits.setMaxRotationalVelocity(1*M_PI);
+  cart_limits.setMaxTranslationalAcceleration(2);
+  cart_limits.setMaxTranslationalDeceleration(2);
+  cart_limits.setMaxTranslationalVelocity(1);
+  limits.setCartesianLimits(cart_limits);
+
+  planning_context_loader_->setLimits(limits);
+  planning_context_loader_->setModel(robot_model_);
+
+  planning_interface::PlanningContextPtr old_context;
+  ASSERT_TRUE(planning_context_loader_->loadContext(old_context, "test", "test"));
+
+  cart_limits.setMaxTranslationalVelocity(0.5);
+  limits.setCartesianLimits(cart_limits);
+  planning_context_loader_->setLimits(limits);
+
+  planning_interface::PlanningContextPtr new_context;
+  ASSERT_TRUE(planning_context_loader_->loadContext(new_context, "test", "test"));
+  const planning_interface::PlanningContext* new_context_ptr {new_context.get()};
+
+  // Release the new context first, so that the old one would be handed out next if it was pooled
+  new_context.reset();
+  old_context.reset();
+
+  planning_interface::PlanningContextPtr context;
+  ASSERT_TRUE(planning_context_loader_->loadContext(context, "test", "test"));
+  EXPECT_EQ(new_context_ptr, context.get()) << "Context with outdated limits was reused";
+}
+
 int main(int argc, char **argv)
 {
   ros::init(argc, argv, "unittest_planning_context_loaders");
@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2018 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "pilz_trajectory_generation/planning_core.h"
+#include "pilz_trajectory_generation/velocity_profile_atrap.h"
+
+using namespace pilz;
+
+static constexpr double EPSILON {1e-9};
+static constexpr double SAMPLING_TIME {0.01};
+
+class PlanningCoreTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    limit_.has_velocity_limits = true;
+    limit_.max_velocity = 1.0;
+    limit_.has_acceleration_limits = true;
+    limit_.max_acceleration = 2.0;
+    limit_.has_deceleration_limits = true;
+    limit_.max_deceleration = -2.0;
+
+    joint_limits_.addLimit("joint_1", limit_);
+    joint_limits_.addLimit("joint_2", limit_);
+
+    cartesian_limit_.setMaxTranslationalVelocity(1.0);
+    cartesian_limit_.setMaxTranslationalAcceleration(2.0);
+    cartesian_limit_.setMaxTranslationalDeceleration(-2.0);
+    cartesian_limit_.setMaxRotationalVelocity(0.5);
+  }
+
+protected:
+  pilz_extensions::JointLimit limit_;
+  JointLimitsContainer joint_limits_;
+  CartesianLimit cartesian_limit_;
+};
+
+/**
+ * @brief Checks that all joints of a PTP trajectory start and stop together and end exactly at the goal.
+ */
+TEST_F(PlanningCoreTest, PTPTrajectorySynchronized)
+{
+  const std::map<std::string, double> start {{"joint_1", 0.0}, {"joint_2", 0.2}};
+  const std::map<std::string, double> goal {{"joint_1", 1.0}, {"joint_2", -0.3}};
+
+  JointSpaceTrajectory trajectory;
+  ASSERT_TRUE(planPTPTrajectory(start, goal, limit_, 1.0, 1.0, SAMPLING_TIME, trajectory));
+  ASSERT_EQ(2u, trajectory.joint_names.size());
+  ASSERT_GT(trajectory.samples.size(), 2u);
+
+  // joint_1 is the leading axis: 0.5s acceleration, 0.5s constant velocity, 0.5s deceleration
+  EXPECT_NEAR(1.5, trajectory.samples.back().time_from_start, EPSILON);
+  EXPECT_NEAR(0., trajectory.samples.front().time_from_start, EPSILON);
+  for(std::size_t i = 0; i < trajectory.joint_names.size(); ++i)
+  {
+    const std::string& joint_name {trajectory.joint_names.at(i)};
+    EXPECT_DOUBLE_EQ(start.at(joint_name), trajectory.samples.front().positions.at(i));
+    EXPECT_DOUBLE_EQ(goal.at(joint_name), trajectory.samples.back().positions.at(i));
+    EXPECT_DOUBLE_EQ(0., trajectory.samples.back().velocities.at(i));
+    EXPECT_DOUBLE_EQ(0., trajectory.samples.back().accelerations.at(i));
+  }
+
+  // both joints reach half of their motion at the same time
+  const JointTrajectorySample& middle {trajectory.samples.at(trajectory.samples.size() / 2)};
+  EXPECT_NEAR(0.5, middle.positions.at(0), 1e-2);
+  EXPECT_NEAR(-0.05, middle.positions.at(1), 1e-2);
+}
+
+/**
+ * @brief Checks that a PTP trajectory to the start consists of the start positions only.
+ */
+TEST_F(PlanningCoreTest, PTPTrajectoryGoalReached)
+{
+  const std::map<std::string, double> start {{"joint_1", 0.0}, {"joint_2", 0.2}};
+
+  JointSpaceTrajectory trajectory;
+  EXPECT_FALSE(planPTPTrajectory(start, start, limit_, 1.0, 1.0, SAMPLING_TIME, trajectory));
+  ASSERT_EQ(1u, trajectory.samples.size());
+  EXPECT_DOUBLE_EQ(SAMPLING_TIME, trajectory.samples.front().time_from_start);
+  EXPECT_DOUBLE_EQ(0.2, trajectory.samples.front().positions.at(1));
+}
+
+/**
+ * @brief Checks the time samples and poses of a sampled Cartesian line.
+ */
+TEST_F(PlanningCoreTest, SampleCartesianTrajectory)
+{
+  const Eigen::Isometry3d start_pose {Eigen::Isometry3d::Identity()};
+  const Eigen::Isometry3d goal_pose {Eigen::Translation3d(1.0, 0., 0.) * Eigen::AngleAxisd(0.5, Eigen::Vector3d::UnitZ())};
+  const CartesianPathLine path(start_pose, goal_pose, 0.5);
+
+  VelocityProfile_ATrap velocity_profile(1.0, 1.0, -1.0);
+  velocity_profile.SetProfile(0, path.getLength());
+
+  CartesianSamples samples;
+  sampleCartesianTrajectory(path, velocity_profile, 0.15, samples);
+  ASSERT_EQ(samples.time_samples.size(), samples.poses.size());
+  EXPECT_NEAR(velocity_profile.Duration(), samples.time_samples.back(), EPSILON);
+  EXPECT_NEAR(0.15, samples.time_samples.at(1), EPSILON);
+  EXPECT_TRUE(start_pose.isApprox(samples.poses.front(), EPSILON));
+  EXPECT_TRUE(goal_pose.isApprox(samples.poses.back(), EPSILON));
+}
+
+/**
+ * @brief Checks the Cartesian trajectory of a LIN command with the trapezoid velocity profile of the limits.
+ *
+ * The line of 2m is moved with 1m/s and 2m/s^2 and therefore takes 0.5s + 1.5s + 0.5s.
+ */
+TEST_F(PlanningCoreTest, PlanLINTrajectory)
+{
+  const Eigen::Isometry3d start_pose {Eigen::Isometry3d::Identity()};
+  const Eigen::Isometry3d goal_pose {Eigen::Translation3d(2.0, 0., 0.) * Eigen::Isometry3d::Identity()};
+  const std::unique_ptr<CartesianPath> path {createLINPath(start_pose, goal_pose, cartesian_limit_)};
+  ASSERT_TRUE(path);
+
+  CartesianSamples samples;
+  planCartesianTrajectory(*path, cartesian_limit_, 1.0, 1.0, SAMPLING_TIME, samples);
+  ASSERT_EQ(samples.time_samples.size(), samples.poses.size());
+  EXPECT_NEAR(2.5, samples.time_samples.back(), EPSILON);
+  EXPECT_TRUE(start_pose.isApprox(samples.poses.front(), EPSILON));
+  EXPECT_TRUE(goal_pose.isApprox(samples.poses.back(), EPSILON));
+}
+
+/**
+ * @brief Checks that the Cartesian trajectory of a CIRC command stays on the circle around the center.
+ */
+TEST_F(PlanningCoreTest, PlanCIRCTrajectory)
+{
+  const Eigen::Isometry3d start_pose {Eigen::Translation3d(1.0, 0., 0.) * Eigen::Isometry3d::Identity()};
+  const Eigen::Isometry3d goal_pose {Eigen::Translation3d(0., 1.0, 0.) * Eigen::Isometry3d::Identity()};
+  const Eigen::Vector3d center {Eigen::Vector3d::Zero()};
+  const std::unique_ptr<CartesianPath> path {createCIRCPath(start_pose, goal_pose, center, true, cartesian_limit_)};
+  ASSERT_TRUE(path);
+
+  CartesianSamples samples;
+  planCartesianTrajectory(*path, cartesian_limit_, 0.5, 0.5, SAMPLING_TIME, samples);
+  ASSERT_LT(2u, samples.poses.size());
+  for(const auto& pose : samples.poses)
+  {
+    EXPECT_NEAR(1.0, (pose.translation() - center).norm(), 1e-6);
+  }
+  EXPECT_TRUE(goal_pose.isApprox(samples.poses.back(), 1e-6));
+}
+
+/**
+ * @brief Checks that the time samples of a PTP trajectory follow sampleTimes().
+ */
+TEST_F(PlanningCoreTest, PTPTrajectoryTimeSamples)
+{
+  const std::map<std::string, double> start_positions {{"joint_1", 0.0}, {"joint_2", 0.0}};
+  const std::map<std::string, double> goal_positions {{"joint_1", 1.0}, {"joint_2", 0.5}};
+
+  JointSpaceTrajectory trajectory;
+  ASSERT_TRUE(planPTPTrajectory(start_positions, goal_positions, limit_, 1.0, 1.0, SAMPLING_TIME, trajectory));
+
+  const std::vector<double> expected_times {sampleTimes(trajectory.samples.back().time_from_start, SAMPLING_TIME)};
+  ASSERT_EQ(expected_times.size(), trajectory.samples.size());
+  for(std::size_t i = 0; i < expected_times.size(); ++i)
+  {
+    EXPECT_DOUBLE_EQ(expected_times.at(i), trajectory.samples.at(i).time_from_start);
+  }
+}
+
+/**
+ * @brief Checks the detection of joint limit violations of a sample.
+ */
+TEST_F(PlanningCoreTest, CheckSampleJointLimits)
+{
+  const std::map<std::string, double> position_last {{"joint_1", 0.0}, {"joint_2", 0.0}};
+  const std::map<std::string, double> velocity_last {{"joint_1", 0.0}, {"joint_2", 0.5}};
+  std::string violating_joint;
+  double violating_value {0.};
+
+  EXPECT_EQ(JointLimitViolation::NONE,
+            checkSampleJointLimits(position_last, velocity_last, {{"joint_1", 0.0001}, {"joint_2", 0.005}},
+                                   SAMPLING_TIME, SAMPLING_TIME, joint_limits_, violating_joint, violating_value));
+
+  EXPECT_EQ(JointLimitViolation::SAMPLE_DURATION_TOO_SMALL,
+            checkSampleJointLimits(position_last, velocity_last, position_last,
+                                   SAMPLING_TIME, 0., joint_limits_, violating_joint, violating_value));
+
+  EXPECT_EQ(JointLimitViolation::VELOCITY,
+            checkSampleJointLimits(position_last, velocity_last, {{"joint_1", 0.02}, {"joint_2", 0.005}},
+                                   SAMPLING_TIME, SAMPLING_TIME, joint_limits_, violating_joint, violating_value));
+  EXPECT_EQ("joint_1", violating_joint);
+  EXPECT_NEAR(2.0, violating_value, EPSILON);
+
+  EXPECT_EQ(JointLimitViolation::ACCELERATION,
+            checkSampleJointLimits(position_last, velocity_last, {{"joint_1", 0.0005}, {"joint_2", 0.005}},
+                                   SAMPLING_TIME, SAMPLING_TIME, joint_limits_, violating_joint, violating_value));
+  EXPECT_EQ("joint_1", violating_joint);
+
+  EXPECT_EQ(JointLimitViolation::DECELERATION,
+            checkSampleJointLimits(position_last, velocity_last, {{"joint_1", 0.0}, {"joint_2", 0.0}},
+                                   SAMPLING_TIME, SAMPLING_TIME, joint_limits_, violating_joint, violating_value));
+  EXPECT_EQ("joint_2", violating_joint);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
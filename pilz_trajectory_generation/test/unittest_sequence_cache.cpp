@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2018 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include "pilz_trajectory_generation/sequence_cache.h"
+
+using namespace pilz_trajectory_generation;
+
+static constexpr double TOLERANCE {1e-3};
+
+class SequenceCacheTest : public ::testing::Test
+{
+protected:
+  SequenceCache cache_ {2, TOLERANCE};
+
+  //! The entries are distinguished by the number of (empty) trajectories.
+  const SequenceCache::TrajCont trajs_1_ {SequenceCache::TrajCont(1)};
+  const SequenceCache::TrajCont trajs_2_ {SequenceCache::TrajCont(2)};
+  const SequenceCache::TrajCont trajs_3_ {SequenceCache::TrajCont(3)};
+
+  const std::vector<double> positions_ {0.1, 0.2, 0.3};
+};
+
+/**
+ * @brief Checks that stored trajectories are returned for the same key and
+ * start positions within the tolerance.
+ */
+TEST_F(SequenceCacheTest, testHit)
+{
+  cache_.insert("a", positions_, trajs_1_);
+
+  std::vector<double> positions {positions_};
+  positions.at(1) += 0.5 * TOLERANCE;
+  SequenceCache::TrajCont trajs;
+  ASSERT_TRUE(cache_.lookup("a", positions, trajs));
+  EXPECT_EQ(trajs_1_.size(), trajs.size());
+  EXPECT_EQ(1u, cache_.getStatistics().hits);
+  EXPECT_EQ(0u, cache_.getStatistics().misses);
+}
+
+/**
+ * @brief Checks that unknown keys and start positions outside of the tolerance
+ * are misses.
+ */
+TEST_F(SequenceCacheTest, testMiss)
+{
+  cache_.insert("a", positions_, trajs_1_);
+
+  SequenceCache::TrajCont trajs;
+  EXPECT_FALSE(cache_.lookup("b", positions_, trajs));
+
+  std::vector<double> positions {positions_};
+  positions.at(1) += 2. * TOLERANCE;
+  EXPECT_FALSE(cache_.lookup("a", positions, trajs));
+  EXPECT_FALSE(cache_.lookup("a", std::vector<double>(), trajs));
+
+  EXPECT_EQ(0u, cache_.getStatistics().hits);
+  EXPECT_EQ(3u, cache_.getStatistics().misses);
+}
+
+/**
+ * @brief Checks that inserting an existing key replaces the entry.
+ */
+TEST_F(SequenceCacheTest, testReplace)
+{
+  cache_.insert("a", positions_, trajs_1_);
+  cache_.insert("a", positions_, trajs_2_);
+  EXPECT_EQ(1u, cache_.size());
+
+  SequenceCache::TrajCont trajs;
+  ASSERT_TRUE(cache_.lookup("a", positions_, trajs));
+  EXPECT_EQ(trajs_2_.size(), trajs.size());
+}
+
+/**
+ * @brief Checks that the least recently used entry is removed if the capacity
+ * is exceeded.
+ */
+TEST_F(SequenceCacheTest, testLeastRecentlyUsedIsRemoved)
+{
+  cache_.insert("a", positions_, trajs_1_);
+  cache_.insert("b", positions_, trajs_2_);
+
+  SequenceCache::TrajCont trajs;
+  ASSERT_TRUE(cache_.lookup("a", positions_, trajs));
+
+  cache_.insert("c", positions_, trajs_3_);
+  EXPECT_EQ(2u, cache_.size());
+  EXPECT_TRUE(cache_.lookup("a", positions_, trajs));
+  EXPECT_FALSE(cache_.lookup("b", positions_, trajs));
+  EXPECT_TRUE(cache_.lookup("c", positions_, trajs));
+}
+
+/**
+ * @brief Checks that a cache without capacity stores nothing.
+ */
+TEST(SequenceCacheCapacityTest, testZeroCapacity)
+{
+  SequenceCache cache {0, TOLERANCE};
+  cache.insert("a", std::vector<double>(), SequenceCache::TrajCont(1));
+  EXPECT_EQ(0u, cache.size());
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
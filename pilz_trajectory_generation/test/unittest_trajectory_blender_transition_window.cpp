@@ -16,6 +16,7 @@
  */
 
 #include <memory>
+#include <utility>
 
 #include <gtest/gtest.h>
 
@@ -35,6 +36,7 @@
 #include "pilz_trajectory_generation/trajectory_blender_transition_window.h"
 #include "pilz_trajectory_generation/trajectory_blend_request.h"
 #include "pilz_trajectory_generation/trajectory_blend_response.h"
+#include "pilz_trajectory_generation/trajectory_functions.h"
 #include "test_utils.h"
 
 const std::string PARAM_MODEL_NO_GRIPPER_NAME {"robot_description"};
@@ -278,11 +280,18 @@ TEST_P(TrajectoryBlenderTransitionWindowTest, testZeroRadius)
  *
  * Test Sequence:
  *    1. Generate two linear trajectories with different sampling times.
- *    2. Try to generate blending trajectory.
+ *    2. Generate blending trajectory.
+ *    3. Check blending trajectory:
+ *      - for position, velocity, and acceleration bounds,
+ *      - for continuity in joint space,
+ *      - for continuity in cartesian space.
  *
  * Expected Results:
  *    1. Two linear trajectories generated.
- *    2. Blending trajectory cannot be generated.
+ *    2. Blending trajectory generated with the finer sampling time, the remainder of the
+ *       second trajectory keeps the coarser sampling time.
+ *    3. No bound is violated, the trajectories are continuous
+ *        in joint and cartesian space.
  */
 TEST_P(TrajectoryBlenderTransitionWindowTest, testDifferentSamplingTimes)
 {
@@ -318,7 +327,112 @@ TEST_P(TrajectoryBlenderTransitionWindowTest, testDifferentSamplingTimes)
   blend_req.first_trajectory = responses[0].trajectory_;
   blend_req.second_trajectory = responses[1].trajectory_;
   blend_req.blend_radius = seq.getBlendRadius(0);
-  EXPECT_FALSE(blender_->blend(blend_req, blend_res));
+  ASSERT_TRUE(blender_->blend(blend_req, blend_res));
+
+  // only the blend window of the coarser second trajectory is resampled, the remainder keeps its sampling time
+  EXPECT_NEAR(sampling_time_/2, blend_res.blend_trajectory->getWayPointDurationFromPrevious(1), 10e-5);
+  double second_sampling_time {0.};
+  EXPECT_TRUE(pilz::determineSamplingTime(blend_res.second_trajectory, 10e-5, second_sampling_time));
+  EXPECT_NEAR(sampling_time_, second_sampling_time, 10e-5);
+  EXPECT_LT(blend_res.second_trajectory->getWayPointCount(), responses[1].trajectory_->getWayPointCount());
+
+  moveit_msgs::RobotTrajectory traj_msg;
+  for(const auto& traj : {blend_res.first_trajectory, blend_res.blend_trajectory, blend_res.second_trajectory})
+  {
+    traj->getRobotTrajectoryMsg(traj_msg);
+    EXPECT_TRUE(testutils::checkJointTrajectory(traj_msg.joint_trajectory, planner_limits_.getJointLimitContainer()));
+  }
+
+  Eigen::Isometry3d circ_pose = blend_req.first_trajectory->getLastWayPointPtr()->getFrameTransform(target_link_);
+  EXPECT_TRUE(testutils::checkThatPointsInRadius(target_link_, blend_req.blend_radius, circ_pose, blend_res));
+  EXPECT_TRUE(testutils::checkBlendingJointSpaceContinuity(blend_res,
+                                                           joint_velocity_tolerance_,
+                                                           joint_acceleration_tolerance_));
+  EXPECT_TRUE(testutils::checkBlendingCartSpaceContinuity(blend_req, blend_res, planner_limits_));
+}
+
+/**
+ * @brief  Tests the chained blending of three trajectories with alternating sampling times.
+ *
+ * Test Sequence:
+ *    1. Generate three linear trajectories, the second one with a coarser sampling time.
+ *    2. Blend the first and the second trajectory.
+ *    3. Blend the remainder of the second trajectory with the third trajectory.
+ *    4. Check the blend results.
+ *
+ * Expected Results:
+ *    1. Three linear trajectories generated.
+ *    2. Blending trajectory generated, the remainder of the second trajectory
+ *       keeps the coarser sampling time.
+ *    3. Blending trajectory generated with the finer sampling time.
+ *    4. No bound is violated, the trajectories are continuous
+ *        in joint and cartesian space.
+ */
+TEST_P(TrajectoryBlenderTransitionWindowTest, testChainedDifferentSamplingTimes)
+{
+  Sequence seq {data_loader_->getSequence("SimpleSequence")};
+
+  // third command goes back to the start of the first one
+  LinCart third_cmd {seq.getCmd<LinCart>(0)};
+  third_cmd.setStartConfiguration(seq.getCmd<LinCart>(1).getGoalConfiguration());
+  third_cmd.setGoalConfiguration(seq.getCmd<LinCart>(0).getStartConfiguration());
+  std::vector<planning_interface::MotionPlanRequest> requests {seq.getCmd<LinCart>(0).toRequest(),
+                                                               seq.getCmd<LinCart>(1).toRequest(),
+                                                               third_cmd.toRequest()};
+  const std::vector<double> sampling_times {sampling_time_, 2*sampling_time_, sampling_time_};
+  // the blend spheres must not overlap on the second trajectory
+  const double blend_radius {0.1};
+
+  std::vector<planning_interface::MotionPlanResponse> responses(requests.size());
+  for (size_t index=0; index < requests.size(); ++index)
+  {
+    if (index > 0)
+    {
+      moveit::core::robotStateToRobotStateMsg(responses[index-1].trajectory_->getLastWayPoint(),
+                                              requests[index].start_state);
+    }
+    ASSERT_TRUE(lin_generator_->generate(requests[index], responses[index], sampling_times[index]));
+  }
+
+  pilz::TrajectoryBlendRequest first_blend_req;
+  pilz::TrajectoryBlendResponse first_blend_res;
+  first_blend_req.group_name = planning_group_;
+  first_blend_req.link_name = target_link_;
+  first_blend_req.first_trajectory = responses[0].trajectory_;
+  first_blend_req.second_trajectory = responses[1].trajectory_;
+  first_blend_req.blend_radius = blend_radius;
+  ASSERT_TRUE(blender_->blend(first_blend_req, first_blend_res));
+
+  double remainder_sampling_time {0.};
+  ASSERT_TRUE(pilz::determineSamplingTime(first_blend_res.second_trajectory, 10e-5, remainder_sampling_time));
+  EXPECT_NEAR(2*sampling_time_, remainder_sampling_time, 10e-5);
+
+  pilz::TrajectoryBlendRequest second_blend_req;
+  pilz::TrajectoryBlendResponse second_blend_res;
+  second_blend_req.group_name = planning_group_;
+  second_blend_req.link_name = target_link_;
+  second_blend_req.first_trajectory = first_blend_res.second_trajectory;
+  second_blend_req.second_trajectory = responses[2].trajectory_;
+  second_blend_req.blend_radius = blend_radius;
+  ASSERT_TRUE(blender_->blend(second_blend_req, second_blend_res));
+  EXPECT_NEAR(sampling_time_, second_blend_res.blend_trajectory->getWayPointDurationFromPrevious(1), 10e-5);
+
+  for(const auto& blend : {std::make_pair(first_blend_req, first_blend_res),
+                           std::make_pair(second_blend_req, second_blend_res)})
+  {
+    moveit_msgs::RobotTrajectory traj_msg;
+    for(const auto& traj : {blend.second.first_trajectory, blend.second.blend_trajectory,
+                            blend.second.second_trajectory})
+    {
+      traj->getRobotTrajectoryMsg(traj_msg);
+      EXPECT_TRUE(testutils::checkJointTrajectory(traj_msg.joint_trajectory,
+                                                  planner_limits_.getJointLimitContainer()));
+    }
+    EXPECT_TRUE(testutils::checkBlendingJointSpaceContinuity(blend.second,
+                                                             joint_velocity_tolerance_,
+                                                             joint_acceleration_tolerance_));
+    EXPECT_TRUE(testutils::checkBlendingCartSpaceContinuity(blend.first, blend.second, planner_limits_));
+  }
 }
 
 /**
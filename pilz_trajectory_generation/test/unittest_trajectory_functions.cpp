@@ -743,101 +743,292 @@ TEST_P(TrajectoryFunctionsTestFlangeAndGripper, testGenerateJointTrajectoryWithI
 }
 
 /**
- * @brief Check that function determineAndCheckSamplingTime() returns 'false' if
- * both of the needed vectors have an incorrect vector size.
+ * @brief Check that function generateJointTrajectory() stops with error code
+ * PREEMPTED if the given cancellation token is cancelled.
  *
+ * Please note: Both function variants are tested in this test.
  *
  * Test Sequence:
- *    1. Call function with vectors of incorrect size.
+ *    1. Call function with a cancelled cancellation token.
  *
  * Expected Results:
- *    1. Function returns 'false'.
+ *    1. Function returns 'false', the error code is PREEMPTED and the joint trajectory is empty.
  */
-TEST_P(TrajectoryFunctionsTestFlangeAndGripper, testDetermineAndCheckSamplingTimeInvalidVectorSize)
+TEST_P(TrajectoryFunctionsTestFlangeAndGripper, testGenerateJointTrajectoryCancelled)
 {
-  robot_trajectory::RobotTrajectoryPtr first_trajectory =
-      std::make_shared<robot_trajectory::RobotTrajectory>(robot_model_, planning_group_);
-  robot_trajectory::RobotTrajectoryPtr second_trajectory =
-      std::make_shared<robot_trajectory::RobotTrajectory>(robot_model_, planning_group_);
-  double epsilon {0.0};
-  double sampling_time {0.0};
+  // Note: 'path' is deleted by KDL::Trajectory_Segment
+  KDL::Path_RoundedComposite* path = new KDL::Path_RoundedComposite(
+        0.2,0.01, new KDL::RotationalInterpolation_SingleAxis() );
+  path->Add(KDL::Frame(KDL::Rotation::RPY(0,0,0), KDL::Vector(-1,0,0)));
+  path->Finish();
+  // Note: 'velprof' is deleted by KDL::Trajectory_Segment
+  KDL::VelocityProfile* vel_prof = new KDL::VelocityProfile_Trap(0.5,0.1);
+  vel_prof->SetProfile(0,path->PathLength());
+  KDL::Trajectory_Segment kdl_trajectory(path, vel_prof);
 
-  robot_state::RobotState rstate(robot_model_);
-  first_trajectory->insertWayPoint(0, rstate, 0.1);
-  second_trajectory->insertWayPoint(0, rstate, 0.1);
+  pilz::JointLimitsContainer joint_limits;
+  std::map<std::string, double> initial_joint_position;
+  double sampling_time {0.1};
+  trajectory_msgs::JointTrajectory joint_trajectory;
+  moveit_msgs::MoveItErrorCodes error_code;
+  bool check_self_collision {false};
+
+  pilz::CancellationToken cancellation_token;
+  cancellation_token.cancel();
+
+  EXPECT_FALSE( pilz::generateJointTrajectory(robot_model_, joint_limits, kdl_trajectory, planning_group_, tcp_link_,
+                                              initial_joint_position, sampling_time, joint_trajectory,
+                                              error_code, check_self_collision, &cancellation_token) );
+  EXPECT_EQ(moveit_msgs::MoveItErrorCodes::PREEMPTED, error_code.val);
+  EXPECT_TRUE(joint_trajectory.points.empty());
+
+  std::map<std::string, double> initial_joint_velocity;
+
+  pilz::CartesianTrajectory cart_traj;
+  cart_traj.group_name = planning_group_;
+  cart_traj.link_name = tcp_link_;
+  pilz::CartesianTrajectoryPoint cart_traj_point;
+  cart_traj.points.push_back(cart_traj_point);
 
-  EXPECT_FALSE( pilz::determineAndCheckSamplingTime(first_trajectory,  second_trajectory, epsilon, sampling_time) );
+  error_code.val = moveit_msgs::MoveItErrorCodes::SUCCESS;
+  EXPECT_FALSE( pilz::generateJointTrajectory(robot_model_, joint_limits, cart_traj, planning_group_, tcp_link_,
+                                              initial_joint_position, initial_joint_velocity, joint_trajectory,
+                                              error_code, check_self_collision, &cancellation_token) );
+  EXPECT_EQ(moveit_msgs::MoveItErrorCodes::PREEMPTED, error_code.val);
+  EXPECT_TRUE(joint_trajectory.points.empty());
 }
 
 /**
- * @brief Check that function determineAndCheckSamplingTime() returns 'true' if
- * sampling time is correct.
- *
+ * @brief Check that function generateJointTrajectory() stops with error code
+ * TIMED_OUT if the given deadline is exceeded.
  *
  * Test Sequence:
- *    1. Call function with trajectories which do NOT violate sampling time.
+ *    1. Call function with a deadline in the past.
  *
  * Expected Results:
- *    1. Function returns 'true'.
+ *    1. Function returns 'false', the error code is TIMED_OUT and the joint trajectory is empty.
  */
-TEST_P(TrajectoryFunctionsTestFlangeAndGripper, testDetermineAndCheckSamplingTimeCorrectSamplingTime)
+TEST_P(TrajectoryFunctionsTestFlangeAndGripper, testGenerateJointTrajectoryDeadlineExceeded)
 {
-  robot_trajectory::RobotTrajectoryPtr first_trajectory =
-      std::make_shared<robot_trajectory::RobotTrajectory>(robot_model_, planning_group_);
-  robot_trajectory::RobotTrajectoryPtr second_trajectory =
-      std::make_shared<robot_trajectory::RobotTrajectory>(robot_model_, planning_group_);
-  double epsilon {0.0001};
-  double sampling_time {0.0};
-  double expected_sampling_time {0.1};
+  // Note: 'path' is deleted by KDL::Trajectory_Segment
+  KDL::Path_RoundedComposite* path = new KDL::Path_RoundedComposite(
+        0.2,0.01, new KDL::RotationalInterpolation_SingleAxis() );
+  path->Add(KDL::Frame(KDL::Rotation::RPY(0,0,0), KDL::Vector(-1,0,0)));
+  path->Finish();
+  // Note: 'velprof' is deleted by KDL::Trajectory_Segment
+  KDL::VelocityProfile* vel_prof = new KDL::VelocityProfile_Trap(0.5,0.1);
+  vel_prof->SetProfile(0,path->PathLength());
+  KDL::Trajectory_Segment kdl_trajectory(path, vel_prof);
 
-  robot_state::RobotState rstate(robot_model_);
-  first_trajectory->insertWayPoint(0, rstate, expected_sampling_time);
-  first_trajectory->insertWayPoint(1, rstate, expected_sampling_time);
+  pilz::JointLimitsContainer joint_limits;
+  std::map<std::string, double> initial_joint_position;
+  double sampling_time {0.1};
+  trajectory_msgs::JointTrajectory joint_trajectory;
+  moveit_msgs::MoveItErrorCodes error_code;
+  const ros::Time deadline {0, 1};
+
+  EXPECT_FALSE( pilz::generateJointTrajectory(robot_model_, joint_limits, kdl_trajectory, planning_group_, tcp_link_,
+                                              initial_joint_position, sampling_time, joint_trajectory,
+                                              error_code, false, nullptr, deadline) );
+  EXPECT_EQ(moveit_msgs::MoveItErrorCodes::TIMED_OUT, error_code.val);
+  EXPECT_TRUE(joint_trajectory.points.empty());
+}
+
+/**
+ * @brief Parametrized class for the tests of searchIntersectionPoint(), provides a trajectory
+ * whose tcp moves away from its start (rotation of the second joint).
+ */
+class TrajectoryFunctionsTestSearchIntersectionPoint: public TrajectoryFunctionsTestBase
+{
+protected:
+  void SetUp() override
+  {
+    TrajectoryFunctionsTestBase::SetUp();
+
+    trajectory_ = std::make_shared<robot_trajectory::RobotTrajectory>(robot_model_, planning_group_);
+    robot_state::RobotState rstate(robot_model_);
+    rstate.setToDefaultValues();
+    for(std::size_t i = 0; i < NUM_WAYPOINTS; ++i)
+    {
+      rstate.setVariablePosition(joint_names_.at(1), 0.1*i);
+      rstate.update();
+      trajectory_->addSuffixWayPoint(rstate, 0.1);
+    }
+  }
+
+  //! Returns the tcp position at the specified waypoint.
+  Eigen::Vector3d position(const std::size_t index) const
+  {
+    return trajectory_->getWayPoint(index).getFrameTransform(tcp_link_).translation();
+  }
+
+  //! Returns the radius between the distances of the specified waypoints to the center.
+  double radiusBetween(const Eigen::Vector3d& center, const std::size_t first, const std::size_t second) const
+  {
+    return 0.5 * ((position(first) - center).norm() + (position(second) - center).norm());
+  }
+
+  //! Checks the evaluated poses of the waypoints between the specified indices (including).
+  void expectPoses(const pilz::LinkPoses& poses, const std::size_t first, const std::size_t last) const
+  {
+    ASSERT_EQ(trajectory_->getWayPointCount(), poses.translations.size());
+    ASSERT_EQ(trajectory_->getWayPointCount(), poses.orientations.size());
+    for(std::size_t i = first; i <= last; ++i)
+    {
+      const Eigen::Isometry3d expected_pose {trajectory_->getWayPoint(i).getFrameTransform(tcp_link_)};
+      Eigen::Isometry3d actual_pose {Eigen::Isometry3d::Identity()};
+      actual_pose.translation() = poses.translations.at(i);
+      actual_pose.linear() = poses.orientations.at(i).toRotationMatrix();
+      EXPECT_TRUE(tfNear(expected_pose, actual_pose, EPSILON)) << "Pose of waypoint " << i << " differs";
+    }
+  }
+
+protected:
+  static constexpr std::size_t NUM_WAYPOINTS {10};
+  robot_trajectory::RobotTrajectoryPtr trajectory_;
+};
+
+constexpr std::size_t TrajectoryFunctionsTestSearchIntersectionPoint::NUM_WAYPOINTS;
+
+// Instantiate the test cases for robot model with and without gripper
+INSTANTIATE_TEST_CASE_P(InstantiationName, TrajectoryFunctionsTestSearchIntersectionPoint, ::testing::Values(
+                          PARAM_MODEL_NO_GRIPPER_NAME,
+                          PARAM_MODEL_WITH_GRIPPER_NAME
+                          ));
+
+/**
+ * @brief Check that searchIntersectionPoint() finds the intersection when searching from the
+ * start of the trajectory (sphere center at the first waypoint).
+ *
+ * Expected Results:
+ *    1. The index of the last waypoint inside of the sphere is returned.
+ *    2. The poses of all waypoints up to the first waypoint outside of the sphere are evaluated.
+ */
+TEST_P(TrajectoryFunctionsTestSearchIntersectionPoint, testSearchIntersectionPointForward)
+{
+  const Eigen::Vector3d center {position(0)};
+  pilz::LinkPoses poses;
+  std::size_t index {0};
+  ASSERT_TRUE(pilz::searchIntersectionPoint(*trajectory_, tcp_link_, center, radiusBetween(center, 3, 4),
+                                            false, poses, index));
+  EXPECT_EQ(3u, index);
+  expectPoses(poses, 0, 4);
+}
+
+/**
+ * @brief Check that searchIntersectionPoint() finds the intersection when searching from the
+ * end of the trajectory (sphere center at the last waypoint).
+ *
+ * Expected Results:
+ *    1. The index of the last waypoint inside of the sphere (counted from the end) is returned.
+ *    2. The poses of all waypoints from the first waypoint outside of the sphere up to the end are evaluated.
+ */
+TEST_P(TrajectoryFunctionsTestSearchIntersectionPoint, testSearchIntersectionPointInverse)
+{
+  const std::size_t last {NUM_WAYPOINTS - 1};
+  const Eigen::Vector3d center {position(last)};
+  pilz::LinkPoses poses;
+  std::size_t index {0};
+  ASSERT_TRUE(pilz::searchIntersectionPoint(*trajectory_, tcp_link_, center, radiusBetween(center, last - 3, last - 4),
+                                            true, poses, index));
+  EXPECT_EQ(last - 3, index);
+  expectPoses(poses, last - 4, last);
+}
+
+/**
+ * @brief Check that searchIntersectionPoint() finds an intersection exactly at the last waypoint
+ * in both search directions.
+ *
+ * Expected Results:
+ *    1. The index of the waypoint before the last visited waypoint is returned.
+ *    2. The poses of all waypoints are evaluated.
+ */
+TEST_P(TrajectoryFunctionsTestSearchIntersectionPoint, testSearchIntersectionPointAtLastSample)
+{
+  const std::size_t last {NUM_WAYPOINTS - 1};
+  pilz::LinkPoses poses;
+  std::size_t index {0};
+
+  const Eigen::Vector3d forward_center {position(0)};
+  ASSERT_TRUE(pilz::searchIntersectionPoint(*trajectory_, tcp_link_, forward_center,
+                                            (position(last) - forward_center).norm(), false, poses, index));
+  EXPECT_EQ(last - 1, index);
+  expectPoses(poses, 0, last);
+
+  const Eigen::Vector3d inverse_center {position(last)};
+  ASSERT_TRUE(pilz::searchIntersectionPoint(*trajectory_, tcp_link_, inverse_center,
+                                            (position(0) - inverse_center).norm(), true, poses, index));
+  EXPECT_EQ(1u, index);
+  expectPoses(poses, 0, last);
+}
+
+/**
+ * @brief Check that searchIntersectionPoint() returns false if the trajectory does not leave the sphere
+ * or has less than two waypoints.
+ */
+TEST_P(TrajectoryFunctionsTestSearchIntersectionPoint, testSearchIntersectionPointNoIntersection)
+{
+  const std::size_t last {NUM_WAYPOINTS - 1};
+  pilz::LinkPoses poses;
+  std::size_t index {0};
 
-  second_trajectory->insertWayPoint(0, rstate, expected_sampling_time);
-  second_trajectory->insertWayPoint(1, rstate, expected_sampling_time);
-  second_trajectory->insertWayPoint(2, rstate, expected_sampling_time);
+  const double radius {2. * (position(last) - position(0)).norm()};
+  EXPECT_FALSE(pilz::searchIntersectionPoint(*trajectory_, tcp_link_, position(0), radius, false, poses, index));
+  EXPECT_FALSE(pilz::searchIntersectionPoint(*trajectory_, tcp_link_, position(last), radius, true, poses, index));
 
-  EXPECT_TRUE( pilz::determineAndCheckSamplingTime(first_trajectory,  second_trajectory, epsilon, sampling_time) );
-  EXPECT_EQ(expected_sampling_time, sampling_time);
+  robot_trajectory::RobotTrajectory single_waypoint(robot_model_, planning_group_);
+  single_waypoint.addSuffixWayPoint(trajectory_->getFirstWayPoint(), 0.1);
+  EXPECT_FALSE(pilz::searchIntersectionPoint(single_waypoint, tcp_link_, position(0), 0.01, false, poses, index));
 }
 
 /**
- * @brief Check that function determineAndCheckSamplingTime() returns 'false' if
- * sampling time is violated.
+ * @brief Check that function sampleTrajectory() interpolates the positions, velocities and
+ * accelerations consistently between the enclosing waypoints.
  *
  *
  * Test Sequence:
- *    1. Call function with trajectories which violate sampling time.
+ *    1. Create trajectory with two waypoints of the cubic motion q(t) = t^3 of all joints.
+ *    2. Sample trajectory at the waypoints, in between and after the end.
  *
  * Expected Results:
- *    1. Function returns 'false'.
+ *    1. Trajectory created.
+ *    2. The samples at the waypoints and after the end equal the waypoints,
+ *       the sample in between lies on the cubic motion (a linear interpolation of the
+ *       positions would not).
  */
-TEST_P(TrajectoryFunctionsTestFlangeAndGripper, testDetermineAndCheckSamplingTimeViolateSamplingTime)
+TEST_P(TrajectoryFunctionsTestFlangeAndGripper, testSampleTrajectory)
 {
-  robot_trajectory::RobotTrajectoryPtr first_trajectory =
+  robot_trajectory::RobotTrajectoryPtr trajectory =
       std::make_shared<robot_trajectory::RobotTrajectory>(robot_model_, planning_group_);
-  robot_trajectory::RobotTrajectoryPtr second_trajectory =
-      std::make_shared<robot_trajectory::RobotTrajectory>(robot_model_, planning_group_);
-  double epsilon {0.0001};
-  double sampling_time {0.0};
-  double expected_sampling_time {0.1};
 
-  robot_state::RobotState rstate(robot_model_);
-  first_trajectory->insertWayPoint(0, rstate, expected_sampling_time);
-  first_trajectory->insertWayPoint(1, rstate, expected_sampling_time);
-  first_trajectory->insertWayPoint(2, rstate, expected_sampling_time);
-  // Violate sampling time
-  first_trajectory->insertWayPoint(2, rstate, expected_sampling_time + 1.0);
-  first_trajectory->insertWayPoint(3, rstate, expected_sampling_time);
-
-  second_trajectory->insertWayPoint(0, rstate, expected_sampling_time);
-  second_trajectory->insertWayPoint(1, rstate, expected_sampling_time);
-  second_trajectory->insertWayPoint(2, rstate, expected_sampling_time);
-  second_trajectory->insertWayPoint(3, rstate, expected_sampling_time);
-
-  EXPECT_FALSE( pilz::determineAndCheckSamplingTime(first_trajectory,  second_trajectory, epsilon, sampling_time) );
-  EXPECT_EQ(expected_sampling_time, sampling_time);
+  robot_state::RobotState rstate_1(robot_model_);
+  rstate_1.setToDefaultValues();
+  robot_state::RobotState rstate_2(rstate_1);
+  // q(t) = t^3 at t = 1 and t = 2
+  const std::size_t num_joints {robot_model_->getJointModelGroup(planning_group_)->getActiveJointModels().size()};
+  rstate_1.setJointGroupPositions(planning_group_, std::vector<double>(num_joints, 1.0));
+  rstate_1.setJointGroupVelocities(planning_group_, std::vector<double>(num_joints, 3.0));
+  rstate_1.setJointGroupAccelerations(planning_group_, std::vector<double>(num_joints, 6.0));
+  rstate_2.setJointGroupPositions(planning_group_, std::vector<double>(num_joints, 8.0));
+  rstate_2.setJointGroupVelocities(planning_group_, std::vector<double>(num_joints, 12.0));
+  rstate_2.setJointGroupAccelerations(planning_group_, std::vector<double>(num_joints, 12.0));
+  trajectory->addSuffixWayPoint(rstate_1, 0.0);
+  trajectory->addSuffixWayPoint(rstate_2, 1.0);
+
+  std::vector<robot_state::RobotStatePtr> states;
+  pilz::sampleTrajectory(*trajectory, planning_group_, {0.0, 0.5, 1.0, 2.0}, states);
+  ASSERT_EQ(4u, states.size());
+
+  // q(1.5), q'(1.5) and q''(1.5)
+  robot_state::RobotState rstate_between(rstate_1);
+  rstate_between.setJointGroupPositions(planning_group_, std::vector<double>(num_joints, 3.375));
+  rstate_between.setJointGroupVelocities(planning_group_, std::vector<double>(num_joints, 6.75));
+  rstate_between.setJointGroupAccelerations(planning_group_, std::vector<double>(num_joints, 9.0));
+
+  EXPECT_TRUE(pilz::isRobotStateEqual(rstate_1, *states.at(0), planning_group_, EPSILON));
+  EXPECT_TRUE(pilz::isRobotStateEqual(rstate_between, *states.at(1), planning_group_, EPSILON));
+  EXPECT_TRUE(pilz::isRobotStateEqual(rstate_2, *states.at(2), planning_group_, EPSILON));
+  EXPECT_TRUE(pilz::isRobotStateEqual(rstate_2, *states.at(3), planning_group_, EPSILON));
 }
 
 /**
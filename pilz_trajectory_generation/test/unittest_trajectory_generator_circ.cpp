@@ -641,6 +641,24 @@ TEST_P(TrajectoryGeneratorCIRCTest, CenterPointPoseGoal)
   checkCircResult(req, res);
 }
 
+/**
+ * @brief Checks that the planning does not change the global KDL::epsilon
+ * (which would be a data race with concurrent planning requests).
+ */
+TEST_P(TrajectoryGeneratorCIRCTest, KdlEpsilonUnchanged)
+{
+  const double kdl_epsilon {KDL::epsilon};
+
+  auto circ {tdp_->getCircCartCenterCart("circ1_center_2")};
+  planning_interface::MotionPlanResponse res;
+  ASSERT_TRUE(circ_->generate(circ.toRequest(), res));
+  EXPECT_EQ(kdl_epsilon, KDL::epsilon);
+
+  auto circ_interim {tdp_->getCircCartInterimCart("circ3_interim")};
+  ASSERT_TRUE(circ_->generate(circ_interim.toRequest(), res));
+  EXPECT_EQ(kdl_epsilon, KDL::epsilon);
+}
+
 /**
  * @brief Set a frame id only on the position constrainst
  */
@@ -15,6 +15,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <memory>
 
 #include <gtest/gtest.h>
@@ -477,6 +478,48 @@ TEST_P(TrajectoryGeneratorPTPTest, testJointGoalAlreadyReached)
   EXPECT_EQ(1u,res_msg.trajectory.joint_trajectory.points.size());
 }
 
+/**
+ * @brief test that the last way point of a ptp trajectory is located exactly at the joint goal
+ * (without deviations of the velocity profile), so that the end state is known before planning
+ */
+TEST_P(TrajectoryGeneratorPTPTest, testLastWayPointExactlyAtJointGoal)
+{
+  planning_interface::MotionPlanResponse res;
+  planning_interface::MotionPlanRequest req;
+  testutils::createDummyRequest(robot_model_, planning_group_, req);
+  req.start_state.joint_state.position[1] = 0.1;
+
+  moveit_msgs::Constraints gc;
+  moveit_msgs::JointConstraint jc;
+  const std::vector<std::string>& joint_names {
+    robot_model_->getJointModelGroup(planning_group_)->getActiveJointModelNames()};
+  for(std::size_t i = 0; i < joint_names.size(); ++i)
+  {
+    jc.joint_name = joint_names.at(i);
+    jc.position = 0.1234567 * static_cast<double>(i + 1) / 3.;
+    gc.joint_constraints.push_back(jc);
+  }
+  req.goal_constraints.push_back(gc);
+
+  ASSERT_TRUE(ptp_->generate(req,res));
+  EXPECT_EQ(res.error_code_.val, moveit_msgs::MoveItErrorCodes::SUCCESS);
+
+  moveit_msgs::MotionPlanResponse res_msg;
+  res.getMessage(res_msg);
+  const trajectory_msgs::JointTrajectory& joint_trajectory {res_msg.trajectory.joint_trajectory};
+  ASSERT_GT(joint_trajectory.points.size(), 1u);
+  for(const auto& joint_constraint : gc.joint_constraints)
+  {
+    auto it {std::find(joint_trajectory.joint_names.begin(), joint_trajectory.joint_names.end(),
+                       joint_constraint.joint_name)};
+    ASSERT_NE(it, joint_trajectory.joint_names.end());
+    const std::size_t index {static_cast<std::size_t>(it - joint_trajectory.joint_names.begin())};
+    EXPECT_EQ(joint_constraint.position, joint_trajectory.points.back().positions.at(index));
+    EXPECT_EQ(0., joint_trajectory.points.back().velocities.at(index));
+    EXPECT_EQ(0., joint_trajectory.points.back().accelerations.at(index));
+  }
+}
+
 /**
  * @brief test scaling factor
  * with zero start velocity
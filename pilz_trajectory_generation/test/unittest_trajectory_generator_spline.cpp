@@ -0,0 +1,563 @@
+/*
+ * Copyright (c) 2018 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+
+#include <gtest/gtest.h>
+
+#include "pilz_trajectory_generation/trajectory_generator_spline.h"
+#include "pilz_trajectory_generation/joint_limits_aggregator.h"
+#include "test_utils.h"
+#include "pilz_industrial_motion_testutils/xml_testdata_loader.h"
+#include "pilz_industrial_motion_testutils/command_types_typedef.h"
+
+#include <moveit/robot_model_loader/robot_model_loader.h>
+#include <moveit/robot_model/robot_model.h>
+#include <moveit/robot_state/robot_state.h>
+#include <moveit/robot_state/conversions.h>
+#include <eigen_conversions/eigen_msg.h>
+
+#include <ros/console.h>
+
+const std::string PARAM_MODEL_NO_GRIPPER_NAME {"robot_description"};
+const std::string PARAM_MODEL_WITH_GRIPPER_NAME {"robot_description_pg70"};
+
+//parameters from parameter server
+const std::string TEST_DATA_FILE_NAME("testdata_file_name");
+const std::string PARAM_PLANNING_GROUP_NAME("planning_group");
+const std::string TARGET_LINK_HCD("target_link_hand_computed_data");
+const std::string POSE_TRANSFORM_MATRIX_NORM_TOLERANCE("pose_norm_tolerance");
+const std::string OTHER_TOLERANCE("other_tolerance");
+
+//! Minimal distance between consecutive waypoints (see TrajectoryGeneratorSPLINE).
+static constexpr double MIN_WAYPOINT_DISTANCE {1e-5};
+
+using namespace pilz;
+using namespace pilz_industrial_motion_testutils;
+
+/**
+ * @brief Parameterized unittest of trajectory generator SPLINE to enable tests against
+ * different robot models.The parameter is the name of robot model parameter on the
+ * ros parameter server.
+ */
+class TrajectoryGeneratorSPLINETest: public testing::TestWithParam<std::string>
+{
+protected:
+
+  /**
+   * @brief Create test scenario for spline trajectory generator
+   *
+   */
+  void SetUp() override;
+
+  /**
+   * @brief Creates a SPLINE request from the start to the goal of "lin2" with one
+   * waypoint besides the straight line (with the orientation of the goal).
+   */
+  planning_interface::MotionPlanRequest createSplineRequest() const;
+
+  //! Returns the poses the path of the request passes through (start, waypoints, goal).
+  PoseBuffer getPathPoses(const planning_interface::MotionPlanRequest& req) const;
+
+  //! Returns the maximal translational velocity of the link of the request along the trajectory.
+  double getMaxTranslationalVelocity(const planning_interface::MotionPlanRequest& req,
+                                     const robot_trajectory::RobotTrajectory& trajectory) const;
+
+protected:
+  // ros stuff
+  ros::NodeHandle ph_ {"~"};
+  robot_model::RobotModelConstPtr robot_model_ {
+    robot_model_loader::RobotModelLoader(GetParam()).getModel()};
+
+  // spline trajectory generator using model without gripper
+  std::unique_ptr<TrajectoryGenerator> spline_;
+  // test data provider
+  std::unique_ptr<pilz_industrial_motion_testutils::TestdataLoader> tdp_;
+
+  // test parameters from parameter server
+  std::string planning_group_, target_link_hcd_, test_data_file_name_;
+  double pose_norm_tolerance_, other_tolerance_;
+  LimitsContainer planner_limits_;
+
+};
+
+void TrajectoryGeneratorSPLINETest::SetUp()
+{
+  // get the parameters
+  ASSERT_TRUE(ph_.getParam(TEST_DATA_FILE_NAME, test_data_file_name_));
+  ASSERT_TRUE(ph_.getParam(PARAM_PLANNING_GROUP_NAME, planning_group_));
+  ASSERT_TRUE(ph_.getParam(TARGET_LINK_HCD, target_link_hcd_));
+  ASSERT_TRUE(ph_.getParam(POSE_TRANSFORM_MATRIX_NORM_TOLERANCE, pose_norm_tolerance_));
+  ASSERT_TRUE(ph_.getParam(OTHER_TOLERANCE, other_tolerance_));
+
+  testutils::checkRobotModel(robot_model_, planning_group_, target_link_hcd_);
+
+  // load the test data provider
+  tdp_.reset(new pilz_industrial_motion_testutils::XmlTestdataLoader{test_data_file_name_});
+  ASSERT_NE(nullptr, tdp_) << "Failed to load test data by provider.";
+
+  tdp_->setRobotModel(robot_model_);
+
+  // create the limits container
+  pilz::JointLimitsContainer joint_limits =
+      pilz::JointLimitsAggregator::getAggregatedLimits(ph_, robot_model_->getActiveJointModels());
+  CartesianLimit cart_limits;
+  cart_limits.setMaxRotationalVelocity(0.5*M_PI);
+  cart_limits.setMaxTranslationalAcceleration(2);
+  cart_limits.setMaxTranslationalDeceleration(2);
+  cart_limits.setMaxTranslationalVelocity(1);
+  planner_limits_.setJointLimits(joint_limits);
+  planner_limits_.setCartesianLimits(cart_limits);
+
+  // initialize the SPLINE trajectory generator
+  spline_.reset(new TrajectoryGeneratorSPLINE(robot_model_, planner_limits_));
+  ASSERT_NE(nullptr, spline_) << "Failed to create SPLINE trajectory generator.";
+}
+
+planning_interface::MotionPlanRequest TrajectoryGeneratorSPLINETest::createSplineRequest() const
+{
+  planning_interface::MotionPlanRequest req {tdp_->getLinCart("lin2").toRequest()};
+  req.planner_id = "SPLINE";
+
+  const moveit_msgs::PositionConstraint& goal_position {req.goal_constraints.front().position_constraints.front()};
+  const moveit_msgs::OrientationConstraint& goal_orientation {
+    req.goal_constraints.front().orientation_constraints.front()};
+
+  PoseBuffer poses {getPathPoses(req)};
+  const Eigen::Vector3d start {poses.front().translation()};
+  const Eigen::Vector3d goal {poses.back().translation()};
+
+  // waypoint besides the middle of the straight line
+  moveit_msgs::PositionConstraint waypoint_position;
+  waypoint_position.link_name = goal_position.link_name;
+  waypoint_position.header.frame_id = robot_model_->getModelFrame();
+  geometry_msgs::Pose waypoint_pose;
+  tf::pointEigenToMsg(0.5 * (start + goal) + Eigen::Vector3d(0.05, -0.05, 0.), waypoint_pose.position);
+  waypoint_pose.orientation = goal_orientation.orientation;
+  waypoint_position.constraint_region.primitive_poses.push_back(waypoint_pose);
+  req.path_constraints.position_constraints.push_back(waypoint_position);
+
+  moveit_msgs::OrientationConstraint waypoint_orientation;
+  waypoint_orientation.link_name = goal_position.link_name;
+  waypoint_orientation.header.frame_id = robot_model_->getModelFrame();
+  waypoint_orientation.orientation = goal_orientation.orientation;
+  req.path_constraints.orientation_constraints.push_back(waypoint_orientation);
+
+  return req;
+}
+
+PoseBuffer TrajectoryGeneratorSPLINETest::getPathPoses(const planning_interface::MotionPlanRequest& req) const
+{
+  const std::string& link_name {req.goal_constraints.front().position_constraints.front().link_name};
+
+  robot_state::RobotState start_state(robot_model_);
+  start_state.setToDefaultValues();
+  moveit::core::jointStateToRobotState(req.start_state.joint_state, start_state);
+  start_state.update();
+
+  PoseBuffer poses;
+  poses.push_back(start_state.getFrameTransform(link_name));
+  for(std::size_t i = 0; i < req.path_constraints.position_constraints.size(); ++i)
+  {
+    geometry_msgs::Pose pose_msg;
+    pose_msg.position = req.path_constraints.position_constraints.at(i).constraint_region.primitive_poses.front().position;
+    pose_msg.orientation = req.path_constraints.orientation_constraints.at(i).orientation;
+    normalizeQuaternion(pose_msg.orientation);
+    Eigen::Isometry3d pose;
+    tf::poseMsgToEigen(pose_msg, pose);
+    poses.push_back(pose);
+  }
+
+  geometry_msgs::Pose goal_msg;
+  goal_msg.position = req.goal_constraints.front().position_constraints.front()
+      .constraint_region.primitive_poses.front().position;
+  goal_msg.orientation = req.goal_constraints.front().orientation_constraints.front().orientation;
+  normalizeQuaternion(goal_msg.orientation);
+  Eigen::Isometry3d goal;
+  tf::poseMsgToEigen(goal_msg, goal);
+  poses.push_back(goal);
+  return poses;
+}
+
+double TrajectoryGeneratorSPLINETest::getMaxTranslationalVelocity(const planning_interface::MotionPlanRequest& req,
+                                                                  const robot_trajectory::RobotTrajectory& trajectory) const
+{
+  const std::string& link_name {req.goal_constraints.front().position_constraints.front().link_name};
+
+  double max_velocity {0.};
+  for(std::size_t i = 1; i < trajectory.getWayPointCount(); ++i)
+  {
+    robot_state::RobotState state_before {trajectory.getWayPoint(i - 1)};
+    robot_state::RobotState state {trajectory.getWayPoint(i)};
+    state_before.update();
+    state.update();
+    const double distance {(state.getFrameTransform(link_name).translation()
+                            - state_before.getFrameTransform(link_name).translation()).norm()};
+    max_velocity = std::max(max_velocity, distance / trajectory.getWayPointDurationFromPrevious(i));
+  }
+  return max_velocity;
+}
+
+/**
+ * @brief Checks that each derived MoveItErrorCodeException contains the correct
+ * error code.
+ */
+TEST(TrajectoryGeneratorSPLINETest, TestExceptionErrorCodeMapping)
+{
+  {
+    std::shared_ptr<SplineTrajectoryConversionFailure> stcf_ex {new SplineTrajectoryConversionFailure("")};
+    EXPECT_EQ(stcf_ex->getErrorCode(), moveit_msgs::MoveItErrorCodes::FAILURE);
+  }
+
+  {
+    std::shared_ptr<WaypointOrientationMissing> wom_ex {new WaypointOrientationMissing("")};
+    EXPECT_EQ(wom_ex->getErrorCode(), moveit_msgs::MoveItErrorCodes::INVALID_MOTION_PLAN);
+  }
+
+  {
+    std::shared_ptr<NoWaypointPrimitivePose> nwpp_ex {new NoWaypointPrimitivePose("")};
+    EXPECT_EQ(nwpp_ex->getErrorCode(), moveit_msgs::MoveItErrorCodes::INVALID_MOTION_PLAN);
+  }
+
+  {
+    std::shared_ptr<WaypointsTooClose> wtc_ex {new WaypointsTooClose("")};
+    EXPECT_EQ(wtc_ex->getErrorCode(), moveit_msgs::MoveItErrorCodes::INVALID_MOTION_PLAN);
+  }
+
+  {
+    std::shared_ptr<WaypointLinkNameMismatch> wlnm_ex {new WaypointLinkNameMismatch("")};
+    EXPECT_EQ(wlnm_ex->getErrorCode(), moveit_msgs::MoveItErrorCodes::INVALID_LINK_NAME);
+  }
+
+  {
+    std::shared_ptr<SplineJointNumberMismatch> sjnm_ex {new SplineJointNumberMismatch("")};
+    EXPECT_EQ(sjnm_ex->getErrorCode(), moveit_msgs::MoveItErrorCodes::INVALID_GOAL_CONSTRAINTS);
+  }
+
+  {
+    std::shared_ptr<SplineJointMissingInStartState> sjmiss_ex {new SplineJointMissingInStartState("")};
+    EXPECT_EQ(sjmiss_ex->getErrorCode(), moveit_msgs::MoveItErrorCodes::INVALID_ROBOT_STATE);
+  }
+
+  {
+    std::shared_ptr<SplineInverseForGoalIncalculable> sifgi_ex {new SplineInverseForGoalIncalculable("")};
+    EXPECT_EQ(sifgi_ex->getErrorCode(), moveit_msgs::MoveItErrorCodes::NO_IK_SOLUTION);
+  }
+}
+
+// Instantiate the test cases for robot model with and without gripper
+INSTANTIATE_TEST_CASE_P(InstantiationName, TrajectoryGeneratorSPLINETest, ::testing::Values(
+                          PARAM_MODEL_NO_GRIPPER_NAME,
+                          PARAM_MODEL_WITH_GRIPPER_NAME
+                          ));
+
+/**
+ * @brief Checks that constructor throws an exception if no limits are given.
+ *
+ * Test Sequence:
+ *    1. Call Ctor without set limits.
+ *
+ * Expected Results:
+ *    1. Ctor throws exception.
+ */
+TEST_P(TrajectoryGeneratorSPLINETest, CtorNoLimits)
+{
+  pilz::LimitsContainer planner_limits;
+
+  EXPECT_THROW(pilz::TrajectoryGeneratorSPLINE(robot_model_, planner_limits),
+               pilz::TrajectoryGeneratorInvalidLimitsException);
+}
+
+/**
+ * @brief test the spline planner with Cartesian goal and one waypoint
+ *
+ * Test Sequence:
+ *    1. Generate spline trajectory through one waypoint.
+ *
+ * Expected Results:
+ *    1. Trajectory generation is successful, the goal is reached, the trajectory
+ *       passes the waypoint and respects the joint limits.
+ */
+TEST_P(TrajectoryGeneratorSPLINETest, cartesianSpaceGoalWithWaypoint)
+{
+  planning_interface::MotionPlanRequest req {createSplineRequest()};
+
+  planning_interface::MotionPlanResponse res;
+  ASSERT_TRUE(spline_->generate(req, res, 0.01));
+  EXPECT_EQ(res.error_code_.val, moveit_msgs::MoveItErrorCodes::SUCCESS);
+
+  moveit_msgs::MotionPlanResponse res_msg;
+  res.getMessage(res_msg);
+  EXPECT_TRUE(testutils::isGoalReached(robot_model_, res_msg.trajectory.joint_trajectory, req, pose_norm_tolerance_));
+  EXPECT_TRUE(testutils::checkJointTrajectory(res_msg.trajectory.joint_trajectory,
+                                              planner_limits_.getJointLimitContainer()));
+
+  // the samples are about 1mm apart, one of them is located at the waypoint
+  const std::string& link_name {req.path_constraints.position_constraints.front().link_name};
+  Eigen::Vector3d waypoint;
+  tf::pointMsgToEigen(req.path_constraints.position_constraints.front().constraint_region.primitive_poses.front()
+                      .position, waypoint);
+  double min_distance {std::numeric_limits<double>::infinity()};
+  for(std::size_t i = 0; i < res.trajectory_->getWayPointCount(); ++i)
+  {
+    robot_state::RobotState state {res.trajectory_->getWayPoint(i)};
+    state.update();
+    min_distance = std::min(min_distance, (state.getFrameTransform(link_name).translation() - waypoint).norm());
+  }
+  EXPECT_LT(min_distance, 1e-3);
+
+  // check last point for vel=acc=0
+  for(size_t idx = 0; idx < res.trajectory_->getLastWayPointPtr()->getVariableCount(); ++idx)
+  {
+    EXPECT_NEAR(0.0, res.trajectory_->getLastWayPointPtr()->getVariableVelocity(idx), other_tolerance_);
+    EXPECT_NEAR(0.0, res.trajectory_->getLastWayPointPtr()->getVariableAcceleration(idx), other_tolerance_);
+  }
+}
+
+/**
+ * @brief test the spline planner with joint goal and without waypoints
+ *
+ * Test Sequence:
+ *    1. Generate spline trajectory with joint goal and without waypoints.
+ *
+ * Expected Results:
+ *    1. Trajectory generation is successful, the goal is reached.
+ */
+TEST_P(TrajectoryGeneratorSPLINETest, jointSpaceGoalWithoutWaypoints)
+{
+  planning_interface::MotionPlanRequest req {tdp_->getLinJoint("lin2").toRequest()};
+  req.planner_id = "SPLINE";
+
+  planning_interface::MotionPlanResponse res;
+  ASSERT_TRUE(spline_->generate(req, res));
+  EXPECT_EQ(res.error_code_.val, moveit_msgs::MoveItErrorCodes::SUCCESS);
+
+  moveit_msgs::MotionPlanResponse res_msg;
+  res.getMessage(res_msg);
+  EXPECT_TRUE(testutils::isGoalReached(robot_model_, res_msg.trajectory.joint_trajectory, req, pose_norm_tolerance_));
+}
+
+/**
+ * @brief Checks that a waypoint without orientation constraint is rejected.
+ *
+ * Test Sequence:
+ *    1. Remove the orientation constraint of the waypoint.
+ *
+ * Expected Results:
+ *    1. Function returns 'false' with INVALID_MOTION_PLAN (WaypointOrientationMissing).
+ */
+TEST_P(TrajectoryGeneratorSPLINETest, WaypointOrientationMissing)
+{
+  planning_interface::MotionPlanRequest req {createSplineRequest()};
+  req.path_constraints.orientation_constraints.clear();
+
+  planning_interface::MotionPlanResponse res;
+  EXPECT_FALSE(spline_->generate(req, res));
+  EXPECT_EQ(res.error_code_.val, moveit_msgs::MoveItErrorCodes::INVALID_MOTION_PLAN);
+}
+
+/**
+ * @brief Checks that a waypoint without primitive pose is rejected.
+ *
+ * Test Sequence:
+ *    1. Remove the primitive pose of the waypoint.
+ *
+ * Expected Results:
+ *    1. Function returns 'false' with INVALID_MOTION_PLAN (NoWaypointPrimitivePose).
+ */
+TEST_P(TrajectoryGeneratorSPLINETest, NoWaypointPrimitivePose)
+{
+  planning_interface::MotionPlanRequest req {createSplineRequest()};
+  req.path_constraints.position_constraints.front().constraint_region.primitive_poses.clear();
+
+  planning_interface::MotionPlanResponse res;
+  EXPECT_FALSE(spline_->generate(req, res));
+  EXPECT_EQ(res.error_code_.val, moveit_msgs::MoveItErrorCodes::INVALID_MOTION_PLAN);
+}
+
+/**
+ * @brief Checks that waypoints whose constraints refer to different links are rejected.
+ *
+ * Test Sequence:
+ *    1. Set a different link for the orientation constraint of the waypoint.
+ *    2. Set a link different from the goal link for both constraints of the waypoint.
+ *
+ * Expected Results:
+ *    1. Function returns 'false' with INVALID_LINK_NAME (WaypointLinkNameMismatch).
+ *    2. Function returns 'false' with INVALID_LINK_NAME (WaypointLinkNameMismatch).
+ */
+TEST_P(TrajectoryGeneratorSPLINETest, WaypointLinkNameMismatch)
+{
+  const std::string other_link {robot_model_->getJointModelGroup(planning_group_)->getLinkModelNames().front()};
+  {
+    planning_interface::MotionPlanRequest req {createSplineRequest()};
+    ASSERT_NE(other_link, req.path_constraints.orientation_constraints.front().link_name);
+    req.path_constraints.orientation_constraints.front().link_name = other_link;
+
+    planning_interface::MotionPlanResponse res;
+    EXPECT_FALSE(spline_->generate(req, res));
+    EXPECT_EQ(res.error_code_.val, moveit_msgs::MoveItErrorCodes::INVALID_LINK_NAME);
+  }
+
+  {
+    planning_interface::MotionPlanRequest req {createSplineRequest()};
+    req.path_constraints.position_constraints.front().link_name = other_link;
+    req.path_constraints.orientation_constraints.front().link_name = other_link;
+
+    planning_interface::MotionPlanResponse res;
+    EXPECT_FALSE(spline_->generate(req, res));
+    EXPECT_EQ(res.error_code_.val, moveit_msgs::MoveItErrorCodes::INVALID_LINK_NAME);
+  }
+}
+
+/**
+ * @brief Checks that a waypoint at the position of the goal is rejected.
+ *
+ * Test Sequence:
+ *    1. Move the waypoint to the position of the goal.
+ *
+ * Expected Results:
+ *    1. Function returns 'false' with INVALID_MOTION_PLAN (WaypointsTooClose).
+ */
+TEST_P(TrajectoryGeneratorSPLINETest, WaypointsTooClose)
+{
+  planning_interface::MotionPlanRequest req {createSplineRequest()};
+  req.path_constraints.position_constraints.front().constraint_region.primitive_poses.front().position =
+      req.goal_constraints.front().position_constraints.front().constraint_region.primitive_poses.front().position;
+
+  planning_interface::MotionPlanResponse res;
+  EXPECT_FALSE(spline_->generate(req, res));
+  EXPECT_EQ(res.error_code_.val, moveit_msgs::MoveItErrorCodes::INVALID_MOTION_PLAN);
+}
+
+/**
+ * @brief test invalid motion plan request with incomplete start state
+ *
+ * Test Sequence:
+ *    1. Remove all but one joint from the start state.
+ *
+ * Expected Results:
+ *    1. Function returns 'false' with INVALID_ROBOT_STATE (SplineJointMissingInStartState).
+ */
+TEST_P(TrajectoryGeneratorSPLINETest, SplineJointMissingInStartState)
+{
+  planning_interface::MotionPlanRequest req {createSplineRequest()};
+  EXPECT_GT(req.start_state.joint_state.name.size(), 1u);
+  req.start_state.joint_state.name.resize(1);
+  req.start_state.joint_state.position.resize(1); // prevent failing check for equal sizes
+
+  planning_interface::MotionPlanResponse res;
+  EXPECT_FALSE(spline_->generate(req, res));
+  EXPECT_EQ(res.error_code_.val, moveit_msgs::MoveItErrorCodes::INVALID_ROBOT_STATE);
+}
+
+/**
+ * @brief Checks that the velocity is reduced in the curve, so that the centripetal
+ * acceleration does not exceed the Cartesian acceleration limit.
+ *
+ * Test Sequence:
+ *    1. Generate spline trajectory with full velocity scaling, for which the curve
+ *       velocity limit sqrt(a_max / curvature_max) is below the requested velocity.
+ *
+ * Expected Results:
+ *    1. Trajectory generation is successful, the translational velocity never exceeds
+ *       the curve velocity limit.
+ */
+TEST_P(TrajectoryGeneratorSPLINETest, curvatureReducesVelocity)
+{
+  planning_interface::MotionPlanRequest req {createSplineRequest()};
+  req.max_velocity_scaling_factor = 1.0;
+  req.max_acceleration_scaling_factor = 0.2;
+
+  const CartesianLimit& cartesian_limits {planner_limits_.getCartesianLimits()};
+  const CartesianPathSpline path(getPathPoses(req),
+                                 cartesian_limits.getMaxTranslationalVelocity()
+                                 / cartesian_limits.getMaxRotationalVelocity(),
+                                 MIN_WAYPOINT_DISTANCE);
+  ASSERT_GT(path.getMaxCurvature(), 0.);
+  const double curve_velocity {std::sqrt(req.max_acceleration_scaling_factor
+                                         * cartesian_limits.getMaxTranslationalAcceleration()
+                                         / path.getMaxCurvature())};
+  ASSERT_LT(curve_velocity, req.max_velocity_scaling_factor * cartesian_limits.getMaxTranslationalVelocity());
+
+  planning_interface::MotionPlanResponse res;
+  ASSERT_TRUE(spline_->generate(req, res));
+  EXPECT_EQ(res.error_code_.val, moveit_msgs::MoveItErrorCodes::SUCCESS);
+
+  // the distance of consecutive samples does not exceed the length of the path between them,
+  // therefore the estimated velocity is not larger than the velocity along the path
+  EXPECT_LE(getMaxTranslationalVelocity(req, *res.trajectory_), curve_velocity * (1. + other_tolerance_));
+}
+
+/**
+ * @brief Checks that the trajectory is slowed down uniformly, if the joint trajectory
+ * of the Cartesian velocity profile violates the joint limits.
+ *
+ * Test Sequence:
+ *    1. Generate spline trajectory with the joint limits.
+ *    2. Generate the same trajectory with a generator whose joint velocity/acceleration/deceleration
+ *       limits are reduced to a fiftieth (the Cartesian limits are unchanged).
+ *
+ * Expected Results:
+ *    1. Trajectory generation is successful.
+ *    2. Trajectory generation is successful, the trajectory respects the reduced joint limits
+ *       and takes longer than the first trajectory.
+ */
+TEST_P(TrajectoryGeneratorSPLINETest, jointLimitsViolationSlowsDown)
+{
+  planning_interface::MotionPlanRequest req {createSplineRequest()};
+
+  planning_interface::MotionPlanResponse res;
+  ASSERT_TRUE(spline_->generate(req, res));
+  EXPECT_EQ(res.error_code_.val, moveit_msgs::MoveItErrorCodes::SUCCESS);
+
+  JointLimitsContainer reduced_joint_limits;
+  for(const auto& limit : planner_limits_.getJointLimitContainer())
+  {
+    pilz_extensions::JointLimit reduced_limit {limit.second};
+    reduced_limit.max_velocity *= 0.02;
+    reduced_limit.max_acceleration *= 0.02;
+    reduced_limit.max_deceleration *= 0.02;
+    reduced_joint_limits.addLimit(limit.first, reduced_limit);
+  }
+  LimitsContainer reduced_limits;
+  reduced_limits.setJointLimits(reduced_joint_limits);
+  reduced_limits.setCartesianLimits(planner_limits_.getCartesianLimits());
+  TrajectoryGeneratorSPLINE slow_spline(robot_model_, reduced_limits);
+
+  planning_interface::MotionPlanResponse slow_res;
+  ASSERT_TRUE(slow_spline.generate(req, slow_res));
+  EXPECT_EQ(slow_res.error_code_.val, moveit_msgs::MoveItErrorCodes::SUCCESS);
+
+  moveit_msgs::MotionPlanResponse slow_res_msg;
+  slow_res.getMessage(slow_res_msg);
+  EXPECT_TRUE(testutils::checkJointTrajectory(slow_res_msg.trajectory.joint_trajectory, reduced_joint_limits));
+  EXPECT_TRUE(testutils::isGoalReached(robot_model_, slow_res_msg.trajectory.joint_trajectory, req,
+                                       pose_norm_tolerance_));
+  EXPECT_GT(slow_res.trajectory_->getDuration(), 2. * res.trajectory_->getDuration());
+}
+
+int main(int argc, char **argv)
+{
+  ros::init(argc, argv, "unittest_trajectory_generator_spline");
+  ros::NodeHandle nh;
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
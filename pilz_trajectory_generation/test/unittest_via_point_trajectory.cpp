@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2018 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <moveit/robot_model_loader/robot_model_loader.h>
+#include <moveit/robot_model/robot_model.h>
+#include <moveit/robot_state/robot_state.h>
+#include <moveit/robot_trajectory/robot_trajectory.h>
+
+#include "pilz_trajectory_generation/via_point_trajectory.h"
+#include "test_utils.h"
+
+// parameters from parameter server
+const std::string PARAM_PLANNING_GROUP_NAME("planning_group");
+const std::string PARAM_TARGET_LINK_NAME("target_link");
+
+static constexpr double SAMPLING_TIME {0.01};
+static constexpr double MAX_VELOCITY {1.};
+static constexpr double MAX_ACCELERATION {0.5};
+static constexpr double EPSILON {1.0e-6};
+
+using namespace pilz;
+
+class ViaPointTrajectoryTest : public testing::Test
+{
+protected:
+  void SetUp() override;
+
+  //! @return A state of the planning group with all joints at the specified position.
+  robot_state::RobotStateConstPtr createState(const double position) const;
+
+  //! Checks start, goal and limits of the specified trajectory.
+  void checkTrajectory(const robot_trajectory::RobotTrajectory& trajectory,
+                       const std::vector<robot_state::RobotStateConstPtr>& waypoints,
+                       const double max_velocity,
+                       const double max_acceleration) const;
+
+protected:
+  ros::NodeHandle ph_ {"~"};
+  robot_model::RobotModelConstPtr robot_model_ {
+    robot_model_loader::RobotModelLoader("robot_description").getModel()};
+
+  std::string planning_group_, target_link_;
+  JointLimitsContainer joint_limits_;
+};
+
+void ViaPointTrajectoryTest::SetUp()
+{
+  ASSERT_TRUE(ph_.getParam(PARAM_PLANNING_GROUP_NAME, planning_group_));
+  ASSERT_TRUE(ph_.getParam(PARAM_TARGET_LINK_NAME, target_link_));
+
+  testutils::checkRobotModel(robot_model_, planning_group_, target_link_);
+
+  pilz_extensions::joint_limits_interface::JointLimits joint_limit;
+  joint_limit.has_velocity_limits = true;
+  joint_limit.max_velocity = MAX_VELOCITY;
+  joint_limit.has_acceleration_limits = true;
+  joint_limit.max_acceleration = MAX_ACCELERATION;
+  joint_limit.has_deceleration_limits = true;
+  joint_limit.max_deceleration = -MAX_ACCELERATION;
+  for(const auto& joint_name : robot_model_->getJointModelGroup(planning_group_)->getActiveJointModelNames())
+  {
+    ASSERT_TRUE(joint_limits_.addLimit(joint_name, joint_limit));
+  }
+}
+
+robot_state::RobotStateConstPtr ViaPointTrajectoryTest::createState(const double position) const
+{
+  robot_state::RobotStatePtr state {new robot_state::RobotState(robot_model_)};
+  state->setToDefaultValues();
+  const moveit::core::JointModelGroup* group {robot_model_->getJointModelGroup(planning_group_)};
+  state->setJointGroupPositions(group, std::vector<double>(group->getActiveJointModels().size(), position));
+  state->update();
+  return state;
+}
+
+void ViaPointTrajectoryTest::checkTrajectory(const robot_trajectory::RobotTrajectory& trajectory,
+                                             const std::vector<robot_state::RobotStateConstPtr>& waypoints,
+                                             const double max_velocity,
+                                             const double max_acceleration) const
+{
+  ASSERT_GT(trajectory.getWayPointCount(), 2u);
+  const moveit::core::JointModelGroup* group {robot_model_->getJointModelGroup(planning_group_)};
+
+  std::vector<double> expected, actual;
+  waypoints.front()->copyJointGroupPositions(group, expected);
+  trajectory.getFirstWayPoint().copyJointGroupPositions(group, actual);
+  for(std::size_t j = 0; j < expected.size(); ++j)
+  {
+    EXPECT_NEAR(expected.at(j), actual.at(j), EPSILON);
+  }
+  waypoints.back()->copyJointGroupPositions(group, expected);
+  trajectory.getLastWayPoint().copyJointGroupPositions(group, actual);
+  for(std::size_t j = 0; j < expected.size(); ++j)
+  {
+    EXPECT_NEAR(expected.at(j), actual.at(j), EPSILON);
+  }
+
+  for(std::size_t i = 0; i < trajectory.getWayPointCount(); ++i)
+  {
+    const robot_state::RobotState& state {trajectory.getWayPoint(i)};
+    for(const auto& joint_name : group->getActiveJointModelNames())
+    {
+      EXPECT_LE(std::fabs(state.getVariableVelocity(joint_name)), max_velocity + EPSILON) << "Waypoint " << i;
+      EXPECT_LE(std::fabs(state.getVariableAcceleration(joint_name)), max_acceleration + EPSILON) << "Waypoint " << i;
+    }
+  }
+}
+
+/**
+ * @brief Checks that the trajectory passes the via point without stopping and
+ * respects the limits.
+ */
+TEST_F(ViaPointTrajectoryTest, testNoStopAtViaPoint)
+{
+  const std::vector<robot_state::RobotStateConstPtr> waypoints {createState(0.), createState(0.5), createState(1.)};
+  robot_trajectory::RobotTrajectory trajectory(robot_model_, planning_group_);
+  ASSERT_TRUE(generateViaPointTrajectory(joint_limits_, planning_group_, waypoints,
+                                         std::vector<ViaPointScaling>(2), SAMPLING_TIME, trajectory));
+  checkTrajectory(trajectory, waypoints, MAX_VELOCITY, MAX_ACCELERATION);
+
+  const std::string& joint_name {robot_model_->getJointModelGroup(planning_group_)->getActiveJointModelNames().front()};
+  for(std::size_t i = 1; i + 1 < trajectory.getWayPointCount(); ++i)
+  {
+    EXPECT_GT(trajectory.getWayPoint(i).getVariableVelocity(joint_name), 0.) << "Robot stops at waypoint " << i;
+  }
+  EXPECT_DOUBLE_EQ(0., trajectory.getFirstWayPoint().getVariableVelocity(joint_name));
+  EXPECT_DOUBLE_EQ(0., trajectory.getLastWayPoint().getVariableVelocity(joint_name));
+}
+
+/**
+ * @brief Checks that the acceleration is zero at start, goal and via point and has no jumps,
+ * so that it stays within the limits between the samples.
+ */
+TEST_F(ViaPointTrajectoryTest, testAccelerationContinuity)
+{
+  const std::vector<robot_state::RobotStateConstPtr> waypoints {createState(0.), createState(0.5), createState(1.)};
+  robot_trajectory::RobotTrajectory trajectory(robot_model_, planning_group_);
+  ASSERT_TRUE(generateViaPointTrajectory(joint_limits_, planning_group_, waypoints,
+                                         std::vector<ViaPointScaling>(2), SAMPLING_TIME, trajectory));
+  checkTrajectory(trajectory, waypoints, MAX_VELOCITY, MAX_ACCELERATION);
+
+  // Change of the acceleration between two samples which is only reached by a continuous acceleration
+  const double max_acceleration_step {0.1 * MAX_ACCELERATION};
+  const std::string& joint_name {robot_model_->getJointModelGroup(planning_group_)->getActiveJointModelNames().front()};
+
+  EXPECT_DOUBLE_EQ(0., trajectory.getFirstWayPoint().getVariableAcceleration(joint_name));
+  EXPECT_DOUBLE_EQ(0., trajectory.getLastWayPoint().getVariableAcceleration(joint_name));
+
+  std::size_t via_point_index {0};
+  for(std::size_t i = 1; i < trajectory.getWayPointCount(); ++i)
+  {
+    EXPECT_LE(std::fabs(trajectory.getWayPoint(i).getVariableAcceleration(joint_name)
+                        - trajectory.getWayPoint(i-1).getVariableAcceleration(joint_name)), max_acceleration_step)
+        << "Acceleration jumps at waypoint " << i;
+
+    if(std::fabs(trajectory.getWayPoint(i).getVariablePosition(joint_name) - 0.5)
+       < std::fabs(trajectory.getWayPoint(via_point_index).getVariablePosition(joint_name) - 0.5))
+    {
+      via_point_index = i;
+    }
+  }
+  EXPECT_LE(std::fabs(trajectory.getWayPoint(via_point_index).getVariableAcceleration(joint_name)),
+            max_acceleration_step) << "Acceleration at the via point is not zero";
+}
+
+/**
+ * @brief Checks that the trajectory stays within the scaled limits and takes longer
+ * than the unscaled trajectory.
+ */
+TEST_F(ViaPointTrajectoryTest, testScaling)
+{
+  const std::vector<robot_state::RobotStateConstPtr> waypoints {createState(0.), createState(0.5), createState(0.2)};
+  robot_trajectory::RobotTrajectory trajectory(robot_model_, planning_group_);
+  ASSERT_TRUE(generateViaPointTrajectory(joint_limits_, planning_group_, waypoints,
+                                         std::vector<ViaPointScaling>(2), SAMPLING_TIME, trajectory));
+  checkTrajectory(trajectory, waypoints, MAX_VELOCITY, MAX_ACCELERATION);
+
+  const ViaPointScaling scaling {0.5, 0.5};
+  robot_trajectory::RobotTrajectory scaled_trajectory(robot_model_, planning_group_);
+  ASSERT_TRUE(generateViaPointTrajectory(joint_limits_, planning_group_, waypoints,
+                                         std::vector<ViaPointScaling>(2, scaling), SAMPLING_TIME, scaled_trajectory));
+  checkTrajectory(scaled_trajectory, waypoints, scaling.velocity * MAX_VELOCITY,
+                  scaling.acceleration * MAX_ACCELERATION);
+
+  EXPECT_GT(scaled_trajectory.getWayPointDurationFromStart(scaled_trajectory.getWayPointCount() - 1),
+            trajectory.getWayPointDurationFromStart(trajectory.getWayPointCount() - 1));
+}
+
+/**
+ * @brief Checks that invalid input is rejected.
+ */
+TEST_F(ViaPointTrajectoryTest, testInvalidInput)
+{
+  const std::vector<robot_state::RobotStateConstPtr> waypoints {createState(0.), createState(0.5)};
+  robot_trajectory::RobotTrajectory trajectory(robot_model_, planning_group_);
+
+  EXPECT_FALSE(generateViaPointTrajectory(joint_limits_, planning_group_, {waypoints.front()},
+                                          {}, SAMPLING_TIME, trajectory));
+  EXPECT_FALSE(generateViaPointTrajectory(joint_limits_, planning_group_, waypoints,
+                                          std::vector<ViaPointScaling>(2), SAMPLING_TIME, trajectory));
+  EXPECT_FALSE(generateViaPointTrajectory(joint_limits_, planning_group_, waypoints,
+                                          std::vector<ViaPointScaling>(1), 0., trajectory));
+  EXPECT_FALSE(generateViaPointTrajectory(JointLimitsContainer(), planning_group_, waypoints,
+                                          std::vector<ViaPointScaling>(1), SAMPLING_TIME, trajectory));
+  EXPECT_TRUE(trajectory.empty());
+}
+
+int main(int argc, char **argv)
+{
+  ros::init(argc, argv, "unittest_via_point_trajectory");
+  ros::NodeHandle nh;
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}